@@ -0,0 +1,734 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "HandcrankEngine/HandcrankEngine.hpp"
+#include "HandcrankEngine/ParticleEmitter.hpp"
+#include "HandcrankEngine/RectRenderObject.hpp"
+#include "HandcrankEngine/SpriteRenderObject.hpp"
+#include "HandcrankEngine/TextRenderObject.hpp"
+
+#include "../fonts/JustMyType/JustMyType.h"
+
+using namespace HandcrankEngine;
+
+const int DEFAULT_BENCH_FRAMES = 600;
+const int DEFAULT_BENCH_WARMUP_FRAMES = 60;
+const double BENCH_DELTA_TIME = 1 / DEFAULT_FRAME_RATE;
+const unsigned int BENCH_SEED = 1234;
+
+const Uint32 BENCH_BALL_COLLISION_LAYER = 0x01;
+
+const float BENCH_BALL_SIZE = 8;
+const float BENCH_BALL_SPEED = 200;
+
+const int BENCH_GROUP_SIZE = 10;
+
+const int BENCH_Z_CHANGES_PER_FRAME = 16;
+
+const int BENCH_SPARK_LIFETIME = 30;
+
+const int BENCH_SPAWN_READ_GROUPS = 8;
+const float BENCH_SPAWN_READ_RANGE = 100;
+
+const int BENCH_SPRITE_FRAME_SIZE = 16;
+const int BENCH_SPRITE_FRAME_COUNT = 4;
+
+const char *const BENCH_SPRITE_SHEET =
+    "<svg xmlns='http://www.w3.org/2000/svg' width='64' height='16'>"
+    "<rect x='0' width='16' height='16' fill='#f00'/>"
+    "<rect x='16' width='16' height='16' fill='#0f0'/>"
+    "<rect x='32' width='16' height='16' fill='#00f'/>"
+    "<rect x='48' width='16' height='16' fill='#fff'/>"
+    "</svg>";
+
+auto Random() -> std::mt19937 &
+{
+    static std::mt19937 generator(BENCH_SEED);
+
+    return generator;
+}
+
+auto RandomFloat(float min, float max) -> float
+{
+    return std::uniform_real_distribution<float>(min, max)(Random());
+}
+
+auto RandomPosition(Game &game) -> Vector2
+{
+    return Vector2(RandomFloat(0, (float)game.GetWidth() - BENCH_BALL_SIZE),
+                   RandomFloat(0, (float)game.GetHeight() - BENCH_BALL_SIZE));
+}
+
+class BenchBall : public RectRenderObject
+{
+  private:
+    Vector2 velocity;
+
+  public:
+    using RectRenderObject::RectRenderObject;
+
+    void Start() override
+    {
+        SetFillColor(MAX_R, MAX_G, MAX_B, MAX_ALPHA);
+
+        SetDimension(BENCH_BALL_SIZE, BENCH_BALL_SIZE);
+
+        velocity = Vector2(RandomFloat(-1, 1), RandomFloat(-1, 1)) *
+                   BENCH_BALL_SPEED;
+
+        EnableCollider(BENCH_BALL_COLLISION_LAYER, BENCH_BALL_COLLISION_LAYER);
+    }
+
+    void FixedUpdate(double deltaTime) override
+    {
+        auto rect = GetRect();
+
+        auto x = rect.x + (velocity.x * (float)deltaTime);
+        auto y = rect.y + (velocity.y * (float)deltaTime);
+
+        const auto maxX = (float)game->GetWidth() - rect.w;
+        const auto maxY = (float)game->GetHeight() - rect.h;
+
+        if (x < 0 || x > maxX)
+        {
+            velocity = Vector2(-velocity.x, velocity.y);
+        }
+
+        if (y < 0 || y > maxY)
+        {
+            velocity = Vector2(velocity.x, -velocity.y);
+        }
+
+        SetPosition(std::clamp(x, 0.0F, maxX), std::clamp(y, 0.0F, maxY));
+    }
+
+    void OnCollisionEnter(const std::shared_ptr<RenderObject> &other) override
+    {
+        velocity = velocity * -1;
+    }
+};
+
+class BenchNode : public RenderObject
+{
+  private:
+    float angle = 0;
+
+  public:
+    using RenderObject::RenderObject;
+
+    void Update(double deltaTime) override
+    {
+        angle += (float)deltaTime;
+
+        auto rect = GetRect();
+
+        SetPosition(rect.x + std::cos(angle), rect.y + std::sin(angle));
+    }
+};
+
+class BenchZShuffler : public RenderObject
+{
+  public:
+    std::vector<std::shared_ptr<RectRenderObject>> rects;
+
+    void Update(double deltaTime) override
+    {
+        if (rects.empty())
+        {
+            return;
+        }
+
+        std::uniform_int_distribution<size_t> index(0, rects.size() - 1);
+        std::uniform_int_distribution<int> z(-100, 100);
+
+        for (auto i = 0; i < BENCH_Z_CHANGES_PER_FRAME; i += 1)
+        {
+            rects[index(Random())]->SetZ(z(Random()));
+        }
+    }
+};
+
+class BenchCounterText : public TextRenderObject
+{
+  private:
+    int counter = 0;
+
+  public:
+    using TextRenderObject::TextRenderObject;
+
+    void Update(double deltaTime) override
+    {
+        counter += 1;
+
+        SetText(std::to_string(counter));
+    }
+};
+
+class BenchCacheLoader : public RenderObject
+{
+  public:
+    int loadsPerFrame = 0;
+
+    void Update(double deltaTime) override
+    {
+        const auto length = static_cast<int>(std::strlen(BENCH_SPRITE_SHEET));
+
+        for (auto i = 0; i < loadsPerFrame; i += 1)
+        {
+            auto texture = LoadCachedTexture(game->GetRenderer(),
+                                             BENCH_SPRITE_SHEET, length);
+
+            auto font = LoadCachedFont(fonts_JustMyType_JustMyType_ttf,
+                                       fonts_JustMyType_JustMyType_ttf_len);
+        }
+    }
+};
+
+class BenchSpark : public RectRenderObject
+{
+  private:
+    int framesLeft = BENCH_SPARK_LIFETIME;
+
+  public:
+    void Update(double deltaTime) override
+    {
+        framesLeft -= 1;
+
+        if (framesLeft <= 0)
+        {
+            Destroy();
+        }
+    }
+
+    void OnRecycle() override
+    {
+        RectRenderObject::OnRecycle();
+
+        framesLeft = BENCH_SPARK_LIFETIME;
+    }
+};
+
+class BenchSpawner : public RenderObject
+{
+  public:
+    int spawnsPerFrame = 0;
+
+    void Update(double deltaTime) override
+    {
+        for (auto i = 0; i < spawnsPerFrame; i += 1)
+        {
+            auto spark = game->Spawn<BenchSpark>();
+
+            spark->SetRect(RandomFloat(0, (float)game->GetWidth()),
+                           RandomFloat(0, (float)game->GetHeight()),
+                           BENCH_BALL_SIZE, BENCH_BALL_SIZE);
+
+            game->AddChildObject(spark);
+        }
+    }
+};
+
+int benchTransformErrors = 0;
+
+/**
+ * Spawns into groups and reads the transforms back after every spawn, which
+ * shouldn't lay the scene graph out again each time. Each read is checked
+ * against the rects it was set from.
+ */
+class BenchSpawnReader : public RenderObject
+{
+  public:
+    std::vector<std::shared_ptr<RenderObject>> groups;
+
+    int spawnsPerFrame = 0;
+
+    void Update(double deltaTime) override
+    {
+        for (auto i = 0; i < spawnsPerFrame; i += 1)
+        {
+            const auto &group = groups[static_cast<size_t>(i) % groups.size()];
+
+            auto spark = game->Spawn<BenchSpark>();
+
+            spark->SetRect(RandomFloat(0, BENCH_SPAWN_READ_RANGE),
+                           RandomFloat(0, BENCH_SPAWN_READ_RANGE),
+                           BENCH_BALL_SIZE, BENCH_BALL_SIZE);
+
+            group->AddChildObject(spark);
+
+            const auto &groupRect = group->GetTransformedRect();
+            const auto &localRect = spark->GetRect();
+            const auto &sparkRect = spark->GetTransformedRect();
+            const auto &bounds = group->GetBoundingBox();
+
+            const auto isPlaced = sparkRect.x == groupRect.x + localRect.x &&
+                                  sparkRect.y == groupRect.y + localRect.y;
+
+            const auto isInBounds =
+                sparkRect.x >= bounds.x && sparkRect.y >= bounds.y &&
+                sparkRect.x + sparkRect.w <= bounds.x + bounds.w &&
+                sparkRect.y + sparkRect.h <= bounds.y + bounds.h;
+
+            if (!isPlaced || !isInBounds)
+            {
+                benchTransformErrors += 1;
+            }
+        }
+    }
+};
+
+struct BenchScenario
+{
+    std::string name;
+    std::string description;
+    GameMode mode;
+    int defaultCount;
+    std::function<void(Game &, int)> setup;
+};
+
+struct BenchResult
+{
+    std::string name;
+    GameMode mode;
+    int count;
+    int frames;
+    double totalTime;
+    std::vector<double> frameTimes;
+};
+
+auto CreateScenarios() -> std::vector<BenchScenario>
+{
+    std::vector<BenchScenario> scenarios;
+
+    scenarios.push_back(
+        {"collision", "Moving colliders that bounce off each other",
+         GameMode::HEADLESS, 1000, [](Game &game, int count)
+         {
+             for (auto i = 0; i < count; i += 1)
+             {
+                 auto ball = std::make_shared<BenchBall>();
+
+                 ball->SetPosition(RandomPosition(game));
+
+                 game.AddChildObject(ball);
+             }
+         }});
+
+    scenarios.push_back(
+        {"scene-graph", "Nested objects updating their transforms",
+         GameMode::HEADLESS, 5000, [](Game &game, int count)
+         {
+             std::shared_ptr<BenchNode> group;
+
+             for (auto i = 0; i < count; i += 1)
+             {
+                 auto node = std::make_shared<BenchNode>();
+
+                 node->SetPosition(RandomPosition(game));
+
+                 if (i % BENCH_GROUP_SIZE == 0)
+                 {
+                     group = node;
+
+                     game.AddChildObject(node);
+                 }
+                 else
+                 {
+                     group->AddChildObject(node);
+                 }
+             }
+         }});
+
+    scenarios.push_back(
+        {"render", "Rects drawn in z order while their z changes",
+         GameMode::OFFSCREEN, 2000, [](Game &game, int count)
+         {
+             auto shuffler = std::make_shared<BenchZShuffler>();
+
+             for (auto i = 0; i < count; i += 1)
+             {
+                 auto rect = std::make_shared<RectRenderObject>();
+
+                 rect->SetRect(RandomFloat(0, (float)game.GetWidth()),
+                               RandomFloat(0, (float)game.GetHeight()),
+                               BENCH_BALL_SIZE, BENCH_BALL_SIZE);
+                 rect->SetFillColor(MAX_R, 0, 0, MAX_ALPHA);
+
+                 shuffler->rects.emplace_back(rect);
+
+                 game.AddChildObject(rect);
+             }
+
+             game.AddChildObject(shuffler);
+         }});
+
+    scenarios.push_back(
+        {"text", "Text objects changing their text every frame",
+         GameMode::OFFSCREEN, 200, [](Game &game, int count)
+         {
+             for (auto i = 0; i < count; i += 1)
+             {
+                 auto text = std::make_shared<BenchCounterText>();
+
+                 text->LoadFontRW(fonts_JustMyType_JustMyType_ttf,
+                                  fonts_JustMyType_JustMyType_ttf_len);
+                 text->SetPosition(RandomPosition(game));
+
+                 game.AddChildObject(text);
+             }
+         }});
+
+    scenarios.push_back(
+        {"sprites", "Animated sprites sharing one sprite sheet",
+         GameMode::OFFSCREEN, 2000, [](Game &game, int count)
+         {
+             for (auto i = 0; i < count; i += 1)
+             {
+                 auto sprite = std::make_shared<SpriteRenderObject>();
+
+                 sprite->LoadSVGString(game.GetRenderer(), BENCH_SPRITE_SHEET);
+
+                 for (auto j = 0; j < BENCH_SPRITE_FRAME_COUNT; j += 1)
+                 {
+                     sprite->AddFrame(SDL_Rect{j * BENCH_SPRITE_FRAME_SIZE, 0,
+                                               BENCH_SPRITE_FRAME_SIZE,
+                                               BENCH_SPRITE_FRAME_SIZE});
+                 }
+
+                 sprite->SetPosition(RandomPosition(game));
+                 sprite->Play();
+
+                 game.AddChildObject(sprite);
+             }
+         }});
+
+    scenarios.push_back(
+        {"cache", "Cached texture and font loads from memory",
+         GameMode::OFFSCREEN, 500, [](Game &game, int count)
+         {
+             auto loader = std::make_shared<BenchCacheLoader>();
+
+             loader->loadsPerFrame = count;
+
+             game.AddChildObject(loader);
+         }});
+
+    scenarios.push_back(
+        {"particles", "One particle emitter holding a steady particle count",
+         GameMode::OFFSCREEN, 10000, [](Game &game, int count)
+         {
+             auto emitter = std::make_shared<ParticleEmitter>();
+
+             emitter->SetRect(0, 0, (float)game.GetWidth(),
+                              (float)game.GetHeight());
+             emitter->SetMaxParticles(static_cast<size_t>(count));
+             emitter->SetEmissionRate((float)count);
+             emitter->SetLifetime(1, 1);
+             emitter->SetSpeed(10, BENCH_BALL_SPEED);
+             emitter->SetGravity(Vector2(0, BENCH_BALL_SPEED));
+
+             game.AddChildObject(emitter);
+         }});
+
+    scenarios.push_back(
+        {"layer", "A static panel of rects drawn from a cached layer",
+         GameMode::OFFSCREEN, 2000, [](Game &game, int count)
+         {
+             auto panel = std::make_shared<RenderObject>();
+
+             panel->SetRect(0, 0, (float)game.GetWidth(),
+                            (float)game.GetHeight());
+             panel->EnableRenderCache();
+
+             for (auto i = 0; i < count; i += 1)
+             {
+                 auto rect = std::make_shared<RectRenderObject>();
+
+                 rect->SetRect(RandomFloat(0, (float)game.GetWidth()),
+                               RandomFloat(0, (float)game.GetHeight()),
+                               BENCH_BALL_SIZE, BENCH_BALL_SIZE);
+                 rect->SetFillColor(0, 0, MAX_B, MAX_ALPHA);
+
+                 panel->AddChildObject(rect);
+             }
+
+             game.AddChildObject(panel);
+         }});
+
+    scenarios.push_back(
+        {"spawn", "Short-lived objects spawned from a pool every frame",
+         GameMode::HEADLESS, 100, [](Game &game, int count)
+         {
+             game.GetObjectPool<BenchSpark>().Reserve(
+                 static_cast<size_t>(count * (BENCH_SPARK_LIFETIME + 1)));
+
+             auto spawner = std::make_shared<BenchSpawner>();
+
+             spawner->spawnsPerFrame = count;
+
+             game.AddChildObject(spawner);
+         }});
+
+    scenarios.push_back(
+        {"spawn-reads", "Objects spawned into groups, read back after each",
+         GameMode::HEADLESS, 100, [](Game &game, int count)
+         {
+             game.GetObjectPool<BenchSpark>().Reserve(
+                 static_cast<size_t>(count * (BENCH_SPARK_LIFETIME + 1)));
+
+             auto reader = std::make_shared<BenchSpawnReader>();
+
+             for (auto i = 0; i < BENCH_SPAWN_READ_GROUPS; i += 1)
+             {
+                 auto group = std::make_shared<RenderObject>();
+
+                 group->SetPosition(RandomPosition(game));
+
+                 reader->groups.emplace_back(group);
+
+                 game.AddChildObject(group);
+             }
+
+             reader->spawnsPerFrame = count;
+
+             game.AddChildObject(reader);
+         }});
+
+    return scenarios;
+}
+
+auto RunScenario(const BenchScenario &scenario, int count, int frames,
+                 int warmupFrames) -> BenchResult
+{
+    Game game(scenario.mode);
+
+    scenario.setup(game, count);
+
+    for (auto i = 0; i < warmupFrames; i += 1)
+    {
+        game.Step(BENCH_DELTA_TIME);
+    }
+
+    BenchResult result{scenario.name, scenario.mode, count, frames, 0, {}};
+
+    result.frameTimes.reserve(frames);
+
+    const auto frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+
+    for (auto i = 0; i < frames; i += 1)
+    {
+        const auto start = SDL_GetPerformanceCounter();
+
+        game.Step(BENCH_DELTA_TIME);
+
+        const auto frameTime =
+            static_cast<double>(SDL_GetPerformanceCounter() - start) /
+            frequency;
+
+        result.frameTimes.emplace_back(frameTime);
+
+        result.totalTime += frameTime;
+    }
+
+    return result;
+}
+
+auto Percentile(const std::vector<double> &sorted, double percentile)
+    -> double
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+
+    const auto rank = static_cast<size_t>(
+        std::ceil(percentile / 100 * static_cast<double>(sorted.size())));
+
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+auto GameModeName(GameMode mode) -> const char *
+{
+    switch (mode)
+    {
+    case GameMode::WINDOWED:
+        return "windowed";
+    case GameMode::OFFSCREEN:
+        return "offscreen";
+    case GameMode::HEADLESS:
+        return "headless";
+    }
+
+    return "";
+}
+
+void WriteResults(FILE *output, const std::vector<BenchResult> &results,
+                  int warmupFrames)
+{
+    std::fprintf(output, "{\n  \"deltaTime\": %.6f,\n", BENCH_DELTA_TIME);
+    std::fprintf(output, "  \"warmupFrames\": %d,\n", warmupFrames);
+    std::fprintf(output, "  \"scenarios\": [\n");
+
+    for (size_t i = 0; i < results.size(); i += 1)
+    {
+        const auto &result = results[i];
+
+        auto sorted = result.frameTimes;
+
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto milliseconds = [](double seconds)
+        { return seconds * MILLISECONDS; };
+
+        const auto mean =
+            result.frames > 0 ? result.totalTime / result.frames : 0;
+
+        const auto framesPerSecond =
+            result.totalTime > 0 ? result.frames / result.totalTime : 0;
+
+        std::fprintf(output, "    {\n");
+        std::fprintf(output, "      \"name\": \"%s\",\n", result.name.c_str());
+        std::fprintf(output, "      \"mode\": \"%s\",\n",
+                     GameModeName(result.mode));
+        std::fprintf(output, "      \"count\": %d,\n", result.count);
+        std::fprintf(output, "      \"frames\": %d,\n", result.frames);
+        std::fprintf(output, "      \"frameTimeMs\": {\n");
+        std::fprintf(output, "        \"mean\": %.4f,\n", milliseconds(mean));
+        std::fprintf(output, "        \"min\": %.4f,\n",
+                     milliseconds(sorted.empty() ? 0 : sorted.front()));
+        std::fprintf(output, "        \"p50\": %.4f,\n",
+                     milliseconds(Percentile(sorted, 50)));
+        std::fprintf(output, "        \"p95\": %.4f,\n",
+                     milliseconds(Percentile(sorted, 95)));
+        std::fprintf(output, "        \"p99\": %.4f,\n",
+                     milliseconds(Percentile(sorted, 99)));
+        std::fprintf(output, "        \"max\": %.4f\n",
+                     milliseconds(sorted.empty() ? 0 : sorted.back()));
+        std::fprintf(output, "      },\n");
+        std::fprintf(output, "      \"framesPerSecond\": %.2f,\n",
+                     framesPerSecond);
+        std::fprintf(output, "      \"objectsPerSecond\": %.2f\n",
+                     framesPerSecond * result.count);
+        std::fprintf(output, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    std::fprintf(output, "  ]\n}\n");
+}
+
+void PrintUsage(const std::vector<BenchScenario> &scenarios)
+{
+    std::fprintf(stderr,
+                 "Usage: pong-demo-bench [--scenario NAME]... [--count N] "
+                 "[--frames N] [--warmup N] [--output FILE]\n\nScenarios:\n");
+
+    for (const auto &scenario : scenarios)
+    {
+        std::fprintf(stderr, "  %-12s %s (%s, default count %d)\n",
+                     scenario.name.c_str(), scenario.description.c_str(),
+                     GameModeName(scenario.mode), scenario.defaultCount);
+    }
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    const auto scenarios = CreateScenarios();
+
+    std::vector<std::string> selected;
+
+    int count = 0;
+    int frames = DEFAULT_BENCH_FRAMES;
+    int warmupFrames = DEFAULT_BENCH_WARMUP_FRAMES;
+
+    const char *outputPath = nullptr;
+
+    for (auto i = 1; i < argc; i += 1)
+    {
+        const std::string arg = argv[i];
+
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == "--scenario" && hasValue)
+        {
+            selected.emplace_back(argv[++i]);
+        }
+        else if (arg == "--count" && hasValue)
+        {
+            count = std::atoi(argv[++i]);
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            frames = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (arg == "--warmup" && hasValue)
+        {
+            warmupFrames = std::max(std::atoi(argv[++i]), 0);
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            PrintUsage(scenarios);
+
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+
+    for (const auto &scenario : scenarios)
+    {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(),
+                                           scenario.name) == selected.end())
+        {
+            continue;
+        }
+
+        std::fprintf(stderr, "Running %s\n", scenario.name.c_str());
+
+        results.emplace_back(
+            RunScenario(scenario, count > 0 ? count : scenario.defaultCount,
+                        frames, warmupFrames));
+    }
+
+    if (results.empty())
+    {
+        PrintUsage(scenarios);
+
+        return 1;
+    }
+
+    auto *output = outputPath != nullptr ? std::fopen(outputPath, "w") : stdout;
+
+    if (output == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open %s\n", outputPath);
+
+        return 1;
+    }
+
+    WriteResults(output, results, warmupFrames);
+
+    if (output != stdout)
+    {
+        std::fclose(output);
+    }
+
+    if (benchTransformErrors > 0)
+    {
+        std::fprintf(stderr, "%d transforms read back wrong\n",
+                     benchTransformErrors);
+
+        return 1;
+    }
+
+    return 0;
+}
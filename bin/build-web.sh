@@ -8,10 +8,28 @@ SCRIPT_DIR=$(cd -- "$(dirname -- "${BASH_SOURCE[0]}")" &>/dev/null && pwd)
 
     mkdir -p build/web
 
-    emcc -std=c++17 -Os -o build/web/index.html src/*.cpp -Ifonts -Iimages -Iinclude -Isrc \
-        -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS='["png", "svg"]' -s USE_SDL_TTF=2 -s USE_SDL_MIXER=2 \
-        --shell-file templates/web-minimal.html
+    # Set WEB_THREADS=1 for a pthreads build. It has to be served with the
+    # Cross-Origin-Opener-Policy and Cross-Origin-Embedder-Policy headers.
+
+    THREAD_FLAGS=""
+
+    if [ "${WEB_THREADS}" = "1" ]; then
+        THREAD_FLAGS="-pthread -s PTHREAD_POOL_SIZE=4 -s ENVIRONMENT=web,worker"
+    else
+        THREAD_FLAGS="-s ENVIRONMENT=web"
+    fi
+
+    emcc -std=c++17 -O3 -flto -msimd128 -o build/web/index.html src/*.cpp -Ifonts -Iimages -Iinclude -Isrc \
+        -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS='["png", "svg"]' -s USE_SDL_TTF=2 -s USE_SDL_MIXER=2 -s FETCH=1 \
+        -s ALLOW_MEMORY_GROWTH=1 ${THREAD_FLAGS} \
+        --shell-file templates/web-minimal.html || exit
 
     gzip -k build/web/index.wasm
 
+    if [ -f build/assets.pack ]; then
+        cp build/assets.pack build/web/
+    fi
+
+    "${SCRIPT_DIR}/check-web-size.sh" build/web
+
 )
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Report the size of a web build against a budget, failing when over it.
+# Budgets are in KiB and can be overridden with WASM_BUDGET_KB and
+# DATA_BUDGET_KB.
+
+SCRIPT_DIR=$(cd -- "$(dirname -- "${BASH_SOURCE[0]}")" &>/dev/null && pwd)
+
+BUILD_DIR="${1:-${SCRIPT_DIR}/../build/web}"
+
+WASM_BUDGET_KB="${WASM_BUDGET_KB:-3072}"
+DATA_BUDGET_KB="${DATA_BUDGET_KB:-2048}"
+
+OVER_BUDGET=0
+
+check_size() {
+
+    local file="$1"
+    local budget_kb="$2"
+
+    if [ ! -f "${file}" ]; then
+        return
+    fi
+
+    local size_kb=$(($(wc -c <"${file}") / 1024))
+    local gzip_kb=$(($(gzip -c -9 "${file}" | wc -c) / 1024))
+
+    if [ "${size_kb}" -gt "${budget_kb}" ]; then
+        echo "$(basename "${file}"): ${size_kb} KiB (${gzip_kb} KiB gzipped), over the ${budget_kb} KiB budget"
+        OVER_BUDGET=1
+    else
+        echo "$(basename "${file}"): ${size_kb} KiB (${gzip_kb} KiB gzipped), budget ${budget_kb} KiB"
+    fi
+
+}
+
+for file in "${BUILD_DIR}"/*.wasm; do
+    check_size "${file}" "${WASM_BUDGET_KB}"
+done
+
+for file in "${BUILD_DIR}"/*.data "${BUILD_DIR}"/*.pack; do
+    check_size "${file}" "${DATA_BUDGET_KB}"
+done
+
+exit "${OVER_BUDGET}"
@@ -8,8 +8,30 @@ SCRIPT_DIR=$(cd -- "$(dirname -- "${BASH_SOURCE[0]}")" &>/dev/null && pwd)
 
     cd ..
 
+    if [ -d "images/sprites" ]; then
+
+        . "${SCRIPT_DIR}/find-sdl.sh"
+
+        mkdir -p build/
+
+        g++ -std=c++17 -O2 -o build/atlas-packer tools/atlas-packer/main.cpp \
+            -I"${SDL_INCLUDE_PATH}" -L"${SDL_PATH}/lib" \
+            -I"${SDL_IMAGE_INCLUDE_PATH}" -L"${SDL_IMAGE_PATH}/lib" \
+            -lSDL2 -lSDL2_image || exit
+
+        LD_LIBRARY_PATH="${SDL_PATH}/lib:${SDL_IMAGE_PATH}/lib" \
+            ./build/atlas-packer images/sprites images/atlas || exit
+
+    fi
+
+    mkdir -p build/
+
+    g++ -std=c++17 -O2 -o build/asset-packer tools/asset-packer/main.cpp || exit
+
+    ./build/asset-packer build/assets.pack fonts $([ -d "images" ] && echo images) || exit
+
     [ -d "fonts" ] && find fonts -type f -name "*.ttf" -exec sh -c 'echo "#pragma once\n" > "${0%.ttf}.h" && xxd -i "$0" >> "${0%.ttf}.h"' {} \;
-    [ -d "images" ] && find images -type f -name "*.png" -exec sh -c 'echo "#pragma once\n" > "${0%.png}.h" && xxd -i "$0" >> "${0%.png}.h"' {} \;
-    [ -d "images" ] && find images -type f -name "*.svg" -exec sh -c 'echo "#pragma once\n" > "${0%.svg}.h" && xxd -i "$0" >> "${0%.svg}.h"' {} \;
+    [ -d "images" ] && find images -type f -name "*.png" -not -path "images/sprites/*" -exec sh -c 'echo "#pragma once\n" > "${0%.png}.h" && xxd -i "$0" >> "${0%.png}.h"' {} \;
+    [ -d "images" ] && find images -type f -name "*.svg" -not -path "images/sprites/*" -exec sh -c 'echo "#pragma once\n" > "${0%.svg}.h" && xxd -i "$0" >> "${0%.svg}.h"' {} \;
 
 )
@@ -155,6 +155,13 @@ class Animator : public RenderObject
             return;
         }
 
+        // Animations can step through anything, so they keep the game awake.
+
+        if (currentState == State::RUNNING)
+        {
+            game->RequestFrame();
+        }
+
         if (mode == Mode::PARALLEL)
         {
             UpdateParallel(deltaTime);
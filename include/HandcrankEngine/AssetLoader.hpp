@@ -0,0 +1,757 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+
+#include "AudioCache.hpp"
+#include "FontCache.hpp"
+#include "TextureCache.hpp"
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define HANDCRANK_ENGINE_ASYNC_ASSETS 1
+#endif
+
+namespace HandcrankEngine
+{
+
+inline const int DEFAULT_ASSET_LOADER_WORKERS = 2;
+inline const double DEFAULT_ASSET_LOADER_FRAME_BUDGET = 0.004;
+
+enum class AssetType : uint8_t
+{
+    TEXTURE,
+    FONT,
+    SFX
+};
+
+enum class AssetState : uint8_t
+{
+    LOADING,
+    READY,
+    FAILED
+};
+
+/**
+ * Shared state of a single load. Workers only touch the decoded fields before
+ * handing the request back, everything else is main thread only.
+ */
+struct AssetRequest
+{
+    AssetType type;
+
+    std::string path;
+    std::string cacheKey;
+
+    int ptSize = DEFAULT_FONT_SIZE;
+
+    std::atomic<AssetState> state = AssetState::LOADING;
+
+    SDL_Surface *surface = nullptr;
+    Mix_Chunk *chunk = nullptr;
+
+    std::shared_ptr<void> bytes;
+    size_t bytesSize = 0;
+
+    std::shared_ptr<SDL_Texture> texture;
+    std::shared_ptr<TTF_Font> font;
+    std::shared_ptr<Mix_Chunk> sfx;
+
+    std::vector<std::function<void()>> onReady;
+};
+
+/**
+ * Resolves to the loaded asset once the loader has finished it.
+ */
+template <typename T>
+class AssetHandle
+{
+  private:
+    std::shared_ptr<AssetRequest> request;
+
+  public:
+    AssetHandle() = default;
+
+    explicit AssetHandle(std::shared_ptr<AssetRequest> request)
+        : request(std::move(request))
+    {
+    }
+
+    [[nodiscard]] auto IsReady() const -> bool
+    {
+        return request != nullptr && request->state == AssetState::READY;
+    }
+
+    [[nodiscard]] auto HasFailed() const -> bool
+    {
+        return request == nullptr || request->state == AssetState::FAILED;
+    }
+
+    /**
+     * The loaded asset, or nullptr while it is still loading or if it failed.
+     */
+    [[nodiscard]] auto Get() const -> std::shared_ptr<T>
+    {
+        if (!IsReady())
+        {
+            return nullptr;
+        }
+
+        if constexpr (std::is_same_v<T, SDL_Texture>)
+        {
+            return request->texture;
+        }
+        else if constexpr (std::is_same_v<T, TTF_Font>)
+        {
+            return request->font;
+        }
+        else
+        {
+            return request->sfx;
+        }
+    }
+
+    /**
+     * Call a function on the main thread once the asset is ready. Called
+     * right away if it already is. Not called if the load fails.
+     *
+     * @param callback Function receiving the loaded asset.
+     */
+    void
+    OnReady(const std::function<void(const std::shared_ptr<T> &)> &callback)
+    {
+        if (request == nullptr || request->state == AssetState::FAILED)
+        {
+            return;
+        }
+
+        if (IsReady())
+        {
+            callback(Get());
+
+            return;
+        }
+
+        request->onReady.emplace_back([handle = *this, callback]()
+                                      { callback(handle.Get()); });
+    }
+
+    [[nodiscard]] auto GetRequest() const
+        -> const std::shared_ptr<AssetRequest> &
+    {
+        return request;
+    }
+};
+
+/**
+ * List of assets a scene needs, loaded ahead of time by the scene manager.
+ */
+class AssetManifest
+{
+  private:
+    std::vector<std::string> textures;
+    std::vector<std::pair<std::string, int>> fonts;
+    std::vector<std::string> sfx;
+
+  public:
+    void AddTexture(const std::string &path) { textures.emplace_back(path); }
+
+    void AddFont(const std::string &path, int ptSize = DEFAULT_FONT_SIZE)
+    {
+        fonts.emplace_back(path, ptSize);
+    }
+
+    void AddSFX(const std::string &path) { sfx.emplace_back(path); }
+
+    [[nodiscard]] auto IsEmpty() const -> bool
+    {
+        return textures.empty() && fonts.empty() && sfx.empty();
+    }
+
+    [[nodiscard]] auto GetTextures() const -> const std::vector<std::string> &
+    {
+        return textures;
+    }
+
+    [[nodiscard]] auto GetFonts() const
+        -> const std::vector<std::pair<std::string, int>> &
+    {
+        return fonts;
+    }
+
+    [[nodiscard]] auto GetSFX() const -> const std::vector<std::string> &
+    {
+        return sfx;
+    }
+};
+
+/**
+ * Progress of every load started from a manifest.
+ */
+class AssetPreload
+{
+  private:
+    std::vector<std::shared_ptr<AssetRequest>> requests;
+
+  public:
+    void Add(const std::shared_ptr<AssetRequest> &request)
+    {
+        requests.emplace_back(request);
+    }
+
+    /**
+     * True once every asset has either loaded or failed.
+     */
+    [[nodiscard]] auto IsDone() const -> bool
+    {
+        return std::all_of(requests.begin(), requests.end(),
+                           [](const std::shared_ptr<AssetRequest> &request)
+                           { return request->state != AssetState::LOADING; });
+    }
+
+    /**
+     * Fraction of assets no longer loading, from 0 to 1.
+     */
+    [[nodiscard]] auto GetProgress() const -> float
+    {
+        if (requests.empty())
+        {
+            return 1;
+        }
+
+        const auto done = std::count_if(
+            requests.begin(), requests.end(),
+            [](const std::shared_ptr<AssetRequest> &request)
+            { return request->state != AssetState::LOADING; });
+
+        return static_cast<float>(done) / static_cast<float>(requests.size());
+    }
+};
+
+/**
+ * Decodes images, font files and sound effects on worker threads, then
+ * finishes them on the main thread where SDL requires it: textures are
+ * uploaded and fonts are opened there, within a time budget per frame.
+ * Finished assets go into the same caches as the synchronous loaders, so a
+ * later LoadCachedTexture of the same path is a cache hit. Without thread
+ * support, such as Emscripten builds without pthreads, loads run
+ * synchronously.
+ */
+class AssetLoader
+{
+  private:
+    int workerCount = DEFAULT_ASSET_LOADER_WORKERS;
+
+    double frameBudget = DEFAULT_ASSET_LOADER_FRAME_BUDGET;
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    std::deque<std::shared_ptr<AssetRequest>> pending;
+    std::deque<std::shared_ptr<AssetRequest>> decoded;
+
+    std::unordered_map<std::string, std::shared_ptr<AssetRequest>> inFlight;
+
+    bool stopping = false;
+
+    SDL_Renderer *renderer = nullptr;
+
+  public:
+    AssetLoader() = default;
+
+    AssetLoader(const AssetLoader &) = delete;
+    auto operator=(const AssetLoader &) -> AssetLoader & = delete;
+
+    ~AssetLoader() { Shutdown(); }
+
+    void SetRenderer(SDL_Renderer *renderer) { this->renderer = renderer; }
+
+    /**
+     * Number of worker threads, used the next time workers are started.
+     *
+     * @param workerCount Number of threads.
+     */
+    void SetWorkerCount(int workerCount)
+    {
+        this->workerCount = std::max(workerCount, 1);
+    }
+
+    /**
+     * Time the main thread may spend finishing assets each frame. At least
+     * one asset is finished per frame no matter the budget.
+     *
+     * @param frameBudget Time in seconds.
+     */
+    void SetFrameBudget(double frameBudget) { this->frameBudget = frameBudget; }
+
+    /**
+     * Load a texture from a path in the background.
+     *
+     * @param path File path to texture file.
+     */
+    auto LoadTexture(const std::string &path) -> AssetHandle<SDL_Texture>
+    {
+        const auto cacheKey =
+            TextureRendererKey(renderer) + ResourcePathKey(path.c_str());
+
+        if (renderer == nullptr)
+        {
+            auto request = CreateRequest(AssetType::TEXTURE, path, cacheKey);
+
+            request->state = AssetState::FAILED;
+
+            return AssetHandle<SDL_Texture>(request);
+        }
+
+        if (auto texture = GetTextureCache().Find(cacheKey))
+        {
+            auto request = CreateRequest(AssetType::TEXTURE, path, cacheKey);
+
+            request->texture = texture;
+            request->state = AssetState::READY;
+
+            return AssetHandle<SDL_Texture>(request);
+        }
+
+        return AssetHandle<SDL_Texture>(
+            Enqueue(AssetType::TEXTURE, path, cacheKey, DEFAULT_FONT_SIZE));
+    }
+
+    /**
+     * Load a font from a path in the background. The file is read on a
+     * worker thread and opened on the main thread.
+     *
+     * @param path File path to font file.
+     * @param ptSize The size of the font.
+     */
+    auto LoadFont(const std::string &path, int ptSize = DEFAULT_FONT_SIZE)
+        -> AssetHandle<TTF_Font>
+    {
+        const auto cacheKey =
+            ResourcePathKey(path.c_str()) + FontSizeParams(ptSize);
+
+        if (auto font = GetFontCache().Find(cacheKey))
+        {
+            auto request = CreateRequest(AssetType::FONT, path, cacheKey);
+
+            request->font = font;
+            request->state = AssetState::READY;
+
+            return AssetHandle<TTF_Font>(request);
+        }
+
+        SetupFonts();
+
+        return AssetHandle<TTF_Font>(
+            Enqueue(AssetType::FONT, path, cacheKey, ptSize));
+    }
+
+    /**
+     * Load a sound effect from a path in the background.
+     *
+     * @param path File path to audio file.
+     */
+    auto LoadSFX(const std::string &path) -> AssetHandle<Mix_Chunk>
+    {
+        const auto cacheKey = ResourcePathKey(path.c_str());
+
+        if (auto sfx = GetSFXCache().Find(cacheKey))
+        {
+            auto request = CreateRequest(AssetType::SFX, path, cacheKey);
+
+            request->sfx = sfx;
+            request->state = AssetState::READY;
+
+            return AssetHandle<Mix_Chunk>(request);
+        }
+
+        // The device format has to be known before a chunk can be decoded.
+
+        if (SetupAudio() != 0)
+        {
+            auto request = CreateRequest(AssetType::SFX, path, cacheKey);
+
+            request->state = AssetState::FAILED;
+
+            return AssetHandle<Mix_Chunk>(request);
+        }
+
+        return AssetHandle<Mix_Chunk>(
+            Enqueue(AssetType::SFX, path, cacheKey, DEFAULT_FONT_SIZE));
+    }
+
+    /**
+     * Start loading every asset in a manifest.
+     *
+     * @param manifest Assets to load.
+     */
+    auto Preload(const AssetManifest &manifest) -> AssetPreload
+    {
+        AssetPreload preload;
+
+        for (const auto &path : manifest.GetTextures())
+        {
+            preload.Add(LoadTexture(path).GetRequest());
+        }
+
+        for (const auto &[path, ptSize] : manifest.GetFonts())
+        {
+            preload.Add(LoadFont(path, ptSize).GetRequest());
+        }
+
+        for (const auto &path : manifest.GetSFX())
+        {
+            preload.Add(LoadSFX(path).GetRequest());
+        }
+
+        return preload;
+    }
+
+    /**
+     * Finish decoded assets on the main thread until the frame budget runs
+     * out. Called once per frame by the game.
+     */
+    void Update()
+    {
+        const auto start = SDL_GetPerformanceCounter();
+        const auto frequency =
+            static_cast<double>(SDL_GetPerformanceFrequency());
+
+        while (true)
+        {
+            std::shared_ptr<AssetRequest> request;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if (decoded.empty())
+                {
+                    return;
+                }
+
+                request = decoded.front();
+
+                decoded.pop_front();
+            }
+
+            Finish(request);
+
+            if ((SDL_GetPerformanceCounter() - start) / frequency >=
+                frameBudget)
+            {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Number of loads that haven't finished yet.
+     */
+    [[nodiscard]] auto GetLoadingCount() const -> size_t
+    {
+        return inFlight.size();
+    }
+
+    /**
+     * Stop the workers and drop anything not finished. Called before the
+     * caches and SDL are torn down.
+     */
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            stopping = true;
+        }
+
+        condition.notify_all();
+
+        for (auto &worker : workers)
+        {
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+
+        workers.clear();
+
+        for (auto &request : decoded)
+        {
+            Release(request);
+        }
+
+        for (auto &request : pending)
+        {
+            request->state = AssetState::FAILED;
+        }
+
+        pending.clear();
+        decoded.clear();
+        inFlight.clear();
+
+        stopping = false;
+    }
+
+  private:
+    static auto CreateRequest(AssetType type, const std::string &path,
+                              const std::string &cacheKey)
+        -> std::shared_ptr<AssetRequest>
+    {
+        auto request = std::make_shared<AssetRequest>();
+
+        request->type = type;
+        request->path = path;
+        request->cacheKey = cacheKey;
+
+        return request;
+    }
+
+    auto Enqueue(AssetType type, const std::string &path,
+                 const std::string &cacheKey, int ptSize)
+        -> std::shared_ptr<AssetRequest>
+    {
+        auto match = inFlight.find(cacheKey);
+
+        if (match != inFlight.end())
+        {
+            return match->second;
+        }
+
+        auto request = CreateRequest(type, path, cacheKey);
+
+        request->ptSize = ptSize;
+
+        inFlight.insert_or_assign(cacheKey, request);
+
+#ifdef HANDCRANK_ENGINE_ASYNC_ASSETS
+        StartWorkers();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            pending.emplace_back(request);
+        }
+
+        condition.notify_one();
+#else
+        Decode(*request);
+
+        Finish(request);
+#endif
+
+        return request;
+    }
+
+    void StartWorkers()
+    {
+        if (!workers.empty())
+        {
+            return;
+        }
+
+        for (auto i = 0; i < workerCount; i += 1)
+        {
+            workers.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    void WorkerLoop()
+    {
+        while (true)
+        {
+            std::shared_ptr<AssetRequest> request;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                condition.wait(
+                    lock, [this]() { return stopping || !pending.empty(); });
+
+                if (stopping)
+                {
+                    return;
+                }
+
+                request = pending.front();
+
+                pending.pop_front();
+            }
+
+            Decode(*request);
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            decoded.emplace_back(request);
+        }
+    }
+
+    /**
+     * Work that doesn't need the main thread. Runs on a worker.
+     */
+    static void Decode(AssetRequest &request)
+    {
+        switch (request.type)
+        {
+        case AssetType::TEXTURE:
+            request.surface = IMG_Load(request.path.c_str());
+            break;
+
+        case AssetType::FONT:
+        {
+            size_t size = 0;
+
+            auto *data = SDL_LoadFile(request.path.c_str(), &size);
+
+            if (data != nullptr)
+            {
+                request.bytes = std::shared_ptr<void>(data, SDL_free);
+                request.bytesSize = size;
+            }
+            break;
+        }
+
+        case AssetType::SFX:
+            request.chunk = Mix_LoadWAV(request.path.c_str());
+            break;
+        }
+    }
+
+    /**
+     * Work that has to happen on the main thread, then resolve the handle.
+     */
+    void Finish(const std::shared_ptr<AssetRequest> &request)
+    {
+        switch (request->type)
+        {
+        case AssetType::TEXTURE:
+            request->texture = CacheTextureFromSurface(
+                renderer, request->cacheKey, request->surface);
+            request->surface = nullptr;
+            break;
+
+        case AssetType::FONT:
+            request->font = OpenFont(*request);
+            break;
+
+        case AssetType::SFX:
+            if (request->chunk != nullptr)
+            {
+                request->sfx = std::shared_ptr<Mix_Chunk>(request->chunk,
+                                                          MixChunkDeleter{});
+
+                GetSFXCache().Insert(request->cacheKey, request->sfx,
+                                     request->chunk->alen);
+
+                request->chunk = nullptr;
+            }
+            break;
+        }
+
+        inFlight.erase(request->cacheKey);
+
+        const auto loaded = request->texture != nullptr ||
+                            request->font != nullptr ||
+                            request->sfx != nullptr;
+
+        request->state = loaded ? AssetState::READY : AssetState::FAILED;
+
+        auto onReady = std::move(request->onReady);
+
+        request->onReady.clear();
+
+        if (loaded)
+        {
+            for (const auto &callback : onReady)
+            {
+                callback();
+            }
+        }
+    }
+
+    static auto OpenFont(AssetRequest &request) -> std::shared_ptr<TTF_Font>
+    {
+        if (request.bytes == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto *rw = SDL_RWFromConstMem(request.bytes.get(),
+                                      static_cast<int>(request.bytesSize));
+
+        TTF_Font *rawFont = nullptr;
+
+        if (rw != nullptr)
+        {
+            const auto lock = LockFonts();
+
+            rawFont = TTF_OpenFontRW(rw, 1, request.ptSize);
+        }
+
+        if (rawFont == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The font reads from the file contents for as long as it is open,
+        // so the deleter holds on to them.
+
+        auto font = std::shared_ptr<TTF_Font>(
+            rawFont, [bytes = request.bytes](TTF_Font *font)
+            { FontDeleter()(font); });
+
+        GetFontCache().Insert(request.cacheKey, font, request.bytesSize);
+
+        request.bytes = nullptr;
+
+        return font;
+    }
+
+    static void Release(const std::shared_ptr<AssetRequest> &request)
+    {
+        if (request->surface != nullptr)
+        {
+            SDL_FreeSurface(request->surface);
+            request->surface = nullptr;
+        }
+
+        if (request->chunk != nullptr)
+        {
+            Mix_FreeChunk(request->chunk);
+            request->chunk = nullptr;
+        }
+
+        request->bytes = nullptr;
+
+        request->state = AssetState::FAILED;
+    }
+};
+
+} // namespace HandcrankEngine
@@ -0,0 +1,622 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/fetch.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HANDCRANK_ENGINE_MMAP_ASSET_PACKS 1
+#endif
+
+#include "AudioCache.hpp"
+#include "FontCache.hpp"
+#include "ResourceCache.hpp"
+#include "TextureCache.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const char ASSET_PACK_MAGIC[] = "HCPK";
+
+inline const uint32_t ASSET_PACK_VERSION = 1;
+
+inline const size_t ASSET_PACK_HEADER_SIZE = 16;
+
+enum class AssetCompression : uint8_t
+{
+    NONE,
+    LZ4
+};
+
+enum class AssetPackState : uint8_t
+{
+    CLOSED,
+    LOADING,
+    READY,
+    FAILED
+};
+
+struct AssetPackEntry
+{
+    AssetCompression compression;
+
+    /** Offset of the stored bytes from the start of the pack. */
+    uint64_t offset;
+
+    /** Stored size, in bytes. */
+    uint64_t size;
+
+    /** Size once decompressed, in bytes. */
+    uint64_t originalSize;
+};
+
+/**
+ * Decompress a single LZ4 block.
+ *
+ * @param src Compressed block.
+ * @param srcSize Size of the compressed block, in bytes.
+ * @param dst Buffer for the decompressed bytes.
+ * @param dstSize Exact decompressed size, in bytes.
+ */
+inline auto DecompressLZ4Block(const uint8_t *src, size_t srcSize,
+                               uint8_t *dst, size_t dstSize) -> bool
+{
+    size_t ip = 0;
+    size_t op = 0;
+
+    const auto readLength = [&](size_t length) -> size_t
+    {
+        if (length != 15)
+        {
+            return length;
+        }
+
+        uint8_t extra = 255;
+
+        while (extra == 255 && ip < srcSize)
+        {
+            extra = src[ip];
+
+            ip += 1;
+
+            length += extra;
+        }
+
+        return length;
+    };
+
+    while (ip < srcSize)
+    {
+        const auto token = src[ip];
+
+        ip += 1;
+
+        const auto literalLength = readLength(token >> 4);
+
+        if (literalLength > srcSize - ip || literalLength > dstSize - op)
+        {
+            return false;
+        }
+
+        std::memcpy(dst + op, src + ip, literalLength);
+
+        ip += literalLength;
+        op += literalLength;
+
+        // The last sequence of a block is literals only.
+
+        if (ip == srcSize)
+        {
+            break;
+        }
+
+        if (srcSize - ip < 2)
+        {
+            return false;
+        }
+
+        const size_t offset = src[ip] | (src[ip + 1] << 8);
+
+        ip += 2;
+
+        if (offset == 0 || offset > op)
+        {
+            return false;
+        }
+
+        const auto matchLength = readLength(token & 15) + 4;
+
+        if (matchLength > dstSize - op)
+        {
+            return false;
+        }
+
+        // A match can overlap the bytes it produces, so copy one at a time.
+
+        for (size_t i = 0; i < matchLength; i += 1)
+        {
+            dst[op] = dst[op - offset];
+
+            op += 1;
+        }
+    }
+
+    return op == dstSize;
+}
+
+/**
+ * A single file holding many assets, built by tools/asset-packer. The index
+ * at the front lists the name, offset, size and compression of every asset.
+ * On desktop the pack is memory mapped, so assets are only paged in once
+ * they are loaded. In the browser it is fetched asynchronously and can be
+ * used once IsReady returns true.
+ *
+ * Stored assets are handed to the cache loaders as streams over the mapped
+ * bytes without copying. Assets already cached aren't opened at all.
+ * Compressed fonts and music are decompressed the first time they are opened
+ * and the decompressed bytes are kept until the pack is closed, since they
+ * keep reading from their stream. Textures and sounds are copied as they
+ * load, so they are decompressed into a reused scratch buffer instead.
+ *
+ * The pack must outlive every font and music loaded from it.
+ */
+class AssetPack
+{
+  private:
+    std::string source;
+
+    AssetPackState state = AssetPackState::CLOSED;
+
+    const uint8_t *data = nullptr;
+    size_t dataSize = 0;
+
+    std::unordered_map<std::string, AssetPackEntry> entries;
+
+    std::unordered_map<std::string, std::vector<uint8_t>> decompressed;
+
+    std::vector<uint8_t> scratch;
+
+#ifdef __EMSCRIPTEN__
+    emscripten_fetch_t *fetch = nullptr;
+#elif defined(HANDCRANK_ENGINE_MMAP_ASSET_PACKS)
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+#else
+    void *fileData = nullptr;
+#endif
+
+    [[nodiscard]] static auto ReadLE(const uint8_t *bytes, size_t count)
+        -> uint64_t
+    {
+        uint64_t value = 0;
+
+        for (size_t i = 0; i < count; i += 1)
+        {
+            value |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+        }
+
+        return value;
+    }
+
+    /**
+     * Read the index out of the loaded bytes, checking that every entry lies
+     * inside the pack.
+     */
+    auto ParseIndex() -> bool
+    {
+        entries.clear();
+
+        if (data == nullptr || dataSize < ASSET_PACK_HEADER_SIZE ||
+            std::memcmp(data, ASSET_PACK_MAGIC, 4) != 0 ||
+            ReadLE(data + 4, 4) != ASSET_PACK_VERSION)
+        {
+            return false;
+        }
+
+        const auto entryCount = ReadLE(data + 8, 4);
+        const auto indexEnd = ASSET_PACK_HEADER_SIZE + ReadLE(data + 12, 4);
+
+        if (indexEnd > dataSize)
+        {
+            return false;
+        }
+
+        auto position = ASSET_PACK_HEADER_SIZE;
+
+        for (uint64_t i = 0; i < entryCount; i += 1)
+        {
+            if (position + 2 > indexEnd)
+            {
+                return false;
+            }
+
+            const auto nameLength = ReadLE(data + position, 2);
+
+            position += 2;
+
+            if (position + nameLength + 25 > indexEnd)
+            {
+                return false;
+            }
+
+            const auto name =
+                std::string(reinterpret_cast<const char *>(data + position),
+                            nameLength);
+
+            position += nameLength;
+
+            auto entry = AssetPackEntry{
+                static_cast<AssetCompression>(data[position]),
+                ReadLE(data + position + 1, 8),
+                ReadLE(data + position + 9, 8),
+                ReadLE(data + position + 17, 8)};
+
+            position += 25;
+
+            if (entry.compression > AssetCompression::LZ4 ||
+                entry.offset > dataSize || entry.size > dataSize - entry.offset)
+            {
+                return false;
+            }
+
+            entries[name] = entry;
+        }
+
+        return true;
+    }
+
+    void Finish(bool loaded)
+    {
+        state = loaded && ParseIndex() ? AssetPackState::READY
+                                       : AssetPackState::FAILED;
+
+        if (state == AssetPackState::FAILED)
+        {
+            SDL_Log("Failed to open asset pack %s", source.c_str());
+        }
+    }
+
+  public:
+    AssetPack() = default;
+
+    AssetPack(const AssetPack &) = delete;
+    auto operator=(const AssetPack &) -> AssetPack & = delete;
+
+    ~AssetPack() { Close(); }
+
+    /**
+     * Open a pack from a file, or from a URL in the browser. In the browser
+     * this only starts the fetch and returns true, check IsReady before
+     * loading from the pack.
+     *
+     * @param path File path or URL of the pack.
+     */
+    auto Open(const std::string &path) -> bool
+    {
+        Close();
+
+        source = path;
+
+        state = AssetPackState::LOADING;
+
+#ifdef __EMSCRIPTEN__
+        emscripten_fetch_attr_t attributes;
+
+        emscripten_fetch_attr_init(&attributes);
+
+        std::strcpy(attributes.requestMethod, "GET");
+
+        attributes.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
+        attributes.userData = this;
+
+        attributes.onsuccess = [](emscripten_fetch_t *fetch)
+        {
+            auto *pack = static_cast<AssetPack *>(fetch->userData);
+
+            pack->data = reinterpret_cast<const uint8_t *>(fetch->data);
+            pack->dataSize = static_cast<size_t>(fetch->numBytes);
+
+            pack->Finish(true);
+        };
+
+        attributes.onerror = [](emscripten_fetch_t *fetch)
+        {
+            static_cast<AssetPack *>(fetch->userData)->Finish(false);
+        };
+
+        fetch = emscripten_fetch(&attributes, path.c_str());
+
+        return fetch != nullptr;
+#elif defined(HANDCRANK_ENGINE_MMAP_ASSET_PACKS)
+        const auto file = open(path.c_str(), O_RDONLY);
+
+        struct stat info = {};
+
+        if (file >= 0 && fstat(file, &info) == 0 && info.st_size > 0)
+        {
+            mappingSize = static_cast<size_t>(info.st_size);
+
+            mapping =
+                mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+
+            if (mapping == MAP_FAILED)
+            {
+                mapping = nullptr;
+            }
+        }
+
+        if (file >= 0)
+        {
+            close(file);
+        }
+
+        if (mapping != nullptr)
+        {
+            data = static_cast<const uint8_t *>(mapping);
+            dataSize = mappingSize;
+        }
+
+        Finish(mapping != nullptr);
+
+        return IsReady();
+#else
+        fileData = SDL_LoadFile(path.c_str(), &dataSize);
+
+        data = static_cast<const uint8_t *>(fileData);
+
+        Finish(fileData != nullptr);
+
+        return IsReady();
+#endif
+    }
+
+    /**
+     * Open a pack already in memory, such as one embedded in the binary.
+     *
+     * @param mem A pointer to a read-only buffer that outlives the pack.
+     * @param size The buffer size, in bytes.
+     */
+    auto Open(const void *mem, size_t size) -> bool
+    {
+        Close();
+
+        source = ResourceMemKey(mem, size);
+
+        data = static_cast<const uint8_t *>(mem);
+        dataSize = size;
+
+        Finish(mem != nullptr);
+
+        return IsReady();
+    }
+
+    /**
+     * Close the pack. Cached fonts and music loaded from it are evicted, as
+     * they keep reading from its bytes, so anything still holding one has to
+     * let go of it first. Textures and sounds are copies and stay cached.
+     */
+    void Close()
+    {
+        if (!source.empty())
+        {
+            const auto prefix = ResourcePackKey(source, "");
+
+            const auto isFromPack = [&prefix](const std::string &key)
+            { return key.compare(0, prefix.size(), prefix) == 0; };
+
+            GetFontCache().EraseIf(isFromPack);
+            GetMusicCache().EraseIf(isFromPack);
+        }
+
+#ifdef __EMSCRIPTEN__
+        if (fetch != nullptr)
+        {
+            emscripten_fetch_close(fetch);
+
+            fetch = nullptr;
+        }
+#elif defined(HANDCRANK_ENGINE_MMAP_ASSET_PACKS)
+        if (mapping != nullptr)
+        {
+            munmap(mapping, mappingSize);
+
+            mapping = nullptr;
+            mappingSize = 0;
+        }
+#else
+        if (fileData != nullptr)
+        {
+            SDL_free(fileData);
+
+            fileData = nullptr;
+        }
+#endif
+
+        data = nullptr;
+        dataSize = 0;
+
+        entries.clear();
+        decompressed.clear();
+
+        scratch.clear();
+        scratch.shrink_to_fit();
+
+        state = AssetPackState::CLOSED;
+    }
+
+    [[nodiscard]] auto GetState() const -> AssetPackState { return state; }
+
+    [[nodiscard]] auto IsReady() const -> bool
+    {
+        return state == AssetPackState::READY;
+    }
+
+    [[nodiscard]] auto GetEntryCount() const -> size_t
+    {
+        return entries.size();
+    }
+
+    [[nodiscard]] auto Contains(const std::string &name) const -> bool
+    {
+        return entries.find(name) != entries.end();
+    }
+
+    [[nodiscard]] auto GetEntry(const std::string &name) const
+        -> const AssetPackEntry *
+    {
+        const auto match = entries.find(name);
+
+        return match != entries.end() ? &match->second : nullptr;
+    }
+
+    /**
+     * Cache key of an asset in this pack.
+     *
+     * @param name Name of the asset in the pack.
+     */
+    [[nodiscard]] auto GetKey(const std::string &name) const -> std::string
+    {
+        return ResourcePackKey(source, name);
+    }
+
+    /**
+     * Open a read-only stream over an asset, or nullptr if the pack has no
+     * asset by that name. Close it with SDL_RWclose unless it is handed to a
+     * loader that closes it.
+     *
+     * @param name Name of the asset in the pack.
+     * @param keepDecompressed Whether a compressed asset stays decompressed
+     * until the pack is closed, for loaders that keep reading from the
+     * stream such as fonts and music. Otherwise it is decompressed into a
+     * scratch buffer that the next call to OpenRW reuses.
+     */
+    [[nodiscard]] auto OpenRW(const std::string &name,
+                              bool keepDecompressed = true) -> SDL_RWops *
+    {
+        const auto *entry = GetEntry(name);
+
+        if (entry == nullptr)
+        {
+            return nullptr;
+        }
+
+        const auto *bytes = data + entry->offset;
+
+        if (entry->compression == AssetCompression::NONE)
+        {
+            return SDL_RWFromConstMem(bytes, static_cast<int>(entry->size));
+        }
+
+        const auto match = decompressed.find(name);
+
+        if (match != decompressed.end())
+        {
+            return SDL_RWFromConstMem(match->second.data(),
+                                      static_cast<int>(match->second.size()));
+        }
+
+        auto &buffer = keepDecompressed ? decompressed[name] : scratch;
+
+        buffer.resize(static_cast<size_t>(entry->originalSize));
+
+        if (!DecompressLZ4Block(bytes, static_cast<size_t>(entry->size),
+                                buffer.data(), buffer.size()))
+        {
+            SDL_Log("Failed to decompress %s from asset pack %s",
+                    name.c_str(), source.c_str());
+
+            if (keepDecompressed)
+            {
+                decompressed.erase(name);
+            }
+
+            return nullptr;
+        }
+
+        return SDL_RWFromConstMem(buffer.data(),
+                                  static_cast<int>(buffer.size()));
+    }
+
+    /**
+     * Load a texture from the pack through the texture cache.
+     *
+     * @param renderer A structure representing rendering state.
+     * @param name Name of the image in the pack.
+     */
+    auto LoadTexture(SDL_Renderer *renderer, const std::string &name)
+        -> std::shared_ptr<SDL_Texture>
+    {
+        const auto key = GetKey(name);
+
+        // Textures are copied out of the stream, so a compressed one only
+        // needs decompressing into the scratch buffer.
+
+        const auto isCached =
+            GetTextureCache().Contains(TextureRendererKey(renderer) + key);
+
+        auto *rw = isCached ? nullptr : OpenRW(name, false);
+
+        return LoadCachedTexture(renderer, key, rw);
+    }
+
+    /**
+     * Load a font from the pack through the font cache.
+     *
+     * @param name Name of the font in the pack.
+     * @param ptSize The size of the font.
+     */
+    auto LoadFont(const std::string &name, int ptSize = DEFAULT_FONT_SIZE)
+        -> std::shared_ptr<TTF_Font>
+    {
+        const auto key = GetKey(name);
+
+        auto *rw = GetFontCache().Contains(key + FontSizeParams(ptSize))
+                       ? nullptr
+                       : OpenRW(name);
+
+        return LoadCachedFont(key, rw, ptSize);
+    }
+
+    auto LoadMusic(const std::string &name) -> std::shared_ptr<Mix_Music>
+    {
+        const auto key = GetKey(name);
+
+        auto *rw = GetMusicCache().Contains(key) ? nullptr : OpenRW(name);
+
+        return LoadCachedMusic(key, rw);
+    }
+
+    auto LoadSFX(const std::string &name) -> std::shared_ptr<Mix_Chunk>
+    {
+        const auto key = GetKey(name);
+
+        auto *rw = GetSFXCache().Contains(key) ? nullptr : OpenRW(name, false);
+
+        return LoadCachedSFX(key, rw);
+    }
+};
+
+} // namespace HandcrankEngine
@@ -14,6 +14,11 @@
 namespace HandcrankEngine
 {
 
+namespace
+{
+inline Mix_Music *playingMusic = nullptr;
+} // namespace
+
 inline auto PlayMusic(Mix_Music *music) -> int
 {
     if (music == nullptr)
@@ -21,9 +26,19 @@ inline auto PlayMusic(Mix_Music *music) -> int
         return -1;
     }
 
+    playingMusic = music;
+
     return Mix_PlayMusic(music, -1);
 }
 
+/**
+ * Music last started with PlayMusic that is still playing, or nullptr.
+ */
+[[nodiscard]] inline auto GetPlayingMusic() -> Mix_Music *
+{
+    return Mix_PlayingMusic() != 0 ? playingMusic : nullptr;
+}
+
 inline auto PlaySFX(Mix_Chunk *sfx) -> int
 {
     if (sfx == nullptr)
@@ -44,7 +59,12 @@ inline auto PlaySFXOnChannel(int channel, Mix_Chunk *sfx) -> int
     return Mix_PlayChannel(channel, sfx, 0);
 }
 
-inline void StopAllMusic() { Mix_HaltMusic(); }
+inline void StopAllMusic()
+{
+    Mix_HaltMusic();
+
+    playingMusic = nullptr;
+}
 
 inline void StopAllSFX() { Mix_HaltChannel(-1); }
 
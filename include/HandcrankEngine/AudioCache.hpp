@@ -9,10 +9,13 @@
 
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include <mutex>
 
 #include <SDL_mixer.h>
 
+#include "ResourceCache.hpp"
 #include "Utilities.hpp"
 
 namespace HandcrankEngine
@@ -20,22 +23,51 @@ namespace HandcrankEngine
 
 inline const int DEFAULT_AUDIO_CHUNK_SIZE = 512;
 
+inline const int MIN_AUDIO_CHUNK_SIZE = 128;
+inline const int MAX_AUDIO_CHUNK_SIZE = 4096;
+
+/**
+ * Settings the mixer is opened with. Smaller chunks lower latency but give the
+ * audio thread less time to mix each one.
+ */
+struct AudioConfig
+{
+    int frequency = MIX_DEFAULT_FREQUENCY;
+    int chunkSize = DEFAULT_AUDIO_CHUNK_SIZE;
+};
+
 namespace
 {
+inline std::recursive_mutex audioMutex;
+
 bool audioIsOpen = false;
 
-inline std::unordered_map<std::size_t, std::shared_ptr<Mix_Music>>
-    audioMusicCache =
-        std::unordered_map<std::size_t, std::shared_ptr<Mix_Music>>();
-inline std::unordered_map<std::size_t, std::shared_ptr<Mix_Chunk>>
-    audioSFXCache =
-        std::unordered_map<std::size_t, std::shared_ptr<Mix_Chunk>>();
+AudioConfig audioConfig;
+
+inline ResourceCache<Mix_Music> audioMusicCache = ResourceCache<Mix_Music>();
+inline ResourceCache<Mix_Chunk> audioSFXCache = ResourceCache<Mix_Chunk>();
 } // namespace
 
+/**
+ * Music shared by every game in the process.
+ */
+inline auto GetMusicCache() -> ResourceCache<Mix_Music> &
+{
+    return audioMusicCache;
+}
+
+/**
+ * Sound effects shared by every game in the process.
+ */
+inline auto GetSFXCache() -> ResourceCache<Mix_Chunk> &
+{
+    return audioSFXCache;
+}
+
 inline auto ClearAudioCache() -> void
 {
-    audioMusicCache.clear();
-    audioSFXCache.clear();
+    audioMusicCache.Clear();
+    audioSFXCache.Clear();
 }
 
 struct MixMusicDeleter
@@ -60,15 +92,21 @@ struct MixChunkDeleter
     }
 };
 
+/**
+ * Open the mixer if it isn't already. There is one mixer for the process, so
+ * opening and closing it is locked.
+ */
 inline auto SetupAudio() -> int
 {
+    std::lock_guard<std::recursive_mutex> lock(audioMutex);
+
     if (audioIsOpen)
     {
         return 0;
     }
 
-    auto result = Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT,
-                                MIX_DEFAULT_CHANNELS, DEFAULT_AUDIO_CHUNK_SIZE);
+    auto result = Mix_OpenAudio(audioConfig.frequency, MIX_DEFAULT_FORMAT,
+                                MIX_DEFAULT_CHANNELS, audioConfig.chunkSize);
 
     if (result == 0)
     {
@@ -78,15 +116,68 @@ inline auto SetupAudio() -> int
     return result;
 }
 
-inline auto LoadCachedMusic(const char *path) -> std::shared_ptr<Mix_Music>
+[[nodiscard]] inline auto GetAudioConfig() -> AudioConfig
 {
-    auto cacheKey = std::hash<std::string_view>{}(std::string_view(path));
+    std::lock_guard<std::recursive_mutex> lock(audioMutex);
 
-    auto match = audioMusicCache.find(cacheKey);
+    return audioConfig;
+}
+
+/**
+ * Change the settings the mixer is opened with. Takes effect the next time
+ * audio is opened, call ReopenAudio to apply it to an open mixer.
+ *
+ * @param config Settings to open the mixer with.
+ */
+inline void SetAudioConfig(const AudioConfig &config)
+{
+    std::lock_guard<std::recursive_mutex> lock(audioMutex);
+
+    audioConfig = config;
 
-    if (match != audioMusicCache.end())
+    audioConfig.chunkSize = std::clamp(audioConfig.chunkSize,
+                                       MIN_AUDIO_CHUNK_SIZE,
+                                       MAX_AUDIO_CHUNK_SIZE);
+}
+
+/**
+ * Largest power of two chunk size that mixes a chunk within a latency
+ * target, e.g. 256 frames for 10ms at 44100Hz.
+ *
+ * @param latency Latency target in seconds.
+ * @param frequency Sample rate in Hz.
+ */
+[[nodiscard]] inline auto GetAudioChunkSizeForLatency(double latency,
+                                                      int frequency) -> int
+{
+    auto chunkSize = MIN_AUDIO_CHUNK_SIZE;
+
+    while (chunkSize * 2 <= MAX_AUDIO_CHUNK_SIZE &&
+           static_cast<double>(chunkSize * 2) / frequency <= latency)
     {
-        return match->second;
+        chunkSize *= 2;
+    }
+
+    return chunkSize;
+}
+
+/**
+ * Time it takes to mix one chunk with the current settings, in seconds.
+ */
+[[nodiscard]] inline auto GetAudioLatency() -> double
+{
+    std::lock_guard<std::recursive_mutex> lock(audioMutex);
+
+    return static_cast<double>(audioConfig.chunkSize) / audioConfig.frequency;
+}
+
+inline auto LoadCachedMusic(const char *path) -> std::shared_ptr<Mix_Music>
+{
+    const auto cacheKey = ResourcePathKey(path);
+
+    if (auto match = audioMusicCache.Find(cacheKey))
+    {
+        return match;
     }
 
     if (SetupAudio() != 0)
@@ -102,7 +193,7 @@ inline auto LoadCachedMusic(const char *path) -> std::shared_ptr<Mix_Music>
         return nullptr;
     }
 
-    audioMusicCache.insert_or_assign(cacheKey, music);
+    audioMusicCache.Insert(cacheKey, music, GetFileBytes(path));
 
     return music;
 }
@@ -110,13 +201,11 @@ inline auto LoadCachedMusic(const char *path) -> std::shared_ptr<Mix_Music>
 inline auto LoadCachedMusic(const void *mem, int size)
     -> std::shared_ptr<Mix_Music>
 {
-    auto cacheKey = MemHash(mem, size);
+    const auto cacheKey = ResourceMemKey(mem, size);
 
-    auto match = audioMusicCache.find(cacheKey);
-
-    if (match != audioMusicCache.end())
+    if (auto match = audioMusicCache.Find(cacheKey))
     {
-        return match->second;
+        return match;
     }
 
     auto *rw = SDL_RWFromConstMem(mem, size);
@@ -139,20 +228,67 @@ inline auto LoadCachedMusic(const void *mem, int size)
         return nullptr;
     }
 
-    audioMusicCache.insert_or_assign(cacheKey, music);
+    audioMusicCache.Insert(cacheKey, music, size);
 
     return music;
 }
 
-inline auto LoadCachedSFX(const char *path) -> std::shared_ptr<Mix_Chunk>
+/**
+ * Load music from a stream, which is closed along with the music. The cache
+ * key stands in for a path, so the stream is only read on a cache miss.
+ *
+ * @param key Cache key of the music, unique to the stream contents.
+ * @param rw A read-only stream that stays valid while the music is in use,
+ * which can be nullptr when the music is already cached.
+ */
+inline auto LoadCachedMusic(const std::string &key, SDL_RWops *rw)
+    -> std::shared_ptr<Mix_Music>
 {
-    auto cacheKey = std::hash<std::string_view>{}(std::string_view(path));
+    if (auto match = audioMusicCache.Find(key))
+    {
+        if (rw != nullptr)
+        {
+            SDL_RWclose(rw);
+        }
+
+        return match;
+    }
+
+    if (rw == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (SetupAudio() != 0)
+    {
+        SDL_RWclose(rw);
+
+        return nullptr;
+    }
 
-    auto match = audioSFXCache.find(cacheKey);
+    const auto size = SDL_RWsize(rw);
 
-    if (match != audioSFXCache.end())
+    auto music =
+        std::shared_ptr<Mix_Music>(Mix_LoadMUS_RW(rw, 1), MixMusicDeleter{});
+
+    if (music == nullptr)
     {
-        return match->second;
+        return nullptr;
+    }
+
+    audioMusicCache.Insert(key, music,
+                           size > 0 ? static_cast<size_t>(size) : 0);
+
+    return music;
+}
+
+inline auto LoadCachedSFX(const char *path) -> std::shared_ptr<Mix_Chunk>
+{
+    const auto cacheKey = ResourcePathKey(path);
+
+    if (auto match = audioSFXCache.Find(cacheKey))
+    {
+        return match;
     }
 
     if (SetupAudio() != 0)
@@ -167,7 +303,7 @@ inline auto LoadCachedSFX(const char *path) -> std::shared_ptr<Mix_Chunk>
         return nullptr;
     }
 
-    audioSFXCache.insert_or_assign(cacheKey, sfx);
+    audioSFXCache.Insert(cacheKey, sfx, sfx->alen);
 
     return sfx;
 }
@@ -175,13 +311,11 @@ inline auto LoadCachedSFX(const char *path) -> std::shared_ptr<Mix_Chunk>
 inline auto LoadCachedSFX(const void *mem, int size)
     -> std::shared_ptr<Mix_Chunk>
 {
-    auto cacheKey = MemHash(mem, size);
-
-    auto match = audioSFXCache.find(cacheKey);
+    const auto cacheKey = ResourceMemKey(mem, size);
 
-    if (match != audioSFXCache.end())
+    if (auto match = audioSFXCache.Find(cacheKey))
     {
-        return match->second;
+        return match;
     }
 
     auto *rw = SDL_RWFromConstMem(mem, size);
@@ -204,13 +338,61 @@ inline auto LoadCachedSFX(const void *mem, int size)
         return nullptr;
     }
 
-    audioSFXCache.insert_or_assign(cacheKey, sfx);
+    audioSFXCache.Insert(cacheKey, sfx, sfx->alen);
+
+    return sfx;
+}
+
+/**
+ * Load a sound effect from a stream, closing the stream. The cache key stands
+ * in for a path, so the stream is only read on a cache miss.
+ *
+ * @param key Cache key of the sound effect, unique to the stream contents.
+ * @param rw A read-only stream, which can be nullptr when the sound effect
+ * is already cached.
+ */
+inline auto LoadCachedSFX(const std::string &key, SDL_RWops *rw)
+    -> std::shared_ptr<Mix_Chunk>
+{
+    if (auto match = audioSFXCache.Find(key))
+    {
+        if (rw != nullptr)
+        {
+            SDL_RWclose(rw);
+        }
+
+        return match;
+    }
+
+    if (rw == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (SetupAudio() != 0)
+    {
+        SDL_RWclose(rw);
+
+        return nullptr;
+    }
+
+    auto sfx =
+        std::shared_ptr<Mix_Chunk>(Mix_LoadWAV_RW(rw, 1), MixChunkDeleter{});
+
+    if (sfx == nullptr)
+    {
+        return nullptr;
+    }
+
+    audioSFXCache.Insert(key, sfx, sfx->alen);
 
     return sfx;
 }
 
 inline auto TeardownAudio() -> void
 {
+    std::lock_guard<std::recursive_mutex> lock(audioMutex);
+
     if (audioIsOpen)
     {
         Mix_CloseAudio();
@@ -219,4 +401,18 @@ inline auto TeardownAudio() -> void
     }
 }
 
+/**
+ * Close and open the mixer again with the current settings. Loaded chunks
+ * stay valid as long as the frequency is unchanged, but playing sounds and
+ * music stop and channels go back to the default count.
+ */
+inline auto ReopenAudio() -> int
+{
+    std::lock_guard<std::recursive_mutex> lock(audioMutex);
+
+    TeardownAudio();
+
+    return SetupAudio();
+}
+
 } // namespace HandcrankEngine
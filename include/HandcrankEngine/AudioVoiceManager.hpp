@@ -0,0 +1,674 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "Audio.hpp"
+#include "AudioCache.hpp"
+#include "HandcrankEngine.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const int DEFAULT_AUDIO_VOICE_COUNT = 16;
+
+inline const int DEFAULT_AUDIO_INSTANCE_LIMIT = 4;
+
+inline const int DEFAULT_AUDIO_PRIORITY = 0;
+
+/**
+ * A chunk taking longer than this many times its own length to come around
+ * again counts as an underrun.
+ */
+inline const double DEFAULT_AUDIO_UNDERRUN_FACTOR = 2;
+
+/**
+ * Underruns within one second before the chunk size is doubled.
+ */
+inline const uint32_t DEFAULT_AUDIO_UNDERRUN_LIMIT = 3;
+
+struct AudioVoice
+{
+    Mix_Chunk *sound = nullptr;
+
+    int priority = DEFAULT_AUDIO_PRIORITY;
+
+    /**
+     * Order the voice was started in, lower is older.
+     */
+    uint64_t startedAt = 0;
+};
+
+struct AudioPlayRequest
+{
+    Mix_Chunk *sound;
+
+    int priority;
+
+    int volume;
+};
+
+/**
+ * Plays sound effects on a fixed pool of mixer channels reserved up front, so
+ * PlaySFX and Mix_PlayChannel(-1, ...) keep the default channels to
+ * themselves.
+ *
+ * Play only queues a request. Requests are flushed once a frame after
+ * Update, highest priority first, with requests for the same sound in the
+ * same frame merged into one. A sound at its instance limit restarts its
+ * oldest voice, and when every voice is busy the lowest priority voice is
+ * stolen as long as it isn't higher priority than the request.
+ *
+ * The mixer is watched for underruns from the audio thread, and when they
+ * keep happening the chunk size is doubled and the mixer reopened, once no
+ * sound effects are playing. Music started with PlayMusic carries on from
+ * where it was.
+ *
+ * The watch is installed with Mix_SetPostMix, which replaces any post-mix
+ * callback set before the voices are allocated. Set one through
+ * SetPostMixCallback instead, which is called first.
+ */
+class AudioVoiceManager : public GameSystem
+{
+  private:
+    int voiceCount = DEFAULT_AUDIO_VOICE_COUNT;
+
+    std::vector<AudioVoice> voices;
+
+    bool voicesAreAllocated = false;
+
+    std::vector<AudioPlayRequest> requests;
+
+    std::unordered_map<Mix_Chunk *, int> instanceLimits;
+
+    int defaultInstanceLimit = DEFAULT_AUDIO_INSTANCE_LIMIT;
+
+    double latencyTarget = 0;
+
+    bool isUnderrunFallbackEnabled = true;
+
+    uint64_t nextStartedAt = 0;
+
+    uint64_t stolenCount = 0;
+    uint64_t droppedCount = 0;
+
+    // Written by the audio thread in PostMix.
+
+    std::atomic<uint64_t> lastMixCounter{0};
+    std::atomic<uint32_t> underrunCount{0};
+
+    int bytesPerFrame = 0;
+    int frequency = 0;
+
+    uint32_t totalUnderrunCount = 0;
+
+    double underrunWindow = 0;
+
+    int pendingChunkSize = 0;
+
+    void (*postMixCallback)(void *, Uint8 *, int) = nullptr;
+    void *postMixUserdata = nullptr;
+
+    static void PostMix(void *userdata, Uint8 *stream, int len)
+    {
+        auto *manager = static_cast<AudioVoiceManager *>(userdata);
+
+        if (manager->postMixCallback != nullptr)
+        {
+            manager->postMixCallback(manager->postMixUserdata, stream, len);
+        }
+
+        const auto now = SDL_GetPerformanceCounter();
+
+        const auto last = manager->lastMixCounter.exchange(now);
+
+        if (last == 0 || manager->bytesPerFrame == 0)
+        {
+            return;
+        }
+
+        const auto expected = static_cast<double>(len) /
+                              manager->bytesPerFrame / manager->frequency;
+
+        const auto elapsed = static_cast<double>(now - last) /
+                             static_cast<double>(SDL_GetPerformanceFrequency());
+
+        if (elapsed > expected * DEFAULT_AUDIO_UNDERRUN_FACTOR)
+        {
+            manager->underrunCount.fetch_add(1);
+        }
+    }
+
+    /**
+     * Open the mixer if it isn't already and reserve the voice channels.
+     */
+    auto AllocateVoices() -> bool
+    {
+        if (voicesAreAllocated)
+        {
+            return true;
+        }
+
+        if (SetupAudio() != 0)
+        {
+            return false;
+        }
+
+        Mix_AllocateChannels(voiceCount + MIX_CHANNELS);
+        Mix_ReserveChannels(voiceCount);
+
+        voices.assign(voiceCount, AudioVoice());
+
+        int deviceFrequency = 0;
+        Uint16 format = 0;
+        int channels = 0;
+
+        if (Mix_QuerySpec(&deviceFrequency, &format, &channels) != 0)
+        {
+            frequency = deviceFrequency;
+            bytesPerFrame = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+        }
+
+        lastMixCounter = 0;
+
+        Mix_SetPostMix(PostMix, this);
+
+        voicesAreAllocated = true;
+
+        return true;
+    }
+
+    void ReleaseVoices()
+    {
+        if (!voicesAreAllocated)
+        {
+            return;
+        }
+
+        Mix_SetPostMix(nullptr, nullptr);
+
+        for (auto i = 0; i < voiceCount; i += 1)
+        {
+            Mix_HaltChannel(i);
+        }
+
+        Mix_ReserveChannels(0);
+
+        voices.clear();
+
+        voicesAreAllocated = false;
+    }
+
+    /**
+     * Reopen the mixer with a new chunk size. Voices are allocated again on
+     * the next flush, and music started with PlayMusic is restarted at the
+     * position it had reached.
+     */
+    void ApplyChunkSize(int chunkSize)
+    {
+        auto config = GetAudioConfig();
+
+        config.chunkSize = chunkSize;
+
+        SetAudioConfig(config);
+
+        pendingChunkSize = 0;
+
+        if (!voicesAreAllocated)
+        {
+            return;
+        }
+
+        auto *music = GetPlayingMusic();
+
+        const auto musicIsPaused = Mix_PausedMusic() != 0;
+        const auto musicVolume = Mix_VolumeMusic(-1);
+
+#if SDL_MIXER_VERSION_ATLEAST(2, 6, 0)
+        const auto musicPosition =
+            music != nullptr ? Mix_GetMusicPosition(music) : -1;
+#endif
+
+        ReleaseVoices();
+
+        ReopenAudio();
+
+        if (music == nullptr || PlayMusic(music) != 0)
+        {
+            return;
+        }
+
+        Mix_VolumeMusic(musicVolume);
+
+#if SDL_MIXER_VERSION_ATLEAST(2, 6, 0)
+        if (musicPosition > 0)
+        {
+            Mix_SetMusicPosition(musicPosition);
+        }
+#endif
+
+        if (musicIsPaused)
+        {
+            Mix_PauseMusic();
+        }
+    }
+
+    void CheckUnderruns(double deltaTime)
+    {
+        underrunWindow += deltaTime;
+
+        const auto count = underrunCount.load();
+
+        if (count >= DEFAULT_AUDIO_UNDERRUN_LIMIT &&
+            isUnderrunFallbackEnabled && pendingChunkSize == 0 &&
+            GetAudioConfig().chunkSize < MAX_AUDIO_CHUNK_SIZE)
+        {
+            pendingChunkSize = GetAudioConfig().chunkSize * 2;
+
+            SDL_Log("Audio underran %u times, raising chunk size to %d",
+                    count, pendingChunkSize);
+        }
+        else if (underrunWindow < 1)
+        {
+            return;
+        }
+
+        totalUnderrunCount += underrunCount.exchange(0);
+
+        underrunWindow = 0;
+    }
+
+    [[nodiscard]] auto FindVoice(const AudioPlayRequest &request) const -> int
+    {
+        auto instances = 0;
+        auto oldestInstance = -1;
+
+        auto freeVoice = -1;
+        auto weakestVoice = -1;
+
+        for (auto i = 0; i < voiceCount; i += 1)
+        {
+            const auto &voice = voices[i];
+
+            if (voice.sound == nullptr)
+            {
+                if (freeVoice == -1)
+                {
+                    freeVoice = i;
+                }
+
+                continue;
+            }
+
+            if (voice.sound == request.sound)
+            {
+                instances += 1;
+
+                if (oldestInstance == -1 ||
+                    voice.startedAt < voices[oldestInstance].startedAt)
+                {
+                    oldestInstance = i;
+                }
+            }
+
+            if (weakestVoice == -1 ||
+                voice.priority < voices[weakestVoice].priority ||
+                (voice.priority == voices[weakestVoice].priority &&
+                 voice.startedAt < voices[weakestVoice].startedAt))
+            {
+                weakestVoice = i;
+            }
+        }
+
+        if (instances >= GetInstanceLimit(request.sound))
+        {
+            return oldestInstance;
+        }
+
+        if (freeVoice != -1)
+        {
+            return freeVoice;
+        }
+
+        if (weakestVoice != -1 &&
+            voices[weakestVoice].priority <= request.priority)
+        {
+            return weakestVoice;
+        }
+
+        return -1;
+    }
+
+    void Flush()
+    {
+        if (requests.empty())
+        {
+            return;
+        }
+
+        if (!AllocateVoices())
+        {
+            droppedCount += requests.size();
+
+            requests.clear();
+
+            return;
+        }
+
+        for (auto i = 0; i < voiceCount; i += 1)
+        {
+            if (voices[i].sound != nullptr && Mix_Playing(i) == 0)
+            {
+                voices[i].sound = nullptr;
+            }
+        }
+
+        std::stable_sort(requests.begin(), requests.end(),
+                         [](const AudioPlayRequest &a,
+                            const AudioPlayRequest &b)
+                         { return a.priority > b.priority; });
+
+        for (const auto &request : requests)
+        {
+            const auto channel = FindVoice(request);
+
+            if (channel == -1)
+            {
+                droppedCount += 1;
+
+                continue;
+            }
+
+            auto &voice = voices[channel];
+
+            if (voice.sound != nullptr && voice.sound != request.sound)
+            {
+                stolenCount += 1;
+            }
+
+            Mix_Volume(channel, request.volume);
+
+            if (Mix_PlayChannel(channel, request.sound, 0) == -1)
+            {
+                voice.sound = nullptr;
+
+                droppedCount += 1;
+
+                continue;
+            }
+
+            voice.sound = request.sound;
+            voice.priority = request.priority;
+            voice.startedAt = nextStartedAt;
+
+            nextStartedAt += 1;
+        }
+
+        requests.clear();
+    }
+
+  public:
+    AudioVoiceManager() { requests.reserve(DEFAULT_AUDIO_VOICE_COUNT); }
+
+    AudioVoiceManager(const AudioVoiceManager &) = delete;
+    auto operator=(const AudioVoiceManager &) -> AudioVoiceManager & = delete;
+
+    ~AudioVoiceManager() override { ReleaseVoices(); }
+
+    /**
+     * Queue a sound effect to start at the end of this frame.
+     *
+     * @param sound Sound effect to play.
+     * @param priority Higher priority sounds are played first and can take
+     * the voice of lower priority ones.
+     * @param volume Volume from 0 to MIX_MAX_VOLUME.
+     */
+    void Play(Mix_Chunk *sound, int priority = DEFAULT_AUDIO_PRIORITY,
+              int volume = MIX_MAX_VOLUME)
+    {
+        if (sound == nullptr)
+        {
+            return;
+        }
+
+        for (auto &request : requests)
+        {
+            if (request.sound == sound)
+            {
+                request.priority = std::max(request.priority, priority);
+                request.volume = std::max(request.volume, volume);
+
+                return;
+            }
+        }
+
+        requests.emplace_back(AudioPlayRequest{sound, priority, volume});
+    }
+
+    /**
+     * Stop every voice playing a sound effect.
+     *
+     * @param sound Sound effect to stop.
+     */
+    void Stop(Mix_Chunk *sound)
+    {
+        requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                      [sound](const AudioPlayRequest &request)
+                                      { return request.sound == sound; }),
+                       requests.end());
+
+        for (auto i = 0; i < static_cast<int>(voices.size()); i += 1)
+        {
+            if (voices[i].sound == sound)
+            {
+                Mix_HaltChannel(i);
+
+                voices[i].sound = nullptr;
+            }
+        }
+    }
+
+    void StopAll()
+    {
+        requests.clear();
+
+        for (auto i = 0; i < static_cast<int>(voices.size()); i += 1)
+        {
+            Mix_HaltChannel(i);
+
+            voices[i].sound = nullptr;
+        }
+    }
+
+    /**
+     * Resize the voice pool. Playing voices are stopped.
+     *
+     * @param voiceCount Most sound effects playing at once.
+     */
+    void SetVoiceCount(int voiceCount)
+    {
+        ReleaseVoices();
+
+        this->voiceCount = std::max(voiceCount, 1);
+
+        requests.reserve(this->voiceCount);
+    }
+
+    [[nodiscard]] auto GetVoiceCount() const -> int { return voiceCount; }
+
+    /**
+     * Most copies of a sound effect playing at once. Past that, playing the
+     * sound again restarts its oldest voice.
+     *
+     * @param sound Sound effect to limit.
+     * @param limit Instance limit, at least 1.
+     */
+    void SetInstanceLimit(Mix_Chunk *sound, int limit)
+    {
+        instanceLimits[sound] = std::max(limit, 1);
+    }
+
+    /**
+     * Instance limit of sound effects without one of their own.
+     *
+     * @param limit Instance limit, at least 1.
+     */
+    void SetDefaultInstanceLimit(int limit)
+    {
+        defaultInstanceLimit = std::max(limit, 1);
+    }
+
+    [[nodiscard]] auto GetInstanceLimit(Mix_Chunk *sound) const -> int
+    {
+        auto it = instanceLimits.find(sound);
+
+        return it != instanceLimits.end() ? it->second : defaultInstanceLimit;
+    }
+
+    /**
+     * Set the mixer chunk size, reopening the mixer if it's open.
+     *
+     * @param chunkSize Frames per chunk, a power of two.
+     */
+    void SetBufferSize(int chunkSize)
+    {
+        latencyTarget = 0;
+
+        ApplyChunkSize(chunkSize);
+    }
+
+    [[nodiscard]] auto GetBufferSize() const -> int
+    {
+        return GetAudioConfig().chunkSize;
+    }
+
+    /**
+     * Pick the largest chunk size that mixes within a latency target,
+     * reopening the mixer if it's open. The underrun fallback can still raise
+     * it past the target.
+     *
+     * @param latency Latency target in seconds, e.g. 0.01 for 10ms.
+     */
+    void SetLatencyTarget(double latency)
+    {
+        latencyTarget = latency;
+
+        ApplyChunkSize(
+            GetAudioChunkSizeForLatency(latency, GetAudioConfig().frequency));
+    }
+
+    [[nodiscard]] auto GetLatencyTarget() const -> double
+    {
+        return latencyTarget;
+    }
+
+    /**
+     * Whether underruns raise the chunk size. On by default.
+     *
+     * @param enabled Whether the fallback is enabled.
+     */
+    void SetUnderrunFallbackEnabled(bool enabled)
+    {
+        isUnderrunFallbackEnabled = enabled;
+    }
+
+    [[nodiscard]] auto GetActiveVoiceCount() const -> int
+    {
+        return static_cast<int>(
+            std::count_if(voices.begin(), voices.end(),
+                          [](const AudioVoice &voice)
+                          { return voice.sound != nullptr; }));
+    }
+
+    /**
+     * Voices taken from a different, playing sound effect.
+     */
+    [[nodiscard]] auto GetStolenCount() const -> uint64_t
+    {
+        return stolenCount;
+    }
+
+    /**
+     * Requests that found no voice of low enough priority to take.
+     */
+    [[nodiscard]] auto GetDroppedCount() const -> uint64_t
+    {
+        return droppedCount;
+    }
+
+    [[nodiscard]] auto GetUnderrunCount() const -> uint32_t
+    {
+        return totalUnderrunCount + underrunCount.load();
+    }
+
+    /**
+     * Post-mix callback called from the audio thread before the underrun
+     * check, in place of calling Mix_SetPostMix.
+     *
+     * @param callback Called with the mixed stream, or nullptr for none.
+     * @param userdata Passed to the callback.
+     */
+    void SetPostMixCallback(void (*callback)(void *, Uint8 *, int),
+                            void *userdata)
+    {
+        // Mix_SetPostMix takes the mixer lock, so unhooking first keeps the
+        // audio thread from seeing half of the change.
+
+        if (voicesAreAllocated)
+        {
+            Mix_SetPostMix(nullptr, nullptr);
+        }
+
+        postMixCallback = callback;
+        postMixUserdata = userdata;
+
+        if (voicesAreAllocated)
+        {
+            Mix_SetPostMix(PostMix, this);
+        }
+    }
+
+    void Update(double deltaTime) override
+    {
+        if (voicesAreAllocated)
+        {
+            CheckUnderruns(deltaTime);
+        }
+
+        // Reopening the mixer cuts off every sound effect, so a raised
+        // chunk size waits for a gap between them.
+
+        if (pendingChunkSize != 0 && Mix_Playing(-1) == 0)
+        {
+            ApplyChunkSize(pendingChunkSize);
+        }
+
+        Flush();
+    }
+
+    void Clear() override
+    {
+        requests.clear();
+
+        instanceLimits.clear();
+
+        ReleaseVoices();
+    }
+};
+
+} // namespace HandcrankEngine
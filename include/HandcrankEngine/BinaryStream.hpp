@@ -0,0 +1,125 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace HandcrankEngine
+{
+
+/**
+ * Appends plain values to a byte buffer as they are laid out in memory, which
+ * is little-endian on every platform the engine builds for. Writing into a
+ * buffer that already has the capacity doesn't allocate.
+ */
+class BinaryWriter
+{
+  private:
+    std::vector<uint8_t> *buffer;
+
+  public:
+    explicit BinaryWriter(std::vector<uint8_t> &buffer) : buffer(&buffer) {}
+
+    template <typename T> void Write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "T must be trivially copyable");
+
+        WriteBytes(&value, sizeof(T));
+    }
+
+    void WriteBytes(const void *data, size_t size)
+    {
+        const auto offset = buffer->size();
+
+        buffer->resize(offset + size);
+
+        std::memcpy(buffer->data() + offset, data, size);
+    }
+
+    [[nodiscard]] auto GetSize() const -> size_t { return buffer->size(); }
+};
+
+/**
+ * Reads values written by BinaryWriter back out of a byte buffer. Reading
+ * past the end fails, leaves the value untouched and keeps failing, so a run
+ * of reads can be checked once at the end with HasFailed.
+ */
+class BinaryReader
+{
+  private:
+    const uint8_t *data;
+
+    size_t size;
+
+    size_t position = 0;
+
+    bool failed = false;
+
+  public:
+    BinaryReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+    explicit BinaryReader(const std::vector<uint8_t> &buffer)
+        : data(buffer.data()), size(buffer.size())
+    {
+    }
+
+    template <typename T> auto Read(T &value) -> bool
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "T must be trivially copyable");
+
+        return ReadBytes(&value, sizeof(T));
+    }
+
+    template <typename T> auto Read() -> T
+    {
+        T value{};
+
+        Read(value);
+
+        return value;
+    }
+
+    auto ReadBytes(void *output, size_t count) -> bool
+    {
+        if (failed || count > size - position)
+        {
+            failed = true;
+
+            return false;
+        }
+
+        std::memcpy(output, data + position, count);
+
+        position += count;
+
+        return true;
+    }
+
+    void Seek(size_t position)
+    {
+        this->position = position <= size ? position : size;
+
+        failed = false;
+    }
+
+    [[nodiscard]] auto GetPosition() const -> size_t { return position; }
+
+    [[nodiscard]] auto IsAtEnd() const -> bool { return position >= size; }
+
+    [[nodiscard]] auto HasFailed() const -> bool { return failed; }
+};
+
+} // namespace HandcrankEngine
@@ -0,0 +1,475 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL.h>
+
+#include "Vector2.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const int DEFAULT_SPATIAL_HASH_DIVISIONS = 16;
+inline const float MIN_SPATIAL_HASH_CELL_SIZE = 1;
+
+enum class BroadphaseMode : uint8_t
+{
+    ALL_PAIRS,
+    SPATIAL_HASH,
+    SWEEP_AND_PRUNE
+};
+
+struct CollisionPair
+{
+    uint32_t a;
+    uint32_t b;
+};
+
+struct SweptCollisionHit
+{
+    float time;
+    Vector2 normal;
+};
+
+/**
+ * Smallest rect containing both rects.
+ *
+ * @param a First rect.
+ * @param b Second rect.
+ */
+[[nodiscard]] inline auto UnionRect(const SDL_FRect &a, const SDL_FRect &b)
+    -> SDL_FRect
+{
+    const auto x = std::min(a.x, b.x);
+    const auto y = std::min(a.y, b.y);
+
+    return SDL_FRect{x, y, std::max(a.x + a.w, b.x + b.w) - x,
+                     std::max(a.y + a.h, b.y + b.h) - y};
+}
+
+/**
+ * Swept AABB time of impact test between two moving rects. Both rects move in
+ * a straight line from their previous to their current position over the
+ * frame. Pairs that already overlap at the start of the frame are left to the
+ * discrete test.
+ *
+ * @param previousA Rect A at the start of the frame.
+ * @param currentA Rect A at the end of the frame.
+ * @param previousB Rect B at the start of the frame.
+ * @param currentB Rect B at the end of the frame.
+ * @param hit Time of impact from 0 to 1 and the contact normal facing A.
+ */
+inline auto SweptAABB(const SDL_FRect &previousA, const SDL_FRect &currentA,
+                      const SDL_FRect &previousB, const SDL_FRect &currentB,
+                      SweptCollisionHit &hit) -> bool
+{
+    const auto infinity = std::numeric_limits<float>::infinity();
+
+    const auto dx = (currentA.x - previousA.x) - (currentB.x - previousB.x);
+    const auto dy = (currentA.y - previousA.y) - (currentB.y - previousB.y);
+
+    if (dx == 0 && dy == 0)
+    {
+        return false;
+    }
+
+    const auto axisTimes = [infinity](float minA, float sizeA, float minB,
+                                      float sizeB, float delta, float &entry,
+                                      float &exit)
+    {
+        const auto near = delta > 0 ? minB - (minA + sizeA)
+                                    : (minB + sizeB) - minA;
+        const auto far = delta > 0 ? (minB + sizeB) - minA
+                                   : minB - (minA + sizeA);
+
+        if (delta == 0)
+        {
+            const auto overlapping = minA < minB + sizeB && minB < minA + sizeA;
+
+            entry = overlapping ? -infinity : infinity;
+            exit = overlapping ? infinity : -infinity;
+
+            return;
+        }
+
+        entry = near / delta;
+        exit = far / delta;
+    };
+
+    float xEntry = 0;
+    float xExit = 0;
+    float yEntry = 0;
+    float yExit = 0;
+
+    axisTimes(previousA.x, previousA.w, previousB.x, previousB.w, dx, xEntry,
+              xExit);
+    axisTimes(previousA.y, previousA.h, previousB.y, previousB.h, dy, yEntry,
+              yExit);
+
+    const auto entry = std::max(xEntry, yEntry);
+    const auto exit = std::min(xExit, yExit);
+
+    if (entry >= exit || entry < 0 || entry > 1)
+    {
+        return false;
+    }
+
+    hit.time = entry;
+
+    if (xEntry > yEntry)
+    {
+        hit.normal = Vector2(dx > 0 ? -1 : 1, 0);
+    }
+    else
+    {
+        hit.normal = Vector2(0, dy > 0 ? -1 : 1);
+    }
+
+    return true;
+}
+
+/**
+ * Generate every pair of rects. Kept as a reference for comparing the results
+ * and timings of the other broadphase modes.
+ *
+ * @param rects Transformed rects of each collider.
+ * @param pairs Output list of candidate pairs.
+ */
+inline void FindAllPairs(const std::vector<SDL_FRect> &rects,
+                         std::vector<CollisionPair> &pairs)
+{
+    pairs.clear();
+
+    const auto count = static_cast<uint32_t>(rects.size());
+
+    for (uint32_t i = 0; i + 1 < count; i += 1)
+    {
+        for (uint32_t j = i + 1; j < count; j += 1)
+        {
+            pairs.emplace_back(CollisionPair{i, j});
+        }
+    }
+}
+
+class SpatialHash
+{
+  private:
+    struct CellRange
+    {
+        int minColumn;
+        int minRow;
+        int maxColumn;
+        int maxRow;
+    };
+
+    SDL_FRect bounds = SDL_FRect();
+
+    float cellSize = MIN_SPATIAL_HASH_CELL_SIZE;
+
+    int columns = 1;
+    int rows = 1;
+
+    std::vector<CellRange> cellRanges;
+
+    std::vector<uint32_t> cellStarts;
+    std::vector<uint32_t> cellEntries;
+
+  public:
+    /**
+     * Size the grid to cover the given bounds. Rects outside of the bounds are
+     * clamped into the edge cells.
+     *
+     * @param bounds Area covered by the grid, usually the viewport.
+     * @param divisions Number of cells along the longest side.
+     */
+    void SetBounds(const SDL_FRect &bounds,
+                   int divisions = DEFAULT_SPATIAL_HASH_DIVISIONS)
+    {
+        if (this->bounds.x == bounds.x && this->bounds.y == bounds.y &&
+            this->bounds.w == bounds.w && this->bounds.h == bounds.h)
+        {
+            return;
+        }
+
+        this->bounds = bounds;
+
+        cellSize = std::max(std::max(bounds.w, bounds.h) /
+                                static_cast<float>(std::max(divisions, 1)),
+                            MIN_SPATIAL_HASH_CELL_SIZE);
+
+        columns = std::max(static_cast<int>(std::ceil(bounds.w / cellSize)), 1);
+        rows = std::max(static_cast<int>(std::ceil(bounds.h / cellSize)), 1);
+    }
+
+    [[nodiscard]] auto GetCellSize() const -> float { return cellSize; }
+
+    /**
+     * Find pairs of rects that share at least one cell. Each pair is reported
+     * once, from the cell holding the top left corner of the overlap of both
+     * cell ranges.
+     *
+     * @param rects Transformed rects of each collider.
+     * @param pairs Output list of candidate pairs.
+     */
+    void FindPairs(const std::vector<SDL_FRect> &rects,
+                   std::vector<CollisionPair> &pairs)
+    {
+        pairs.clear();
+
+        const auto count = static_cast<uint32_t>(rects.size());
+
+        const auto cellCount = static_cast<size_t>(columns) * rows;
+
+        cellRanges.resize(count);
+
+        cellStarts.assign(cellCount + 1, 0);
+
+        for (uint32_t i = 0; i < count; i += 1)
+        {
+            const auto &rect = rects[i];
+
+            auto &range = cellRanges[i];
+
+            range.minColumn = ToColumn(rect.x);
+            range.minRow = ToRow(rect.y);
+            range.maxColumn = ToColumn(rect.x + rect.w);
+            range.maxRow = ToRow(rect.y + rect.h);
+
+            for (auto row = range.minRow; row <= range.maxRow; row += 1)
+            {
+                for (auto column = range.minColumn; column <= range.maxColumn;
+                     column += 1)
+                {
+                    cellStarts[(row * columns) + column + 1] += 1;
+                }
+            }
+        }
+
+        for (size_t cell = 1; cell <= cellCount; cell += 1)
+        {
+            cellStarts[cell] += cellStarts[cell - 1];
+        }
+
+        cellEntries.resize(cellStarts[cellCount]);
+
+        for (uint32_t i = 0; i < count; i += 1)
+        {
+            const auto &range = cellRanges[i];
+
+            for (auto row = range.minRow; row <= range.maxRow; row += 1)
+            {
+                for (auto column = range.minColumn; column <= range.maxColumn;
+                     column += 1)
+                {
+                    auto &offset = cellStarts[(row * columns) + column];
+
+                    cellEntries[offset] = i;
+
+                    offset += 1;
+                }
+            }
+        }
+
+        // Filling the entries advanced each start to the start of the next
+        // cell, so the start of cell n is now stored at n - 1.
+
+        for (size_t cell = 0; cell < cellCount; cell += 1)
+        {
+            const auto start = cell == 0 ? 0 : cellStarts[cell - 1];
+            const auto end = cellStarts[cell];
+
+            const auto column = static_cast<int>(cell % columns);
+            const auto row = static_cast<int>(cell / columns);
+
+            for (auto i = start; i < end; i += 1)
+            {
+                const auto a = cellEntries[i];
+
+                for (auto j = i + 1; j < end; j += 1)
+                {
+                    const auto b = cellEntries[j];
+
+                    if (std::max(cellRanges[a].minColumn,
+                                 cellRanges[b].minColumn) == column &&
+                        std::max(cellRanges[a].minRow, cellRanges[b].minRow) ==
+                            row)
+                    {
+                        pairs.emplace_back(CollisionPair{a, b});
+                    }
+                }
+            }
+        }
+    }
+
+  private:
+    [[nodiscard]] auto ToColumn(float x) const -> int
+    {
+        return std::clamp(
+            static_cast<int>(std::floor((x - bounds.x) / cellSize)), 0,
+            columns - 1);
+    }
+
+    [[nodiscard]] auto ToRow(float y) const -> int
+    {
+        return std::clamp(
+            static_cast<int>(std::floor((y - bounds.y) / cellSize)), 0,
+            rows - 1);
+    }
+};
+
+class SweepAndPrune
+{
+  private:
+    std::vector<uint32_t> order;
+
+    std::vector<uint32_t> sortedIds;
+
+    std::vector<uint32_t> addedOrder;
+
+    std::vector<uint32_t> mergedOrder;
+
+    std::unordered_map<uint32_t, uint32_t> slots;
+
+    /**
+     * Carry the sorted order of the last call over to the colliders of this
+     * one by ID, dropping those that were removed. Colliders that weren't
+     * there last time are sorted on their own and merged in, so adding a few
+     * doesn't cost a full insertion sort.
+     */
+    void UpdateOrder(const std::vector<SDL_FRect> &rects,
+                     const std::vector<uint32_t> &ids)
+    {
+        const auto count = static_cast<uint32_t>(rects.size());
+
+        slots.clear();
+
+        addedOrder.clear();
+
+        for (uint32_t i = 0; i < count; i += 1)
+        {
+            // A repeated ID can't be told apart from the first, so it's
+            // sorted in as if it were new.
+
+            if (!slots.emplace(ids[i], i).second)
+            {
+                addedOrder.emplace_back(i);
+            }
+        }
+
+        order.clear();
+
+        for (const auto id : sortedIds)
+        {
+            auto match = slots.find(id);
+
+            if (match != slots.end())
+            {
+                order.emplace_back(match->second);
+
+                slots.erase(match);
+            }
+        }
+
+        for (const auto &slot : slots)
+        {
+            addedOrder.emplace_back(slot.second);
+        }
+
+        const auto isLeftOf = [&rects](uint32_t a, uint32_t b)
+        { return rects[a].x < rects[b].x; };
+
+        InsertionSort(rects);
+
+        std::sort(addedOrder.begin(), addedOrder.end(), isLeftOf);
+
+        mergedOrder.resize(count);
+
+        std::merge(order.begin(), order.end(), addedOrder.begin(),
+                   addedOrder.end(), mergedOrder.begin(), isLeftOf);
+
+        std::swap(order, mergedOrder);
+
+        sortedIds.resize(count);
+
+        for (uint32_t i = 0; i < count; i += 1)
+        {
+            sortedIds[i] = ids[order[i]];
+        }
+    }
+
+    void InsertionSort(const std::vector<SDL_FRect> &rects)
+    {
+        const auto count = static_cast<uint32_t>(order.size());
+
+        for (uint32_t i = 1; i < count; i += 1)
+        {
+            const auto current = order[i];
+            const auto currentX = rects[current].x;
+
+            auto j = i;
+
+            while (j > 0 && rects[order[j - 1]].x > currentX)
+            {
+                order[j] = order[j - 1];
+
+                j -= 1;
+            }
+
+            order[j] = current;
+        }
+    }
+
+  public:
+    /**
+     * Find pairs of rects that overlap on the x axis. The sorted order is kept
+     * between frames by collider ID, so the insertion sort only has to move
+     * the colliders that changed places since the last call, even on frames
+     * where colliders are added or removed.
+     *
+     * @param rects Transformed rects of each collider.
+     * @param ids ID of each collider, unique and stable across calls.
+     * @param pairs Output list of candidate pairs.
+     */
+    void FindPairs(const std::vector<SDL_FRect> &rects,
+                   const std::vector<uint32_t> &ids,
+                   std::vector<CollisionPair> &pairs)
+    {
+        pairs.clear();
+
+        const auto count = static_cast<uint32_t>(rects.size());
+
+        UpdateOrder(rects, ids);
+
+        for (uint32_t i = 0; i < count; i += 1)
+        {
+            const auto a = order[i];
+            const auto right = rects[a].x + rects[a].w;
+
+            for (auto j = i + 1; j < count && rects[order[j]].x < right;
+                 j += 1)
+            {
+                const auto b = order[j];
+
+                pairs.emplace_back(
+                    CollisionPair{std::min(a, b), std::max(a, b)});
+            }
+        }
+    }
+};
+
+} // namespace HandcrankEngine
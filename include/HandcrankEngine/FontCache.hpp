@@ -9,9 +9,15 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
+
 #include <SDL.h>
 #include <SDL_ttf.h>
 
+#include "GlyphAtlas.hpp"
+#include "ResourceCache.hpp"
 #include "Utilities.hpp"
 
 namespace HandcrankEngine
@@ -23,25 +29,51 @@ namespace
 {
 bool fontLoadedForFirstTime = false;
 
-inline std::unordered_map<std::size_t, std::shared_ptr<TTF_Font>> fontCache =
-    std::unordered_map<std::size_t, std::shared_ptr<TTF_Font>>();
+inline std::recursive_mutex fontMutex;
+
+inline ResourceCache<TTF_Font> fontCache = ResourceCache<TTF_Font>();
 } // namespace
 
+/**
+ * SDL_ttf and FreeType aren't thread safe, so every call into them holds
+ * this lock, from opening a font to measuring and drawing text with it.
+ */
+[[nodiscard]] inline auto LockFonts() -> std::unique_lock<std::recursive_mutex>
+{
+    return std::unique_lock<std::recursive_mutex>(fontMutex);
+}
+
+/**
+ * Glyph atlases are keyed by font, so they are released along with the font
+ * rather than when it leaves the cache, which it can do while still in use.
+ * A font opened later at the same address then can't find them.
+ */
 struct FontDeleter
 {
     void operator()(TTF_Font *font) const
     {
         if (font != nullptr)
         {
+            const auto lock = LockFonts();
+
+            ReleaseGlyphAtlases(font);
+
             TTF_CloseFont(font);
         }
     }
 };
 
-inline auto ClearFontCache() -> void { fontCache.clear(); }
+/**
+ * Fonts shared by every game in the process.
+ */
+inline auto GetFontCache() -> ResourceCache<TTF_Font> & { return fontCache; }
+
+inline auto ClearFontCache() -> void { fontCache.Clear(); }
 
 inline auto CleanupFontInits() -> void
 {
+    const auto lock = LockFonts();
+
     for (auto i = 0; i < TTF_WasInit(); i += 1)
     {
         TTF_Quit();
@@ -49,34 +81,54 @@ inline auto CleanupFontInits() -> void
 }
 
 /**
- * Load font from a path.
+ * Cache key suffix for a font point size.
  *
- * @param path File path to font file.
  * @param ptSize The size of the font.
  */
-inline auto LoadCachedFont(const char *path, int ptSize = DEFAULT_FONT_SIZE)
-    -> TTF_Font *
+[[nodiscard]] inline auto FontSizeParams(int ptSize) -> std::string
 {
-    auto cacheKey = std::hash<std::string_view>{}(std::string_view(path)) ^
-                    std::hash<int>{}(ptSize);
+    return "|ptSize:" + std::to_string(ptSize);
+}
 
-    auto match = fontCache.find(cacheKey);
+inline auto SetupFonts() -> void
+{
+    const auto lock = LockFonts();
 
-    if (match != fontCache.end())
+    if (fontLoadedForFirstTime)
     {
-        return match->second.get();
+        return;
     }
 
-    if (!fontLoadedForFirstTime)
+    if (TTF_WasInit() == 0)
     {
-        if (TTF_WasInit() == 0)
-        {
-            TTF_Init();
-        }
+        TTF_Init();
+    }
+
+    fontLoadedForFirstTime = true;
+}
+
+/**
+ * Load font from a path.
+ *
+ * @param path File path to font file.
+ * @param ptSize The size of the font.
+ */
+inline auto LoadCachedFont(const char *path, int ptSize = DEFAULT_FONT_SIZE)
+    -> std::shared_ptr<TTF_Font>
+{
+    const auto cacheKey = ResourcePathKey(path) + FontSizeParams(ptSize);
+
+    // Held from the lookup to the insert so two threads don't both open it.
 
-        fontLoadedForFirstTime = true;
+    const auto lock = LockFonts();
+
+    if (auto match = fontCache.Find(cacheKey))
+    {
+        return match;
     }
 
+    SetupFonts();
+
     auto font =
         std::shared_ptr<TTF_Font>(TTF_OpenFont(path, ptSize), FontDeleter{});
 
@@ -85,9 +137,9 @@ inline auto LoadCachedFont(const char *path, int ptSize = DEFAULT_FONT_SIZE)
         return nullptr;
     }
 
-    fontCache.insert_or_assign(cacheKey, font);
+    fontCache.Insert(cacheKey, font, GetFileBytes(path));
 
-    return font.get();
+    return font;
 }
 
 /**
@@ -98,47 +150,87 @@ inline auto LoadCachedFont(const char *path, int ptSize = DEFAULT_FONT_SIZE)
  * @param ptSize The size of the font.
  */
 inline auto LoadCachedFont(const void *mem, int size,
-                           int ptSize = DEFAULT_FONT_SIZE) -> TTF_Font *
+                           int ptSize = DEFAULT_FONT_SIZE)
+    -> std::shared_ptr<TTF_Font>
 {
-    auto cacheKey = MemHash(mem, size) ^ std::hash<int>{}(ptSize);
+    const auto cacheKey = ResourceMemKey(mem, size) + FontSizeParams(ptSize);
 
-    auto match = fontCache.find(cacheKey);
+    const auto lock = LockFonts();
+
+    if (auto match = fontCache.Find(cacheKey))
+    {
+        return match;
+    }
+
+    SetupFonts();
+
+    auto *rw = SDL_RWFromConstMem(mem, size);
+
+    if (rw == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto font =
+        std::shared_ptr<TTF_Font>(TTF_OpenFontRW(rw, 1, ptSize), FontDeleter{});
 
-    if (match != fontCache.end())
+    if (font == nullptr)
     {
-        return match->second.get();
+        return nullptr;
     }
 
-    if (!fontLoadedForFirstTime)
+    fontCache.Insert(cacheKey, font, size);
+
+    return font;
+}
+
+/**
+ * Load font from a stream, which is closed along with the font. The cache key
+ * stands in for a path, so the stream is only read on a cache miss.
+ *
+ * @param key Cache key of the font, unique to the stream contents.
+ * @param rw A read-only stream that stays valid while the font is in use,
+ * which can be nullptr when the font is already cached.
+ * @param ptSize The size of the font.
+ */
+inline auto LoadCachedFont(const std::string &key, SDL_RWops *rw,
+                           int ptSize = DEFAULT_FONT_SIZE)
+    -> std::shared_ptr<TTF_Font>
+{
+    const auto cacheKey = key + FontSizeParams(ptSize);
+
+    const auto lock = LockFonts();
+
+    if (auto match = fontCache.Find(cacheKey))
     {
-        if (TTF_WasInit() == 0)
+        if (rw != nullptr)
         {
-            TTF_Init();
+            SDL_RWclose(rw);
         }
 
-        fontLoadedForFirstTime = true;
+        return match;
     }
 
-    auto *rw = SDL_RWFromConstMem(mem, size);
-
     if (rw == nullptr)
     {
         return nullptr;
     }
 
+    SetupFonts();
+
+    const auto size = SDL_RWsize(rw);
+
     auto font =
         std::shared_ptr<TTF_Font>(TTF_OpenFontRW(rw, 1, ptSize), FontDeleter{});
 
     if (font == nullptr)
     {
-        SDL_RWclose(rw);
-
         return nullptr;
     }
 
-    fontCache.insert_or_assign(cacheKey, font);
+    fontCache.Insert(cacheKey, font, size > 0 ? static_cast<size_t>(size) : 0);
 
-    return font.get();
+    return font;
 }
 
 } // namespace HandcrankEngine
@@ -0,0 +1,346 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include <SDL.h>
+
+namespace HandcrankEngine
+{
+
+inline const double DEFAULT_FRAME_PACER_SPIN_TIME = 0.002;
+
+/**
+ * A vsynced frame that took less than this, present included, wasn't held
+ * back by the display, so the driver is likely ignoring vsync.
+ */
+inline const double FRAME_PACER_VSYNC_FALLBACK_TIME = 0.001;
+
+/**
+ * With vsync, an average frame time under this fraction of the display refresh
+ * interval means present isn't blocking, so frames are paced to the refresh
+ * rate instead.
+ */
+inline const double FRAME_PACER_VSYNC_FALLBACK_RATIO = 0.5;
+
+inline const size_t FRAME_PACER_SAMPLE_COUNT = 120;
+
+enum class FramePacingMode : uint8_t
+{
+    VSYNC,
+    TARGET_FRAME_RATE,
+    UNCAPPED
+};
+
+class FramePacer
+{
+  private:
+    FramePacingMode mode = FramePacingMode::VSYNC;
+
+    double targetFrameRate = 0;
+
+    double displayRefreshRate = 0;
+
+    bool isVsyncFallback = false;
+
+    double spinTime = DEFAULT_FRAME_PACER_SPIN_TIME;
+
+    Uint64 frameStart = 0;
+    Uint64 nextFrameDeadline = 0;
+
+    double deltaTime = 0;
+
+    double frameTimestamp = -1;
+
+    std::array<double, FRAME_PACER_SAMPLE_COUNT> samples{};
+    size_t sampleCount = 0;
+    size_t sampleIndex = 0;
+
+    void AddSample(double frameTime)
+    {
+        if (frameTime <= 0)
+        {
+            return;
+        }
+
+        samples[sampleIndex] = frameTime;
+
+        sampleIndex = (sampleIndex + 1) % FRAME_PACER_SAMPLE_COUNT;
+        sampleCount = std::min(sampleCount + 1, FRAME_PACER_SAMPLE_COUNT);
+    }
+
+    /**
+     * Sleep, then spin, until the next frame at a rate is due.
+     *
+     * @param frameRate Frames per second.
+     */
+    void WaitForDeadline(double frameRate)
+    {
+        const auto frequency = SDL_GetPerformanceFrequency();
+
+        const auto frameTicks =
+            static_cast<Uint64>(static_cast<double>(frequency) / frameRate);
+
+        nextFrameDeadline =
+            (nextFrameDeadline == 0 ? frameStart : nextFrameDeadline) +
+            frameTicks;
+
+        auto now = SDL_GetPerformanceCounter();
+
+        if (now >= nextFrameDeadline)
+        {
+            if (now - nextFrameDeadline > frameTicks)
+            {
+                nextFrameDeadline = now;
+            }
+
+            return;
+        }
+
+        const auto remaining =
+            (nextFrameDeadline - now) / static_cast<double>(frequency);
+
+        if (remaining > spinTime)
+        {
+            SDL_Delay(static_cast<Uint32>((remaining - spinTime) * 1000));
+        }
+
+        while (SDL_GetPerformanceCounter() < nextFrameDeadline)
+        {
+        }
+    }
+
+  public:
+    [[nodiscard]] auto GetMode() const -> FramePacingMode { return mode; }
+    void SetMode(FramePacingMode mode)
+    {
+        this->mode = mode;
+
+        nextFrameDeadline = 0;
+
+        isVsyncFallback = false;
+        sampleCount = 0;
+    }
+
+    [[nodiscard]] auto GetTargetFrameRate() const -> double
+    {
+        return targetFrameRate;
+    }
+    void SetTargetFrameRate(double targetFrameRate)
+    {
+        this->targetFrameRate = targetFrameRate;
+
+        nextFrameDeadline = 0;
+    }
+
+    [[nodiscard]] auto GetDisplayRefreshRate() const -> double
+    {
+        return displayRefreshRate;
+    }
+
+    /**
+     * Refresh rate of the display the window is on, used to tell whether
+     * vsync is being honored. Zero when it isn't known.
+     *
+     * @param refreshRate Refresh rate in Hz.
+     */
+    void SetDisplayRefreshRate(double refreshRate)
+    {
+        if (refreshRate == displayRefreshRate)
+        {
+            return;
+        }
+
+        displayRefreshRate = refreshRate;
+
+        nextFrameDeadline = 0;
+
+        isVsyncFallback = false;
+        sampleCount = 0;
+    }
+
+    /**
+     * Whether vsync was requested but present isn't blocking, so frames are
+     * paced to the display refresh rate instead.
+     */
+    [[nodiscard]] auto IsVsyncFallback() const -> bool
+    {
+        return isVsyncFallback;
+    }
+
+    /**
+     * How long before the deadline to stop sleeping and start spinning.
+     * SDL_Delay can oversleep by a millisecond or more depending on the
+     * platform, so the last stretch is waited out on the performance counter.
+     *
+     * @param spinTime Time in seconds.
+     */
+    void SetSpinTime(double spinTime) { this->spinTime = spinTime; }
+
+    [[nodiscard]] auto GetFrameStart() const -> Uint64 { return frameStart; }
+
+    [[nodiscard]] auto GetDeltaTime() const -> double { return deltaTime; }
+
+    /**
+     * Mark the start of a frame and measure the time since the start of the
+     * previous one, which includes the previous present and wait.
+     */
+    auto BeginFrame() -> double
+    {
+        const auto now = SDL_GetPerformanceCounter();
+        const auto frequency = SDL_GetPerformanceFrequency();
+
+        deltaTime = frameStart == 0 ? 0
+                                    : (now - frameStart) /
+                                          static_cast<double>(frequency);
+
+        frameStart = now;
+
+        AddSample(deltaTime);
+
+        return deltaTime;
+    }
+
+    /**
+     * Mark the start of a frame at a timestamp given by the platform, such as
+     * the one requestAnimationFrame passes to its callback. Those are aligned
+     * to the display refresh, so the time between frames follows the display
+     * instead of whenever the callback happened to run.
+     *
+     * @param timestamp Time of the frame in seconds.
+     */
+    auto BeginFrame(double timestamp) -> double
+    {
+        deltaTime = frameTimestamp < 0 || timestamp < frameTimestamp
+                        ? 0
+                        : timestamp - frameTimestamp;
+
+        frameTimestamp = timestamp;
+
+        frameStart = SDL_GetPerformanceCounter();
+
+        AddSample(deltaTime);
+
+        return deltaTime;
+    }
+
+    /**
+     * Wait until the next frame is due when targeting a frame rate. Deadlines
+     * advance by a whole frame each time so rounding doesn't drift the rate,
+     * and reset when the game falls more than a frame behind.
+     *
+     * With vsync, present does the waiting. Once a full set of samples
+     * averages well under the display refresh interval, present isn't
+     * blocking and frames are paced to the refresh rate as if targeting it.
+     * Until then, or when the refresh rate isn't known, a frame that returns
+     * straight away sleeps for a millisecond instead of spinning the CPU.
+     */
+    void WaitForNextFrame()
+    {
+        // The browser paces frames with requestAnimationFrame, waiting here
+        // would only block the main thread.
+
+#ifndef __EMSCRIPTEN__
+        if (mode == FramePacingMode::VSYNC)
+        {
+            if (!isVsyncFallback && displayRefreshRate > 0 &&
+                sampleCount == FRAME_PACER_SAMPLE_COUNT &&
+                GetAverageFrameTime() <
+                    FRAME_PACER_VSYNC_FALLBACK_RATIO / displayRefreshRate)
+            {
+                SDL_Log("Present isn't waiting for vsync, pacing frames to "
+                        "%.0f Hz",
+                        displayRefreshRate);
+
+                isVsyncFallback = true;
+
+                nextFrameDeadline = 0;
+            }
+
+            if (isVsyncFallback)
+            {
+                WaitForDeadline(displayRefreshRate);
+
+                return;
+            }
+
+            const auto frequency = SDL_GetPerformanceFrequency();
+
+            const auto elapsed = (SDL_GetPerformanceCounter() - frameStart) /
+                                 static_cast<double>(frequency);
+
+            if (elapsed < FRAME_PACER_VSYNC_FALLBACK_TIME)
+            {
+                SDL_Delay(1);
+            }
+
+            return;
+        }
+
+        if (mode != FramePacingMode::TARGET_FRAME_RATE || targetFrameRate <= 0)
+        {
+            return;
+        }
+
+        WaitForDeadline(targetFrameRate);
+#endif
+    }
+
+    /**
+     * Average time between frames over the recent samples, in seconds.
+     */
+    [[nodiscard]] auto GetAverageFrameTime() const -> double
+    {
+        if (sampleCount == 0)
+        {
+            return 0;
+        }
+
+        double total = 0;
+
+        for (size_t i = 0; i < sampleCount; i += 1)
+        {
+            total += samples[i];
+        }
+
+        return total / static_cast<double>(sampleCount);
+    }
+
+    /**
+     * Standard deviation of the time between frames over the recent samples,
+     * in seconds. Smooth pacing keeps this close to zero.
+     */
+    [[nodiscard]] auto GetFrameTimeJitter() const -> double
+    {
+        if (sampleCount < 2)
+        {
+            return 0;
+        }
+
+        const auto average = GetAverageFrameTime();
+
+        double variance = 0;
+
+        for (size_t i = 0; i < sampleCount; i += 1)
+        {
+            const auto difference = samples[i] - average;
+
+            variance += difference * difference;
+        }
+
+        return std::sqrt(variance / static_cast<double>(sampleCount));
+    }
+};
+
+} // namespace HandcrankEngine
@@ -0,0 +1,301 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include "TextureCache.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const Uint16 GLYPH_ATLAS_FIRST_CHARACTER = 32;
+inline const Uint16 GLYPH_ATLAS_LAST_CHARACTER = 126;
+inline const int GLYPH_ATLAS_WIDTH = 512;
+inline const int GLYPH_ATLAS_PADDING = 1;
+
+/**
+ * Printable ASCII characters of a single font rasterized once into one
+ * texture. Text drawn with the atlas is a list of textured quads, so changing
+ * the text doesn't rasterize or upload anything.
+ */
+class GlyphAtlas
+{
+  private:
+    static const size_t glyphCount =
+        GLYPH_ATLAS_LAST_CHARACTER - GLYPH_ATLAS_FIRST_CHARACTER + 1;
+
+    std::shared_ptr<SDL_Texture> texture;
+
+    int textureWidth = 0;
+    int textureHeight = 0;
+
+    std::array<SDL_FRect, glyphCount> srcRects{};
+
+  public:
+    [[nodiscard]] static auto HasGlyph(char character) -> bool
+    {
+        const auto code = static_cast<unsigned char>(character);
+
+        return code >= GLYPH_ATLAS_FIRST_CHARACTER &&
+               code <= GLYPH_ATLAS_LAST_CHARACTER;
+    }
+
+    /**
+     * Rasterize every glyph and upload them as one texture. Each glyph is
+     * rendered on its own so its rect matches the advance of the character
+     * and the full height of the font.
+     *
+     * @param renderer A structure representing rendering state.
+     * @param font Font to rasterize.
+     */
+    auto Build(SDL_Renderer *renderer, TTF_Font *font) -> bool
+    {
+        std::array<SDL_Surface *, glyphCount> surfaces{};
+
+        int x = 0;
+        int y = 0;
+        int rowHeight = 0;
+
+        for (size_t i = 0; i < glyphCount; i += 1)
+        {
+            const auto character =
+                static_cast<Uint16>(GLYPH_ATLAS_FIRST_CHARACTER + i);
+
+            surfaces[i] = TTF_RenderGlyph_Blended(
+                font, character, SDL_Color{255, 255, 255, 255});
+
+            if (surfaces[i] == nullptr)
+            {
+                continue;
+            }
+
+            if (x + surfaces[i]->w > GLYPH_ATLAS_WIDTH)
+            {
+                x = 0;
+                y += rowHeight + GLYPH_ATLAS_PADDING;
+                rowHeight = 0;
+            }
+
+            srcRects[i] =
+                SDL_FRect{static_cast<float>(x), static_cast<float>(y),
+                          static_cast<float>(surfaces[i]->w),
+                          static_cast<float>(surfaces[i]->h)};
+
+            x += surfaces[i]->w + GLYPH_ATLAS_PADDING;
+            rowHeight = std::max(rowHeight, surfaces[i]->h);
+        }
+
+        textureWidth = GLYPH_ATLAS_WIDTH;
+        textureHeight = std::max(y + rowHeight, 1);
+
+        auto *atlasSurface = SDL_CreateRGBSurfaceWithFormat(
+            0, textureWidth, textureHeight, 32, SDL_PIXELFORMAT_RGBA32);
+
+        if (atlasSurface != nullptr)
+        {
+            SDL_FillRect(atlasSurface, nullptr,
+                         SDL_MapRGBA(atlasSurface->format, 255, 255, 255, 0));
+        }
+
+        for (size_t i = 0; i < glyphCount; i += 1)
+        {
+            if (surfaces[i] == nullptr)
+            {
+                continue;
+            }
+
+            if (atlasSurface != nullptr)
+            {
+                SDL_Rect destRect{static_cast<int>(srcRects[i].x),
+                                  static_cast<int>(srcRects[i].y),
+                                  surfaces[i]->w, surfaces[i]->h};
+
+                SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+
+                SDL_BlitSurface(surfaces[i], nullptr, atlasSurface, &destRect);
+            }
+
+            SDL_FreeSurface(surfaces[i]);
+        }
+
+        if (atlasSurface == nullptr)
+        {
+            return false;
+        }
+
+        texture = std::shared_ptr<SDL_Texture>(
+            SDL_CreateTextureFromSurface(renderer, atlasSurface),
+            TextureDeleter());
+
+        SDL_FreeSurface(atlasSurface);
+
+        if (texture == nullptr)
+        {
+            return false;
+        }
+
+        SDL_SetTextureBlendMode(texture.get(), SDL_BLENDMODE_BLEND);
+
+        return true;
+    }
+
+    [[nodiscard]] auto GetTexture() const -> SDL_Texture *
+    {
+        return texture.get();
+    }
+
+    [[nodiscard]] auto GetTextureWidth() const -> float
+    {
+        return static_cast<float>(textureWidth);
+    }
+
+    [[nodiscard]] auto GetTextureHeight() const -> float
+    {
+        return static_cast<float>(textureHeight);
+    }
+
+    /**
+     * Rect of a character in the atlas texture. Only valid for characters
+     * where HasGlyph is true.
+     *
+     * @param character Character to look up.
+     */
+    [[nodiscard]] auto GetSrcRect(char character) const -> const SDL_FRect &
+    {
+        return srcRects[static_cast<unsigned char>(character) -
+                        GLYPH_ATLAS_FIRST_CHARACTER];
+    }
+};
+
+namespace
+{
+inline std::mutex glyphAtlasCacheMutex;
+
+inline std::map<std::pair<TTF_Font *, SDL_Renderer *>,
+                std::shared_ptr<GlyphAtlas>>
+    glyphAtlasCache =
+        std::map<std::pair<TTF_Font *, SDL_Renderer *>,
+                 std::shared_ptr<GlyphAtlas>>();
+} // namespace
+
+inline auto ClearGlyphAtlasCache() -> void
+{
+    std::map<std::pair<TTF_Font *, SDL_Renderer *>, std::shared_ptr<GlyphAtlas>>
+        released;
+
+    std::lock_guard<std::mutex> lock(glyphAtlasCacheMutex);
+
+    std::swap(glyphAtlasCache, released);
+}
+
+/**
+ * Drop the atlases built from a font, for when the font is closed.
+ *
+ * @param font Font the atlases were built from.
+ */
+inline auto ReleaseGlyphAtlases(TTF_Font *font) -> void
+{
+    std::vector<std::shared_ptr<GlyphAtlas>> released;
+
+    std::lock_guard<std::mutex> lock(glyphAtlasCacheMutex);
+
+    for (auto iter = glyphAtlasCache.begin(); iter != glyphAtlasCache.end();)
+    {
+        if (iter->first.first != font)
+        {
+            iter = std::next(iter);
+
+            continue;
+        }
+
+        released.emplace_back(std::move(iter->second));
+
+        iter = glyphAtlasCache.erase(iter);
+    }
+}
+
+/**
+ * Drop the atlases uploaded to a renderer, for when the renderer is destroyed.
+ *
+ * @param renderer Renderer the atlases were uploaded to.
+ */
+inline auto ReleaseGlyphAtlases(SDL_Renderer *renderer) -> void
+{
+    std::vector<std::shared_ptr<GlyphAtlas>> released;
+
+    std::lock_guard<std::mutex> lock(glyphAtlasCacheMutex);
+
+    for (auto iter = glyphAtlasCache.begin(); iter != glyphAtlasCache.end();)
+    {
+        if (iter->first.second != renderer)
+        {
+            iter = std::next(iter);
+
+            continue;
+        }
+
+        released.emplace_back(std::move(iter->second));
+
+        iter = glyphAtlasCache.erase(iter);
+    }
+}
+
+/**
+ * Get the glyph atlas of a font, building it on first use. Fonts are cached
+ * per path and point size, so the atlas is too. Returns nullptr when the
+ * atlas can't be built. Call with the fonts locked, see LockFonts.
+ *
+ * @param renderer A structure representing rendering state.
+ * @param font Font to rasterize.
+ */
+inline auto LoadCachedGlyphAtlas(SDL_Renderer *renderer, TTF_Font *font)
+    -> std::shared_ptr<GlyphAtlas>
+{
+    const auto cacheKey = std::make_pair(font, renderer);
+
+    {
+        std::lock_guard<std::mutex> lock(glyphAtlasCacheMutex);
+
+        auto match = glyphAtlasCache.find(cacheKey);
+
+        if (match != glyphAtlasCache.end())
+        {
+            return match->second;
+        }
+    }
+
+    auto glyphAtlas = std::make_shared<GlyphAtlas>();
+
+    // Failed builds are cached too so they aren't retried every frame.
+
+    if (!glyphAtlas->Build(renderer, font))
+    {
+        glyphAtlas = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(glyphAtlasCacheMutex);
+
+    glyphAtlasCache.insert_or_assign(cacheKey, glyphAtlas);
+
+    return glyphAtlas;
+}
+
+} // namespace HandcrankEngine
@@ -13,22 +13,53 @@
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#include <emscripten/html5.h>
+#endif
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define HANDCRANK_ENGINE_THREADED_SIMULATION 1
 #endif
 
 #define HANDCRANK_ENGINE_VERSION_MAJOR 0
 #define HANDCRANK_ENGINE_VERSION_MINOR 0
 #define HANDCRANK_ENGINE_VERSION_PATCH 0
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
+#include "AssetLoader.hpp"
 #include "AudioCache.hpp"
+#include "BinaryStream.hpp"
+#include "Collision.hpp"
 #include "FontCache.hpp"
+#include "FramePacer.hpp"
+#include "GlyphAtlas.hpp"
+#include "ObjectPool.hpp"
+#include "ObjectRegistry.hpp"
+#include "Profiler.hpp"
+#include "RenderBatch.hpp"
+#include "RenderCommandBuffer.hpp"
 #include "TextureCache.hpp"
+#include "TransformStore.hpp"
 
 #include "InputHandler.hpp"
+#include "InputLog.hpp"
 #include "Utilities.hpp"
 #include "Vector2.hpp"
 
@@ -45,14 +76,43 @@ inline const SDL_Color DEFAULT_COLOR = {MAX_R, MAX_G, MAX_B, MAX_ALPHA};
 inline const double MILLISECONDS = 1000.0;
 
 inline const double DEFAULT_FRAME_RATE = 60;
+inline const double DEFAULT_IDLE_FRAME_RATE = 10;
+inline const double DEFAULT_FIXED_FRAME_RATE = 50;
+inline const int DEFAULT_MAX_FIXED_STEPS_PER_FRAME = 5;
 inline const int DEFAULT_WINDOW_WIDTH = 800;
 inline const int DEFAULT_WINDOW_HEIGHT = 600;
 inline const float DEFAULT_RECT_WIDTH = 100;
 inline const float DEFAULT_RECT_HEIGHT = 100;
 
+inline const Uint32 DEFAULT_COLLISION_LAYER = 0x00000001;
+inline const Uint32 DEFAULT_COLLISION_MASK = 0xFFFFFFFF;
+
+inline const int RENDER_ORDER_INSERTION_SORT_LIMIT = 8;
+
 class Game;
 class RenderObject;
 
+inline void
+SortRenderOrder(const std::vector<std::shared_ptr<RenderObject>> &buffer,
+                std::vector<uint32_t> &order, bool &orderIsDirty,
+                int &orderChanges);
+
+enum class CollisionContactState : uint8_t
+{
+    ENTER,
+    STAY,
+    EXIT
+};
+
+struct CollisionContact
+{
+    Uint64 key;
+    RenderObject *a;
+    RenderObject *b;
+    bool isSwept;
+    SweptCollisionHit hit;
+};
+
 enum class RectAnchor : uint8_t
 {
     TOP = 0x01,
@@ -75,19 +135,129 @@ enum class RectAnchor : uint8_t
                                    static_cast<uint8_t>(b));
 }
 
-inline std::shared_ptr<SDL_Texture> debugRectTexture;
+enum class GameMode : uint8_t
+{
+    WINDOWED,
+    OFFSCREEN,
+    HEADLESS
+};
+
+/**
+ * When a windowed game may stop rendering and sleep until something happens.
+ * NEVER renders every frame. UNFOCUSED slows the loop down to the idle frame
+ * rate while the window doesn't have focus, rendering only frames that
+ * changed. UNCHANGED also sleeps while focused, whenever a frame has no input
+ * and nothing in the scene changed.
+ */
+enum class IdlePolicy : uint8_t
+{
+    NEVER,
+    UNFOCUSED,
+    UNCHANGED
+};
+
+/**
+ * Whether a game is writing its input to an InputLog each frame, or reading
+ * it back from one in place of the keyboard, mouse and controllers.
+ */
+enum class InputLogMode : uint8_t
+{
+    NONE,
+    RECORD,
+    REPLAY
+};
+
+/**
+ * Games alive in the process. The texture, font and audio caches are shared
+ * by every game, each locked so games can run on several threads, and
+ * released by the last one to go.
+ */
+inline std::atomic<int> activeGameCount = 0;
+
+/**
+ * Held while a game sets up or shuts down SDL, so a game being created can't
+ * race the last one releasing the caches and quitting SDL.
+ */
+inline std::mutex gameLifetimeMutex;
+
+/**
+ * Number of children that aren't null, which is how many subtrees a snapshot
+ * holds for them.
+ *
+ * @param children Children of a game or object.
+ */
+template <typename T>
+[[nodiscard]] inline auto
+CountSerializedChildren(const std::vector<std::shared_ptr<T>> &children)
+    -> uint32_t
+{
+    return static_cast<uint32_t>(
+        std::count_if(children.begin(), children.end(),
+                      [](const std::shared_ptr<T> &child)
+                      { return child != nullptr; }));
+}
+
+/**
+ * Engine-wide work that runs once per frame instead of once per object, such
+ * as TweenSystem. Each game creates one of each system on first use through
+ * Game::GetSystem, and updates them in that order after Update.
+ */
+class GameSystem
+{
+  protected:
+    Game *game = nullptr;
+
+  public:
+    virtual ~GameSystem() = default;
+
+    void SetGame(Game *game) { this->game = game; }
+
+    virtual void Update(double deltaTime) = 0;
+
+    /**
+     * Whether Game::Resimulate updates the system. Off by default, as a
+     * system whose state isn't in the snapshot, or that plays sounds, would
+     * otherwise run again for every frame rolled back.
+     */
+    [[nodiscard]] virtual auto IsResimulated() const -> bool { return false; }
+
+    /**
+     * Drop any state, called when the game is destroyed.
+     */
+    virtual void Clear() {}
+};
 
 class Game : public InputHandler
 {
   private:
+    GameMode mode = GameMode::WINDOWED;
+
+    Uint32 initializedSubsystems = 0;
+
     SDL_Window *window = nullptr;
     SDL_Renderer *renderer = nullptr;
 
+    SDL_Surface *offscreenSurface = nullptr;
+
     SDL_Rect viewport{};
     SDL_FRect viewportf{};
 
     SDL_Color clearColor{0, 0, 0, MAX_ALPHA};
 
+    RenderBatch renderBatch;
+
+    AssetLoader assetLoader;
+
+    ObjectRegistry objectRegistry;
+
+    TransformStore transformStore;
+
+    std::unordered_map<std::type_index, std::unique_ptr<ObjectPoolBase>>
+        objectPools;
+
+    std::unordered_map<std::type_index, std::unique_ptr<GameSystem>> systems;
+    std::vector<GameSystem *> systemOrder;
+
     bool quit = false;
 
     bool fullscreen = false;
@@ -95,33 +265,105 @@ class Game : public InputHandler
     std::vector<std::shared_ptr<RenderObject>> children;
     std::vector<std::shared_ptr<RenderObject>> childrenBuffer;
 
+    bool childrenBufferIsDirty = true;
+    bool descendantChildrenBufferIsDirty = true;
+
+    std::vector<uint32_t> renderOrder;
+    bool renderOrderIsDirty = true;
+    int renderOrderChanges = 0;
+
+    std::mt19937 randomGenerator{std::random_device()()};
+
+    uint32_t nextObjectId = 1;
+
     std::vector<std::shared_ptr<RenderObject>> colliders;
+    std::vector<std::shared_ptr<RenderObject>> removedColliders;
+
+    std::vector<CollisionContact> contacts;
+    std::vector<CollisionContact> previousContacts;
+
+    BroadphaseMode broadphaseMode = BroadphaseMode::SWEEP_AND_PRUNE;
+
+    std::vector<SDL_FRect> colliderRects;
+    std::vector<SDL_FRect> colliderPreviousRects;
+    std::vector<SDL_FRect> colliderBounds;
+    std::vector<uint32_t> colliderIds;
+    std::vector<Uint8> colliderContinuous;
+    std::vector<Uint32> colliderLayers;
+    std::vector<Uint32> colliderMasks;
+    std::vector<CollisionPair> collisionPairs;
+
+    SpatialHash spatialHash;
+    SweepAndPrune sweepAndPrune;
 
     double elapsedTime = 0;
     double deltaTime = 0;
     double fixedUpdateDeltaTime = 0;
+    double fixedUpdateAlpha = 0;
 
     double frameRate = DEFAULT_FRAME_RATE;
 
+    FramePacer framePacer;
+
     Uint64 previousFrameStart = 0;
     double fps = 0;
     int framesThisSecond = 0;
 
-    const double fixedFrameTime = 0.02;
+    double fixedFrameTime = 1 / DEFAULT_FIXED_FRAME_RATE;
+
+    int maxFixedStepsPerFrame = DEFAULT_MAX_FIXED_STEPS_PER_FRAME;
 
     int width = DEFAULT_WINDOW_WIDTH;
     int height = DEFAULT_WINDOW_HEIGHT;
 
     bool focused = false;
 
+    IdlePolicy idlePolicy = IdlePolicy::NEVER;
+
+    double idleFrameRate = DEFAULT_IDLE_FRAME_RATE;
+
+    bool frameRequested = true;
+    Uint64 scheduledFrame = 0;
+
+    bool isIdle = false;
+
+    InputLog *inputLog = nullptr;
+    InputLogMode inputLogMode = InputLogMode::NONE;
+
+    bool isResimulating = false;
+
+#ifdef HANDCRANK_ENGINE_THREADED_SIMULATION
+    bool isThreadedSimulation = false;
+
+    std::thread simulationThread;
+
+    std::mutex simulationMutex;
+    std::condition_variable simulationCondition;
+
+    bool simulationRequested = false;
+    bool simulationFinished = false;
+    bool simulationStopping = false;
+
+    std::exception_ptr simulationException;
+
+    std::array<RenderCommandBuffer, 2> renderCommandBuffers;
+    size_t renderCommandBufferIndex = 0;
+#endif
+
 #ifdef HANDCRANK_ENGINE_DEBUG
     bool debug = false;
+
+    std::shared_ptr<SDL_Texture> debugRectTexture;
 #endif
 
   public:
     inline Game();
+    explicit inline Game(GameMode mode);
     virtual inline ~Game();
 
+    [[nodiscard]] inline auto GetMode() const -> GameMode;
+    [[nodiscard]] inline auto IsHeadless() const -> bool;
+
     inline void AddChildObject(const std::shared_ptr<RenderObject> &child);
 
     template <typename T>
@@ -132,10 +374,42 @@ class Game : public InputHandler
         -> std::shared_ptr<T>;
     [[nodiscard]] inline auto GetChildCount() -> int;
 
+    template <typename T>
+    [[nodiscard]] inline auto FindAllByType() const -> ObjectView<T>;
+    template <typename T>
+    [[nodiscard]] inline auto FindByType() const -> std::shared_ptr<T>;
+    [[nodiscard]] inline auto FindAllByTag(const std::string &tag) const
+        -> ObjectView<RenderObject>;
+    [[nodiscard]] inline auto FindByTag(const std::string &tag) const
+        -> std::shared_ptr<RenderObject>;
+    [[nodiscard]] inline auto FindAllByName(const std::string &name) const
+        -> ObjectView<RenderObject>;
+    [[nodiscard]] inline auto FindByName(const std::string &name) const
+        -> std::shared_ptr<RenderObject>;
+
+    [[nodiscard]] inline auto GetObjectRegistry() -> ObjectRegistry &;
+
+    template <typename T>
+    [[nodiscard]] inline auto GetObjectPool() -> ObjectPool<T> &;
+    template <typename T>
+    [[nodiscard]] inline auto Spawn() -> std::shared_ptr<T>;
+    [[nodiscard]] inline auto GetObjectPoolStats() const
+        -> std::vector<ObjectPoolStats>;
+
+    template <typename T>
+    [[nodiscard]] inline auto GetSystem() -> T &;
+
     inline void AddCollider(const std::shared_ptr<RenderObject> &collider);
 
+    [[nodiscard]] inline auto GetBroadphaseMode() const -> BroadphaseMode;
+    inline void SetBroadphaseMode(BroadphaseMode broadphaseMode);
+
     [[nodiscard]] inline auto GetWindow() -> SDL_Window *;
     [[nodiscard]] inline auto GetRenderer() -> SDL_Renderer *;
+    [[nodiscard]] inline auto GetRenderBatch() -> RenderBatch &;
+    [[nodiscard]] inline auto GetTransformStore() -> TransformStore &;
+    inline void FlushRenderBatch();
+    [[nodiscard]] inline auto GetAssetLoader() -> AssetLoader &;
     [[nodiscard]] inline auto GetViewport() const -> const SDL_FRect &;
 
     inline auto SwitchToFullscreen() -> bool;
@@ -165,37 +439,125 @@ class Game : public InputHandler
 
     inline void SetFrameRate(double frameRate);
 
+    [[nodiscard]] inline auto GetFramePacingMode() const -> FramePacingMode;
+    inline void SetFramePacingMode(FramePacingMode mode);
+
+    [[nodiscard]] inline auto GetFramePacer() -> FramePacer &;
+
+    [[nodiscard]] inline auto GetFrameTimeJitter() const -> double;
+
+    [[nodiscard]] inline auto GetFixedFrameRate() const -> double;
+    inline void SetFixedFrameRate(double fixedFrameRate);
+
+    [[nodiscard]] inline auto GetFixedFrameTime() const -> double;
+
+    [[nodiscard]] inline auto GetMaxFixedStepsPerFrame() const -> int;
+    inline void SetMaxFixedStepsPerFrame(int maxFixedStepsPerFrame);
+
+    [[nodiscard]] inline auto GetFixedUpdateAlpha() const -> double;
+
+    [[nodiscard]] inline auto GetIdlePolicy() const -> IdlePolicy;
+    inline void SetIdlePolicy(IdlePolicy idlePolicy);
+
+    [[nodiscard]] inline auto GetIdleFrameRate() const -> double;
+    inline void SetIdleFrameRate(double idleFrameRate);
+
+    inline void RequestFrame(double delay = 0);
+
+    [[nodiscard]] inline auto IsIdle() const -> bool;
+    inline void UpdateIdleState();
+
+    inline void WaitForEvent();
+
     [[nodiscard]] inline auto GetQuit() const -> bool;
 
     [[nodiscard]] inline auto Run() -> int;
 
     inline void Loop();
 
+    inline void Step(double deltaTime);
+
+    inline void Simulate();
+
+    inline void Resimulate(double deltaTime);
+
+    [[nodiscard]] inline auto AllocateObjectId() -> uint32_t;
+
+    [[nodiscard]] inline auto GetRandomGenerator() -> std::mt19937 &;
+    inline void SetRandomSeed(uint32_t seed);
+
+    inline void RecordInput(InputLog &log);
+    inline void RecordInput(InputLog &log, uint32_t seed);
+    inline void ReplayInput(InputLog &log);
+    inline void StopInputLog();
+    [[nodiscard]] inline auto GetInputLogMode() const -> InputLogMode;
+
+    inline void SaveSnapshot(BinaryWriter &writer) const;
+    inline auto RestoreSnapshot(BinaryReader &reader) -> bool;
+
+#ifdef HANDCRANK_ENGINE_THREADED_SIMULATION
+    [[nodiscard]] inline auto IsThreadedSimulation() const -> bool;
+
+    /**
+     * Simulate each frame on a second thread while the previous frame is
+     * presented. Trades a frame of input latency for overlapping the two.
+     *
+     * @param threaded Whether to simulate on a second thread.
+     */
+    inline void SetThreadedSimulation(bool threaded);
+
+    inline void StepThreaded(double deltaTime);
+
+    inline void SimulationLoop();
+    inline void StopSimulationThread();
+#endif
+
 #ifdef __EMSCRIPTEN__
-    static inline void StaticLoop(void *userData);
+    double animationFrameTime = 0;
+
+    static inline auto AnimationFrame(double time, void *userData) -> EM_BOOL;
 #endif
 
     inline void HandleInput();
+    inline void ApplyInputLog();
 
     inline void CalculateDeltaTime();
 
+    inline void UpdateDisplayRefreshRate();
+
     inline void PopulateChildrenBuffer();
 
+    inline void RebuildTransformStore();
+    inline void UpdateTransforms();
+
+    inline void SetChildrenBufferAsDirty();
+    inline void SetDescendantChildrenBufferAsDirty();
+
+    inline void SetRenderOrderAsDirty();
+
     inline void Update();
     inline void FixedUpdate();
 
     inline void Render();
 
     inline void ResolveCollisions();
+    inline void FindContacts();
+    inline void DispatchContacts();
+    inline void DispatchContact(const CollisionContact &contact,
+                                CollisionContactState state);
 
     inline void DestroyChildObjects();
 
+    inline void TrimResourceCaches();
+
     inline void Quit();
 
 #ifdef HANDCRANK_ENGINE_DEBUG
     inline void ToggleDebug(bool state);
     inline void ToggleDebug();
     [[nodiscard]] inline auto IsDebug() const -> bool;
+
+    [[nodiscard]] inline auto GetDebugRectTexture() -> SDL_Texture *;
 #endif
 };
 
@@ -210,11 +572,19 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
     mutable SDL_FRect boundingBox = SDL_FRect();
     mutable bool boundingBoxIsDirty = true;
 
+    SDL_FRect previousTransformedRect = SDL_FRect();
+    bool hasPreviousTransformedRect = false;
+
+    SDL_FRect previousFixedTransformedRect = SDL_FRect();
+    bool hasPreviousFixedTransformedRect = false;
+
   protected:
-    inline static unsigned int count = 0;
+    inline static std::atomic<unsigned int> count = 0;
 
     int index = -1;
 
+    uint32_t objectId = 0;
+
     std::string name;
 
     std::string tag;
@@ -229,6 +599,15 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
 
     bool isCollisionEnabled = false;
 
+    bool isCollisionStayEnabled = false;
+
+    bool isContinuousCollisionEnabled = false;
+
+    bool isInterpolationEnabled = false;
+
+    Uint32 collisionLayer = DEFAULT_COLLISION_LAYER;
+    Uint32 collisionMask = DEFAULT_COLLISION_MASK;
+
     bool isMarkedForDestroy = false;
 
     bool isInputHovered = false;
@@ -237,13 +616,39 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
     std::vector<std::shared_ptr<RenderObject>> children;
     std::vector<std::shared_ptr<RenderObject>> childrenBuffer;
 
+    bool childrenBufferIsDirty = true;
+    bool descendantChildrenBufferIsDirty = true;
+
+    std::vector<uint32_t> renderOrder;
+    bool renderOrderIsDirty = true;
+    int renderOrderChanges = 0;
+
+    int z = 0;
+
+    bool isRegistered = false;
+    std::type_index registeredType = std::type_index(typeid(RenderObject));
+
+    int32_t transformIndex = NO_TRANSFORM_INDEX;
+
+    /** Objects were added under this one since the last store rebuild. */
+    bool hasUnstoredDescendants = false;
+
+    bool isRenderCacheEnabled = false;
+    bool renderCacheIsDirty = true;
+
+    std::shared_ptr<SDL_Texture> renderCacheTexture;
+    SDL_Rect renderCacheRect = SDL_Rect();
+    SDL_FPoint renderCacheOffset = SDL_FPoint();
+
+#ifdef HANDCRANK_ENGINE_PROFILER
+    mutable const char *profileName = nullptr;
+#endif
+
   public:
     Game *game = nullptr;
 
     RenderObject *parent = nullptr;
 
-    int z = 0;
-
     inline RenderObject();
     inline RenderObject(Vector2 position);
     inline RenderObject(float x, float y);
@@ -258,6 +663,7 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
     [[nodiscard]] inline auto IsCollisionEnabled() const -> bool;
 
     [[nodiscard]] inline auto GetIndex() const -> int;
+    [[nodiscard]] inline auto GetObjectId() const -> uint32_t;
 
     [[nodiscard]] inline auto GetName() const -> std::string;
     inline void SetName(const std::string &name);
@@ -267,6 +673,10 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
 
     [[nodiscard]] inline auto GetClassName() const -> std::string;
 
+#ifdef HANDCRANK_ENGINE_PROFILER
+    [[nodiscard]] inline auto GetProfileName() const -> const char *;
+#endif
+
     [[nodiscard]] inline auto ShowInHierarchy() const -> std::string;
 
     inline void AddChildObject(const std::shared_ptr<RenderObject> &child);
@@ -279,8 +689,22 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
         -> std::shared_ptr<T>;
     [[nodiscard]] inline auto GetChildCount() -> int;
 
+    inline void RegisterObject();
+    inline void UnregisterObject();
+
+    inline void AddToTransformStore(TransformStore &transformStore,
+                                    int32_t parentIndex);
+
     inline void PopulateChildrenBuffer();
 
+    inline void SetChildrenBufferAsDirty();
+    inline void SetDescendantChildrenBufferAsDirty();
+
+    [[nodiscard]] inline auto GetZ() const -> int;
+    inline void SetZ(int z);
+
+    inline void SetRenderOrderAsDirty();
+
     virtual inline void Start();
     virtual inline void Update(double deltaTime);
     virtual inline void FixedUpdate(double deltaTime);
@@ -292,11 +716,32 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
 
     virtual inline void OnCollision(const std::shared_ptr<RenderObject> &other);
 
+    virtual inline void
+    OnCollisionEnter(const std::shared_ptr<RenderObject> &other);
+    virtual inline void
+    OnCollisionStay(const std::shared_ptr<RenderObject> &other);
+    virtual inline void
+    OnCollisionExit(const std::shared_ptr<RenderObject> &other);
+
+    virtual inline void
+    OnContinuousCollision(const std::shared_ptr<RenderObject> &other,
+                          const SweptCollisionHit &hit);
+
     virtual inline void InternalUpdate(double deltaTime);
     virtual inline void InternalFixedUpdate(double fixedDeltaTime);
 
+    inline void StartTree();
+
     virtual inline void OnDestroy();
 
+    inline void Recycle();
+    virtual inline void OnRecycle();
+
+    virtual inline void Serialize(BinaryWriter &writer) const;
+    virtual inline void Deserialize(BinaryReader &reader);
+    inline void SerializeTree(BinaryWriter &writer) const;
+    inline auto DeserializeTree(BinaryReader &reader) -> bool;
+
     [[nodiscard]] inline auto GetRect() const -> const SDL_FRect &;
     inline void SetRect(const SDL_FRect &rect);
     inline void SetRect(float x, float y, float w, float h);
@@ -312,19 +757,53 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
 
     [[nodiscard]] inline auto GetTransformedRect() const -> const SDL_FRect &;
     inline void SetTransformedRect() const;
+    [[nodiscard]] inline auto GetLocalTransformedRect() const -> SDL_FRect;
 
     inline void SetTransformedRectAsDirty();
 
+    [[nodiscard]] inline auto IsInterpolationEnabled() const -> bool;
+    inline void EnableInterpolation();
+    inline void DisableInterpolation();
+
+    [[nodiscard]] inline auto GetInterpolatedTransformedRect() const
+        -> SDL_FRect;
+
     [[nodiscard]] inline auto GetBoundingBox() const -> const SDL_FRect &;
     inline void SetBoundingBox() const;
 
     inline void SetBoundingBoxAsDirty();
 
     inline void EnableCollider();
+    inline void EnableCollider(Uint32 layer, Uint32 mask);
     inline void DisableCollider();
 
+    [[nodiscard]] inline auto IsCollisionStayEnabled() const -> bool;
+    inline void SetCollisionStayEnabled(bool enabled);
+
+    [[nodiscard]] inline auto IsContinuousCollisionEnabled() const -> bool;
+    inline void EnableContinuousCollision();
+    inline void DisableContinuousCollision();
+
+    [[nodiscard]] inline auto GetPreviousTransformedRect() const
+        -> const SDL_FRect &;
+    inline void UpdatePreviousTransformedRect();
+    inline void ClearPreviousTransformedRect();
+
+    [[nodiscard]] inline auto GetCollisionLayer() const -> Uint32;
+    inline void SetCollisionLayer(Uint32 layer);
+
+    [[nodiscard]] inline auto GetCollisionMask() const -> Uint32;
+    inline void SetCollisionMask(Uint32 mask);
+
+    [[nodiscard]] inline auto IsRenderCacheEnabled() const -> bool;
+    inline void EnableRenderCache();
+    inline void DisableRenderCache();
+
+    inline void SetRenderCacheAsDirty();
+
     [[nodiscard]] inline auto CanRender() const -> bool;
     virtual inline void Render(SDL_Renderer *renderer);
+    inline void RenderSubtree(SDL_Renderer *renderer);
 
     [[nodiscard]] inline auto CheckCollisionAABB(
         const std::shared_ptr<RenderObject> &otherRenderObject) const -> bool;
@@ -336,32 +815,133 @@ class RenderObject : public std::enable_shared_from_this<RenderObject>
     inline void Destroy();
 };
 
-inline Game::Game() { Setup(); }
+inline Game::Game() : Game(GameMode::WINDOWED) {}
+
+/**
+ * Create a game. A headless game has no window, renderer or render pass and
+ * is driven by calling Step, so many can run side by side in one process. An
+ * offscreen game is the same but renders every step with the software
+ * renderer into a surface, for measuring the render pass without a display.
+ *
+ * @param mode Whether to open a window and whether to render.
+ */
+inline Game::Game(GameMode mode) : mode(mode)
+{
+    std::lock_guard<std::mutex> lock(gameLifetimeMutex);
+
+    activeGameCount += 1;
+
+    Setup();
+}
 
 inline Game::~Game()
 {
+#ifdef HANDCRANK_ENGINE_THREADED_SIMULATION
+    StopSimulationThread();
+#endif
+
+    assetLoader.Shutdown();
+
+    for (auto *system : systemOrder)
+    {
+        system->Clear();
+    }
+
+    for (const auto &child : children)
+    {
+        if (child != nullptr)
+        {
+            child->UnregisterObject();
+        }
+    }
+
+    objectRegistry.Clear();
+
     children.clear();
     childrenBuffer.clear();
     colliders.clear();
+    contacts.clear();
+    previousContacts.clear();
+
+    objectPools.clear();
+
+    systemOrder.clear();
+    systems.clear();
+
+#ifdef HANDCRANK_ENGINE_DEBUG
+    debugRectTexture = nullptr;
+#endif
+
+    if (renderer != nullptr)
+    {
+        ReleaseGlyphAtlases(renderer);
+
+        ReleaseRendererTextures(renderer);
+
+#ifdef HANDCRANK_ENGINE_PROFILER
+        GetProfiler().ReleaseOverlayLabels(renderer);
+#endif
+
+        DestroyDeferredTextures();
+
+        SDL_DestroyRenderer(renderer);
+    }
+
+    if (offscreenSurface != nullptr)
+    {
+        SDL_FreeSurface(offscreenSurface);
+    }
+
+    if (window != nullptr)
+    {
+        SDL_DestroyWindow(window);
+    }
+
+    std::lock_guard<std::mutex> lock(gameLifetimeMutex);
 
-    SDL_DestroyWindow(window);
-    SDL_DestroyRenderer(renderer);
+    if (initializedSubsystems != 0)
+    {
+        SDL_QuitSubSystem(initializedSubsystems);
+    }
+
+    // Fonts and sounds don't belong to a renderer, so every game shares them
+    // and the last one to go releases them.
+
+    if (activeGameCount.fetch_sub(1) == 1)
+    {
+#ifdef HANDCRANK_ENGINE_PROFILER
+        GetProfiler().ReleaseOverlay();
+#endif
 
-    ClearAudioCache();
+        ClearGlyphAtlasCache();
 
-    ClearFontCache();
-    CleanupFontInits();
+        ClearTextureCache();
 
-    ClearTextureCache();
+        ClearAudioCache();
 
-    SDL_Quit();
+        ClearFontCache();
+        CleanupFontInits();
+
+        SDL_Quit();
+    }
 };
 
+inline auto Game::GetMode() const -> GameMode { return mode; }
+
+inline auto Game::IsHeadless() const -> bool
+{
+    return mode == GameMode::HEADLESS;
+}
+
 inline void Game::AddChildObject(const std::shared_ptr<RenderObject> &child)
 {
     child->game = this;
 
     children.emplace_back(child);
+
+    child->RegisterObject();
+
+    SetChildrenBufferAsDirty();
 }
 
 template <typename T>
@@ -414,56 +994,272 @@ inline auto Game::GetChildByType(bool nested) -> std::shared_ptr<T>
 
 inline auto Game::GetChildCount() -> int { return children.size(); }
 
-inline void Game::AddCollider(const std::shared_ptr<RenderObject> &collider)
+/**
+ * Every live object of exactly type T, derived types aren't included. The view
+ * is only valid until objects are next added or destroyed.
+ */
+template <typename T>
+inline auto Game::FindAllByType() const -> ObjectView<T>
 {
-    colliders.emplace_back(collider);
+    static_assert(std::is_base_of_v<RenderObject, T>,
+                  "T must be derived from RenderObject");
+
+    return objectRegistry.FindAllByType<T>();
 }
 
-inline auto Game::GetWindow() -> SDL_Window * { return window; }
+/**
+ * A live object of exactly type T, or nullptr. Which one isn't defined when
+ * there are several.
+ */
+template <typename T>
+inline auto Game::FindByType() const -> std::shared_ptr<T>
+{
+    auto *object = FindAllByType<T>().front();
 
-inline auto Game::GetRenderer() -> SDL_Renderer * { return renderer; }
+    return object != nullptr
+               ? std::static_pointer_cast<T>(object->shared_from_this())
+               : nullptr;
+}
 
-inline auto Game::GetViewport() const -> const SDL_FRect & { return viewportf; }
+inline auto Game::FindAllByTag(const std::string &tag) const
+    -> ObjectView<RenderObject>
+{
+    return objectRegistry.FindAllByTag(tag);
+}
 
-inline auto Game::SwitchToFullscreen() -> bool
+inline auto Game::FindByTag(const std::string &tag) const
+    -> std::shared_ptr<RenderObject>
 {
-    auto result = SDL_SetWindowFullscreen(window, SDL_TRUE) == 0;
+    auto *object = FindAllByTag(tag).front();
 
-    if (result)
-    {
-        fullscreen = true;
-    }
+    return object != nullptr ? object->shared_from_this() : nullptr;
+}
 
-    return result;
+inline auto Game::FindAllByName(const std::string &name) const
+    -> ObjectView<RenderObject>
+{
+    return objectRegistry.FindAllByName(name);
 }
 
-inline auto Game::SwitchToWindowedMode() -> bool
+inline auto Game::FindByName(const std::string &name) const
+    -> std::shared_ptr<RenderObject>
 {
-    auto result = SDL_SetWindowFullscreen(window, SDL_FALSE) == 0;
+    auto *object = FindAllByName(name).front();
 
-    if (result)
-    {
-        SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED,
-                              SDL_WINDOWPOS_CENTERED);
+    return object != nullptr ? object->shared_from_this() : nullptr;
+}
 
-        fullscreen = false;
+inline auto Game::GetObjectRegistry() -> ObjectRegistry &
+{
+    return objectRegistry;
+}
+
+/**
+ * The pool for type T, created on first use.
+ */
+template <typename T>
+inline auto Game::GetObjectPool() -> ObjectPool<T> &
+{
+    auto &pool = objectPools[std::type_index(typeid(T))];
+
+    if (pool == nullptr)
+    {
+        pool = std::make_unique<ObjectPool<T>>();
     }
 
-    return result;
+    return static_cast<ObjectPool<T> &>(*pool);
 }
 
-inline auto Game::IsFullscreen() const -> bool { return fullscreen; }
+/**
+ * Get an instance of T from its pool, recycling one destroyed earlier when
+ * possible. The instance still has to be added with AddChildObject.
+ */
+template <typename T>
+inline auto Game::Spawn() -> std::shared_ptr<T>
+{
+    return GetObjectPool<T>().Acquire();
+}
 
-inline auto Game::Setup() -> bool
+/**
+ * Get the game's instance of a system, creating it on first use.
+ */
+template <typename T>
+inline auto Game::GetSystem() -> T &
 {
-    SDL_SetHint(SDL_HINT_WINDOWS_DPI_SCALING, "1");
+    auto &system = systems[std::type_index(typeid(T))];
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) < 0)
+    if (system == nullptr)
     {
-        return false;
+        system = std::make_unique<T>();
+
+        system->SetGame(this);
+
+        systemOrder.emplace_back(system.get());
     }
 
-    if (window != nullptr)
+    return static_cast<T &>(*system);
+}
+
+inline auto Game::GetObjectPoolStats() const -> std::vector<ObjectPoolStats>
+{
+    std::vector<ObjectPoolStats> stats;
+
+    stats.reserve(objectPools.size());
+
+    for (const auto &[type, pool] : objectPools)
+    {
+        stats.emplace_back(pool->GetStats());
+    }
+
+    return stats;
+}
+
+/**
+ * Start checking an object for collisions. A collider disabled and enabled
+ * again in the same frame is still in the list, as disabled colliders are
+ * only removed in the collision pass, so it isn't added twice.
+ *
+ * @param collider Object to check.
+ */
+inline void Game::AddCollider(const std::shared_ptr<RenderObject> &collider)
+{
+    if (std::find(colliders.begin(), colliders.end(), collider) !=
+        colliders.end())
+    {
+        return;
+    }
+
+    colliders.emplace_back(collider);
+}
+
+inline auto Game::GetBroadphaseMode() const -> BroadphaseMode
+{
+    return broadphaseMode;
+}
+
+inline void Game::SetBroadphaseMode(BroadphaseMode broadphaseMode)
+{
+    this->broadphaseMode = broadphaseMode;
+}
+
+inline auto Game::GetWindow() -> SDL_Window * { return window; }
+
+inline auto Game::GetRenderer() -> SDL_Renderer * { return renderer; }
+
+inline auto Game::GetRenderBatch() -> RenderBatch & { return renderBatch; }
+
+inline auto Game::GetTransformStore() -> TransformStore &
+{
+    return transformStore;
+}
+
+inline auto Game::GetAssetLoader() -> AssetLoader & { return assetLoader; }
+
+/**
+ * Draw the queued primitives. Call before drawing to the renderer directly so
+ * the primitives queued earlier in the frame end up underneath.
+ */
+inline void Game::FlushRenderBatch() { renderBatch.Flush(); }
+
+inline auto Game::GetViewport() const -> const SDL_FRect & { return viewportf; }
+
+inline auto Game::SwitchToFullscreen() -> bool
+{
+    auto result = SDL_SetWindowFullscreen(window, SDL_TRUE) == 0;
+
+    if (result)
+    {
+        fullscreen = true;
+    }
+
+    return result;
+}
+
+inline auto Game::SwitchToWindowedMode() -> bool
+{
+    auto result = SDL_SetWindowFullscreen(window, SDL_FALSE) == 0;
+
+    if (result)
+    {
+        SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED,
+                              SDL_WINDOWPOS_CENTERED);
+
+        fullscreen = false;
+    }
+
+    return result;
+}
+
+inline auto Game::IsFullscreen() const -> bool { return fullscreen; }
+
+inline auto Game::Setup() -> bool
+{
+    // A headless game has no textures to destroy, so it can run on any
+    // thread without moving the render thread.
+
+    if (mode != GameMode::HEADLESS)
+    {
+        SetRenderThread();
+    }
+
+    if (mode == GameMode::HEADLESS || mode == GameMode::OFFSCREEN)
+    {
+        if (initializedSubsystems == 0)
+        {
+            if (SDL_InitSubSystem(SDL_INIT_TIMER) < 0)
+            {
+                return false;
+            }
+
+            initializedSubsystems = SDL_INIT_TIMER;
+        }
+
+        focused = true;
+
+        if (mode == GameMode::OFFSCREEN && renderer == nullptr)
+        {
+            offscreenSurface = SDL_CreateRGBSurfaceWithFormat(
+                0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+
+            if (offscreenSurface == nullptr)
+            {
+                SDL_Log("SDL_CreateRGBSurfaceWithFormat %s", SDL_GetError());
+
+                return false;
+            }
+
+            renderer = SDL_CreateSoftwareRenderer(offscreenSurface);
+
+            if (renderer == nullptr)
+            {
+                SDL_Log("SDL_CreateSoftwareRenderer %s", SDL_GetError());
+
+                return false;
+            }
+
+            renderBatch.SetRenderer(renderer);
+
+            assetLoader.SetRenderer(renderer);
+        }
+
+        SetScreenSize(width, height);
+
+        return true;
+    }
+
+    SDL_SetHint(SDL_HINT_WINDOWS_DPI_SCALING, "1");
+
+    if (initializedSubsystems == 0)
+    {
+        if (SDL_InitSubSystem(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) < 0)
+        {
+            return false;
+        }
+
+        initializedSubsystems = SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER;
+    }
+
+    if (window != nullptr)
     {
         SDL_DestroyWindow(window);
     }
@@ -489,6 +1285,10 @@ inline auto Game::Setup() -> bool
 
     if (renderer != nullptr)
     {
+#ifdef HANDCRANK_ENGINE_PROFILER
+        GetProfiler().ReleaseOverlayLabels(renderer);
+#endif
+
         SDL_DestroyRenderer(renderer);
     }
 
@@ -502,6 +1302,15 @@ inline auto Game::Setup() -> bool
         return false;
     }
 
+    SDL_RenderSetVSync(renderer,
+                       framePacer.GetMode() == FramePacingMode::VSYNC ? 1 : 0);
+
+    UpdateDisplayRefreshRate();
+
+    renderBatch.SetRenderer(renderer);
+
+    assetLoader.SetRenderer(renderer);
+
     SetScreenSize(width, height);
 
     return true;
@@ -509,6 +1318,27 @@ inline auto Game::Setup() -> bool
 
 inline void Game::SetScreenSize(int _width, int _height)
 {
+    if (window == nullptr)
+    {
+        width = _width;
+        height = _height;
+
+        viewport.w = width;
+        viewport.h = height;
+        viewportf.w = static_cast<float>(viewport.w);
+        viewportf.h = static_cast<float>(viewport.h);
+
+        // The offscreen surface keeps its size, the logical size scales the
+        // game to fit it.
+
+        if (renderer != nullptr)
+        {
+            SDL_RenderSetLogicalSize(renderer, width, height);
+        }
+
+        return;
+    }
+
     SDL_SetWindowMinimumSize(window, _width, _height);
 
     SDL_SetWindowSize(window, _width, _height);
@@ -520,122 +1350,966 @@ inline void Game::SetScreenSize(int _width, int _height)
     viewportf.w = static_cast<float>(viewport.w);
     viewportf.h = static_cast<float>(viewport.h);
 
-    SDL_RenderSetScale(renderer, 1.0F, 1.0F);
-    SDL_RenderSetLogicalSize(renderer, width, height);
+    SDL_RenderSetScale(renderer, 1.0F, 1.0F);
+    SDL_RenderSetLogicalSize(renderer, width, height);
+
+    SDL_RenderSetViewport(renderer, &viewport);
+
+    SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED,
+                          SDL_WINDOWPOS_CENTERED);
+}
+
+inline void Game::RecalculateScreenSize()
+{
+    if (window == nullptr)
+    {
+        return;
+    }
+
+    SDL_GL_GetDrawableSize(window, &width, &height);
+}
+
+/**
+ * Pass the refresh rate of the display the window is on to the frame pacer,
+ * which checks vsync against it.
+ */
+inline void Game::UpdateDisplayRefreshRate()
+{
+    if (window == nullptr)
+    {
+        return;
+    }
+
+    SDL_DisplayMode displayMode;
+
+    const auto displayIndex = SDL_GetWindowDisplayIndex(window);
+
+    if (displayIndex < 0 ||
+        SDL_GetCurrentDisplayMode(displayIndex, &displayMode) != 0)
+    {
+        framePacer.SetDisplayRefreshRate(0);
+
+        return;
+    }
+
+    framePacer.SetDisplayRefreshRate(displayMode.refresh_rate);
+}
+
+inline void Game::SetTitle(const char *name)
+{
+    SDL_SetWindowTitle(window, name);
+}
+
+inline void Game::SetClearColor(const SDL_Color color)
+{
+    this->clearColor = color;
+}
+
+inline auto Game::GetWidth() const -> int { return viewport.w; }
+
+inline auto Game::GetHeight() const -> int { return viewport.h; }
+
+inline auto Game::HasFocus() const -> bool { return focused; }
+
+inline auto Game::GetElapsedTime() const -> double { return elapsedTime; }
+
+inline auto Game::GetFrameRate() const -> double { return frameRate; }
+
+inline auto Game::GetFPS() const -> double { return fps; }
+
+/**
+ * Target a frame rate instead of waiting for vsync. The loop sleeps for most
+ * of the remaining frame time and spins for the rest.
+ *
+ * @param frameRate Frames per second, for example 144.
+ */
+inline void Game::SetFrameRate(double frameRate)
+{
+    this->frameRate = frameRate;
+
+    framePacer.SetTargetFrameRate(frameRate);
+
+    SetFramePacingMode(FramePacingMode::TARGET_FRAME_RATE);
+}
+
+inline auto Game::GetFramePacingMode() const -> FramePacingMode
+{
+    return framePacer.GetMode();
+}
+
+inline void Game::SetFramePacingMode(FramePacingMode mode)
+{
+    framePacer.SetMode(mode);
+
+    if (renderer != nullptr)
+    {
+        SDL_RenderSetVSync(renderer, mode == FramePacingMode::VSYNC ? 1 : 0);
+    }
+}
+
+inline auto Game::GetFramePacer() -> FramePacer & { return framePacer; }
+
+inline auto Game::GetFrameTimeJitter() const -> double
+{
+    return framePacer.GetFrameTimeJitter();
+}
+
+inline auto Game::GetFixedFrameRate() const -> double
+{
+    return 1 / fixedFrameTime;
+}
+
+/**
+ * Set how many fixed steps run per second. The step size passed to
+ * FixedUpdate is always 1 / fixedFrameRate, no matter the render frame rate.
+ *
+ * @param fixedFrameRate Fixed steps per second, for example 120.
+ */
+inline void Game::SetFixedFrameRate(double fixedFrameRate)
+{
+    if (fixedFrameRate > 0)
+    {
+        fixedFrameTime = 1 / fixedFrameRate;
+    }
+}
+
+inline auto Game::GetFixedFrameTime() const -> double
+{
+    return fixedFrameTime;
+}
+
+inline auto Game::GetMaxFixedStepsPerFrame() const -> int
+{
+    return maxFixedStepsPerFrame;
+}
+
+/**
+ * Limit how many fixed steps can run in a single frame. When a frame takes
+ * longer than this many steps the remaining time is dropped so a slow frame
+ * can't snowball into even slower frames.
+ *
+ * @param maxFixedStepsPerFrame Maximum fixed steps per frame.
+ */
+inline void Game::SetMaxFixedStepsPerFrame(int maxFixedStepsPerFrame)
+{
+    this->maxFixedStepsPerFrame = std::max(maxFixedStepsPerFrame, 1);
+}
+
+/**
+ * How far the current frame is between the last fixed step and the next one,
+ * from 0 to 1. Used to blend between the previous and current transforms.
+ */
+inline auto Game::GetFixedUpdateAlpha() const -> double
+{
+    return fixedUpdateAlpha;
+}
+
+inline auto Game::GetIdlePolicy() const -> IdlePolicy { return idlePolicy; }
+
+inline void Game::SetIdlePolicy(IdlePolicy idlePolicy)
+{
+    this->idlePolicy = idlePolicy;
+
+    frameRequested = true;
+}
+
+inline auto Game::GetIdleFrameRate() const -> double { return idleFrameRate; }
+
+/**
+ * How often the loop wakes up while idle when there is no input, so objects
+ * still get updated now and then.
+ *
+ * @param idleFrameRate Frames per second, for example 10.
+ */
+inline void Game::SetIdleFrameRate(double idleFrameRate)
+{
+    if (idleFrameRate > 0)
+    {
+        this->idleFrameRate = idleFrameRate;
+    }
+}
+
+/**
+ * Keep the game from idling. Anything that marks an object as changed
+ * already requests a frame, this is for objects that need to update without
+ * changing, like a timer counting down. Call from the main thread.
+ *
+ * @param delay Seconds until the frame is needed, 0 for the next one.
+ */
+inline void Game::RequestFrame(double delay)
+{
+    if (delay <= 0)
+    {
+        frameRequested = true;
+
+        return;
+    }
+
+    const auto frame =
+        SDL_GetPerformanceCounter() +
+        static_cast<Uint64>(delay *
+                            static_cast<double>(SDL_GetPerformanceFrequency()));
+
+    if (scheduledFrame == 0 || frame < scheduledFrame)
+    {
+        scheduledFrame = frame;
+    }
+}
+
+/**
+ * Whether the current frame is an idle one, which only renders when
+ * something requested it and is followed by a wait for input instead of the
+ * frame pacer.
+ */
+inline auto Game::IsIdle() const -> bool { return isIdle; }
+
+inline void Game::UpdateIdleState()
+{
+    if (mode != GameMode::WINDOWED || idlePolicy == IdlePolicy::NEVER)
+    {
+        isIdle = false;
+
+        return;
+    }
+
+    if (scheduledFrame != 0 && SDL_GetPerformanceCounter() >= scheduledFrame)
+    {
+        scheduledFrame = 0;
+
+        frameRequested = true;
+    }
+
+    if (assetLoader.GetLoadingCount() > 0)
+    {
+        frameRequested = true;
+    }
+
+    isIdle = !focused ||
+             (idlePolicy == IdlePolicy::UNCHANGED && !frameRequested);
+}
+
+/**
+ * Sleep until an event arrives, a scheduled frame is due or the idle frame
+ * time runs out. The browser already throttles hidden tabs, so on the web
+ * this returns straight away.
+ */
+inline void Game::WaitForEvent()
+{
+#ifndef __EMSCRIPTEN__
+    auto timeout = MILLISECONDS / idleFrameRate;
+
+    if (scheduledFrame != 0)
+    {
+        const auto now = SDL_GetPerformanceCounter();
+
+        const auto remaining =
+            scheduledFrame > now
+                ? static_cast<double>(scheduledFrame - now) * MILLISECONDS /
+                      static_cast<double>(SDL_GetPerformanceFrequency())
+                : 0;
+
+        timeout = std::min(timeout, remaining);
+    }
+
+    SDL_WaitEventTimeout(nullptr, static_cast<int>(std::ceil(timeout)));
+#endif
+}
+
+inline auto Game::GetQuit() const -> bool { return quit; }
+
+inline auto Game::Run() -> int
+{
+    // Games without a window don't wait on a clock, each step advances the
+    // simulation by one frame straight away.
+
+    if (mode != GameMode::WINDOWED)
+    {
+        while (!GetQuit())
+        {
+            Step(1 / frameRate);
+        }
+
+        return 0;
+    }
+
+#ifdef __EMSCRIPTEN__
+    emscripten_request_animation_frame_loop(Game::AnimationFrame, this);
+
+    // Hand the main thread back to the browser, which calls AnimationFrame
+    // every display refresh from here on.
+
+    emscripten_exit_with_live_runtime();
+#else
+    while (!GetQuit())
+    {
+        Loop();
+    }
+#endif
+
+    return 0;
+}
+
+inline void Game::Loop()
+{
+    HANDCRANK_ENGINE_PROFILE_SCOPE("Frame");
+
+    framesThisSecond++;
+
+#ifdef __EMSCRIPTEN__
+    deltaTime = framePacer.BeginFrame(animationFrameTime);
+#else
+    deltaTime = framePacer.BeginFrame();
+#endif
+
+    const auto frameStart = framePacer.GetFrameStart();
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("HandleInput");
+
+        HandleInput();
+    }
+
+#ifdef HANDCRANK_ENGINE_THREADED_SIMULATION
+    if (isThreadedSimulation)
+    {
+        StepThreaded(deltaTime);
+    }
+    else
+    {
+        Step(deltaTime);
+    }
+#else
+    Step(deltaTime);
+#endif
+
+    float elapsedSeconds = (frameStart - previousFrameStart) /
+                           (float)SDL_GetPerformanceFrequency();
+
+    if (elapsedSeconds >= 1)
+    {
+        fps = (int)(framesThisSecond / elapsedSeconds);
+        framesThisSecond = 0;
+        previousFrameStart = frameStart;
+    }
+
+    if (isIdle)
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("WaitForEvent");
+
+        WaitForEvent();
+    }
+    else
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("WaitForNextFrame");
+
+        framePacer.WaitForNextFrame();
+    }
+
+#ifdef HANDCRANK_ENGINE_PROFILER
+    GetProfiler().EndFrame();
+#endif
+}
+
+/**
+ * Advance the game by one frame of a given length. Loop calls this with the
+ * measured frame time. Headless games call it directly with whatever time step
+ * they simulate, input can be fed in between steps with HandleInputPollEvent.
+ *
+ * @param deltaTime Length of the frame in seconds.
+ */
+inline void Game::Step(double deltaTime)
+{
+    this->deltaTime = deltaTime;
+
+    ApplyInputLog();
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("AssetLoader");
+
+        assetLoader.Update();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("PopulateChildrenBuffer");
+
+        PopulateChildrenBuffer();
+    }
+
+    Simulate();
+
+    UpdateIdleState();
+
+    if (mode != GameMode::HEADLESS && (!isIdle || frameRequested))
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("Render");
+
+        Render();
+
+        frameRequested = false;
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("DestroyChildObjects");
+
+        DestroyChildObjects();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("TrimResourceCaches");
+
+        TrimResourceCaches();
+    }
+
+    // Without a window there is no HandleInput at the start of the next frame,
+    // so the input edges are measured from the end of this step instead.
+
+    if (mode != GameMode::WINDOWED)
+    {
+        HandleInputSetup();
+
+#ifdef HANDCRANK_ENGINE_PROFILER
+        GetProfiler().EndFrame();
+#endif
+    }
+}
+
+/**
+ * The part of a step that only touches the scene graph, which is what runs on
+ * the simulation thread when threaded simulation is on.
+ */
+inline void Game::Simulate()
+{
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("Update");
+
+        Update();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("Systems");
+
+        for (auto *system : systemOrder)
+        {
+            if (!isResimulating || system->IsResimulated())
+            {
+                system->Update(deltaTime);
+            }
+        }
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("FixedUpdate");
+
+        FixedUpdate();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("UpdateTransforms");
+
+        UpdateTransforms();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("ResolveCollisions");
+
+        ResolveCollisions();
+    }
+}
+
+#ifdef HANDCRANK_ENGINE_THREADED_SIMULATION
+inline auto Game::IsThreadedSimulation() const -> bool
+{
+    return isThreadedSimulation;
+}
+
+/**
+ * Run Update, FixedUpdate and collisions on a second thread while the main
+ * thread presents the previous frame. Render records into a command buffer
+ * that is replayed at the start of the next frame, so a slow present no
+ * longer holds up the simulation. Only used by windowed games run with Run.
+ *
+ * Everything SDL stays on the main thread, so while this is on, Start,
+ * Update and collision callbacks must not create or destroy textures. Load
+ * them through the asset loader or in Render instead.
+ *
+ * @param threaded Whether to simulate on a second thread.
+ */
+inline void Game::SetThreadedSimulation(bool threaded)
+{
+    if (!threaded)
+    {
+        StopSimulationThread();
+    }
+
+    isThreadedSimulation = threaded;
+}
+
+inline void Game::StepThreaded(double deltaTime)
+{
+    this->deltaTime = deltaTime;
+
+    ApplyInputLog();
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("AssetLoader");
+
+        assetLoader.Update();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("PopulateChildrenBuffer");
+
+        PopulateChildrenBuffer();
+    }
+
+    if (!simulationThread.joinable())
+    {
+        simulationStopping = false;
+
+        simulationThread = std::thread([this]() { SimulationLoop(); });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(simulationMutex);
+
+        simulationRequested = true;
+        simulationFinished = false;
+    }
+
+    simulationCondition.notify_all();
+
+    auto &frontBuffer = renderCommandBuffers[renderCommandBufferIndex];
+
+    if (!frontBuffer.IsEmpty())
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("Present");
+
+        frontBuffer.Replay(renderer);
+
+        SDL_RenderPresent(renderer);
+
+        // Cleared once presented, so an idle frame that records nothing
+        // doesn't present it twice.
+
+        frontBuffer.Clear();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("WaitForSimulation");
+
+        std::unique_lock<std::mutex> lock(simulationMutex);
+
+        simulationCondition.wait(lock, [this]() { return simulationFinished; });
+    }
+
+    if (simulationException != nullptr)
+    {
+        std::rethrow_exception(std::exchange(simulationException, nullptr));
+    }
+
+    // Anything released here can't be referenced by a recorded frame, the
+    // last one was already replayed and the next one isn't recorded yet.
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("DestroyChildObjects");
+
+        DestroyChildObjects();
+
+        DestroyDeferredTextures();
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("TrimResourceCaches");
+
+        TrimResourceCaches();
+    }
+
+    UpdateIdleState();
+
+    if (isIdle && !frameRequested)
+    {
+        return;
+    }
+
+    renderCommandBufferIndex = 1 - renderCommandBufferIndex;
+
+    auto &commandBuffer = renderCommandBuffers[renderCommandBufferIndex];
+
+    commandBuffer.Clear();
+
+    {
+        HANDCRANK_ENGINE_PROFILE_SCOPE("Render");
+
+        renderBatch.SetCommandBuffer(&commandBuffer);
+
+        Render();
+
+        renderBatch.SetCommandBuffer(nullptr);
+    }
+
+    frameRequested = false;
+}
+
+inline void Game::SimulationLoop()
+{
+    std::unique_lock<std::mutex> lock(simulationMutex);
+
+    while (true)
+    {
+        simulationCondition.wait(lock,
+                                 [this]()
+                                 {
+                                     return simulationRequested ||
+                                            simulationStopping;
+                                 });
+
+        if (simulationStopping)
+        {
+            return;
+        }
+
+        simulationRequested = false;
+
+        lock.unlock();
+
+        try
+        {
+            // Gives the phases on this thread the same depth as on the main
+            // thread, under Frame, so they show in the profiler summaries.
+
+            HANDCRANK_ENGINE_PROFILE_SCOPE("Simulate");
+
+            Simulate();
+        }
+        catch (...)
+        {
+            simulationException = std::current_exception();
+        }
+
+        lock.lock();
+
+        simulationFinished = true;
+
+        simulationCondition.notify_all();
+    }
+}
+
+inline void Game::StopSimulationThread()
+{
+    if (!simulationThread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(simulationMutex);
+
+        simulationStopping = true;
+    }
+
+    simulationCondition.notify_all();
+
+    simulationThread.join();
+}
+#endif
+
+#ifdef __EMSCRIPTEN__
+/**
+ * requestAnimationFrame callback. Frames are timed from the timestamp the
+ * browser passes in, returning false stops the loop.
+ *
+ * @param time Time of the frame in milliseconds.
+ * @param userData The game.
+ */
+inline auto Game::AnimationFrame(double time, void *userData) -> EM_BOOL
+{
+    auto *gameInstance = static_cast<Game *>(userData);
+
+    if (gameInstance == nullptr || gameInstance->GetQuit())
+    {
+        return EM_FALSE;
+    }
+
+    gameInstance->animationFrameTime = time / 1000;
+
+    gameInstance->Loop();
+
+    return EM_TRUE;
+}
+#endif
+
+/**
+ * Advance the scene graph by one frame without rendering, to catch back up
+ * after RestoreSnapshot rolls the game back. Set the input of each frame with
+ * SetInputState before calling it. Only systems that are resimulated, see
+ * GameSystem::IsResimulated, are updated.
+ *
+ * @param deltaTime Length of the frame in seconds.
+ */
+inline void Game::Resimulate(double deltaTime)
+{
+    this->deltaTime = deltaTime;
+
+    PopulateChildrenBuffer();
+
+    isResimulating = true;
+
+    Simulate();
 
-    SDL_RenderSetViewport(renderer, &viewport);
+    isResimulating = false;
 
-    SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED,
-                          SDL_WINDOWPOS_CENTERED);
+    DestroyChildObjects();
+
+    // The edges set by SetInputState are read during the frame, so they're
+    // only cleared once it's done, as Step does without a window.
+
+    HandleInputSetup();
 }
 
-inline void Game::RecalculateScreenSize()
+/**
+ * Next ID of an object registered with this game. Called by RenderObject as
+ * it's added to the tree.
+ */
+inline auto Game::AllocateObjectId() -> uint32_t
 {
-    SDL_GL_GetDrawableSize(window, &width, &height);
+    const auto objectId = nextObjectId;
+
+    nextObjectId += 1;
+
+    return objectId;
 }
 
-inline void Game::SetTitle(const char *name)
+/**
+ * The game's own random generator, saved in its snapshots. Pass it to
+ * RandomNumberRange, RandomColorRange and RandomBoolean from game code so
+ * replays, rollback and other games in the process don't disturb it.
+ */
+inline auto Game::GetRandomGenerator() -> std::mt19937 &
 {
-    SDL_SetWindowTitle(window, name);
+    return randomGenerator;
 }
 
-inline void Game::SetClearColor(const SDL_Color color)
+/**
+ * Seed the game's random generator, so a recorded game can be played back
+ * with the same random numbers.
+ *
+ * @param seed Seed to use.
+ */
+inline void Game::SetRandomSeed(uint32_t seed) { randomGenerator.seed(seed); }
+
+/**
+ * Write the input of every frame from now on to a log, along with the random
+ * seed it reseeds the game with.
+ *
+ * @param log Log to record to, which has to outlive the recording.
+ */
+inline void Game::RecordInput(InputLog &log)
 {
-    this->clearColor = color;
+    RecordInput(log, std::random_device()());
 }
 
-inline auto Game::GetWidth() const -> int { return viewport.w; }
+/**
+ * @param log Log to record to, which has to outlive the recording.
+ * @param seed Random seed to reseed the game with.
+ */
+inline void Game::RecordInput(InputLog &log, uint32_t seed)
+{
+    SetRandomSeed(seed);
 
-inline auto Game::GetHeight() const -> int { return viewport.h; }
+    log.BeginRecording(seed);
 
-inline auto Game::HasFocus() const -> bool { return focused; }
+    inputLog = &log;
+    inputLogMode = InputLogMode::RECORD;
+}
 
-inline auto Game::GetElapsedTime() const -> double { return elapsedTime; }
+/**
+ * Play back a recorded log from the start, in place of live input and frame
+ * times, on every Step including games without a window. Start it with the
+ * game in the state the recording was started in. Playback stops at the end
+ * of the log, where GetInputLogMode goes back to NONE.
+ *
+ * @param log Log to play back, which has to outlive the playback.
+ */
+inline void Game::ReplayInput(InputLog &log)
+{
+    SetRandomSeed(log.GetSeed());
 
-inline auto Game::GetFrameRate() const -> double { return frameRate; }
+    log.Rewind();
 
-inline auto Game::GetFPS() const -> double { return fps; }
+    inputLog = &log;
+    inputLogMode = InputLogMode::REPLAY;
+}
 
-inline void Game::SetFrameRate(double frameRate)
+inline void Game::StopInputLog()
 {
-    this->frameRate = frameRate;
+    inputLog = nullptr;
+    inputLogMode = InputLogMode::NONE;
 }
 
-inline auto Game::GetQuit() const -> bool { return quit; }
+inline auto Game::GetInputLogMode() const -> InputLogMode
+{
+    return inputLogMode;
+}
 
-inline auto Game::Run() -> int
+/**
+ * Called at the start of each step, after HandleInput when there's a window,
+ * so a replayed frame replaces whatever input arrived during it and the
+ * delta time the step was given. Window and quit events still apply.
+ */
+inline void Game::ApplyInputLog()
 {
-#ifdef __EMSCRIPTEN__
-    emscripten_set_main_loop_arg(Game::StaticLoop, this, 0, 1);
-#else
-    while (!GetQuit())
+    if (inputLog == nullptr)
     {
-        Loop();
+        return;
     }
-#endif
 
-    return 0;
+    if (inputLogMode == InputLogMode::RECORD)
+    {
+        inputLog->WriteFrame(GetInputState(), focused, deltaTime);
+
+        return;
+    }
+
+    InputState state;
+
+    if (!inputLog->ReadFrame(state, focused, deltaTime))
+    {
+        StopInputLog();
+
+        return;
+    }
+
+    SetInputState(state);
+
+    frameRequested = true;
 }
 
-inline void Game::Loop()
+/**
+ * Write the simulation state of the game and every object in it, see
+ * RenderObject::Serialize. Objects can only be restored into a scene graph
+ * with the same shape.
+ *
+ * @param writer Writer to append the snapshot to.
+ */
+inline void Game::SaveSnapshot(BinaryWriter &writer) const
 {
-    framesThisSecond++;
+    writer.Write(elapsedTime);
+    writer.Write(fixedUpdateDeltaTime);
+    writer.Write(fixedUpdateAlpha);
 
-    auto frameStart = SDL_GetPerformanceCounter();
+    writer.Write(randomGenerator);
 
-#ifdef __EMSCRIPTEN__
-    if (GetQuit())
+    writer.Write(nextObjectId);
+
+    // Contacts from the last frame decide which collisions enter or exit on
+    // the next one, so they are stored by the object IDs in their key.
+
+    writer.Write(static_cast<uint32_t>(previousContacts.size()));
+
+    for (const auto &contact : previousContacts)
     {
-        emscripten_cancel_main_loop();
+        writer.Write(contact.key);
+        writer.Write(contact.isSwept);
+        writer.Write(contact.hit);
     }
-#endif
 
-    HandleInput();
+    writer.Write(CountSerializedChildren(children));
 
-    PopulateChildrenBuffer();
+    for (const auto &child : children)
+    {
+        if (child != nullptr)
+        {
+            child->SerializeTree(writer);
+        }
+    }
+}
 
-    Update();
-    FixedUpdate();
+/**
+ * Restore a snapshot written by SaveSnapshot.
+ *
+ * @param reader Reader positioned at the start of the snapshot.
+ * @return False if the snapshot ended early or the scene graph has changed
+ * shape since it was taken, in which case the game is partly restored.
+ */
+inline auto Game::RestoreSnapshot(BinaryReader &reader) -> bool
+{
+    reader.Read(elapsedTime);
+    reader.Read(fixedUpdateDeltaTime);
+    reader.Read(fixedUpdateAlpha);
 
-    ResolveCollisions();
+    reader.Read(randomGenerator);
 
-    Render();
+    reader.Read(nextObjectId);
 
-    DestroyChildObjects();
+    const auto contactCount = reader.Read<uint32_t>();
 
-    auto frameEnd = SDL_GetPerformanceCounter();
+    previousContacts.clear();
 
-    deltaTime = (frameEnd - frameStart) /
-                static_cast<double>(SDL_GetPerformanceFrequency());
+    for (uint32_t i = 0; i < contactCount && !reader.HasFailed(); i += 1)
+    {
+        CollisionContact contact{};
 
-#ifdef __EMSCRIPTEN__
-    deltaTime = std::max(deltaTime, 0.01);
-#endif
+        reader.Read(contact.key);
+        reader.Read(contact.isSwept);
+        reader.Read(contact.hit);
 
-    float elapsedSeconds = (frameStart - previousFrameStart) /
-                           (float)SDL_GetPerformanceFrequency();
+        previousContacts.emplace_back(contact);
+    }
 
-    if (elapsedSeconds >= 1)
+    const auto count = reader.Read<uint32_t>();
+
+    auto isRestored =
+        !reader.HasFailed() && count == CountSerializedChildren(children);
+
+    for (const auto &child : children)
     {
-        fps = (int)(framesThisSecond / elapsedSeconds);
-        framesThisSecond = 0;
-        previousFrameStart = frameStart;
+        if (!isRestored)
+        {
+            break;
+        }
+
+        if (child != nullptr)
+        {
+            isRestored = child->DeserializeTree(reader);
+        }
     }
 
-    SDL_Delay(1);
-}
+    // The object IDs are restored with the tree, so the contacts can only be
+    // matched up with their colliders once it's done.
 
-#ifdef __EMSCRIPTEN__
-inline void Game::StaticLoop(void *userData)
-{
-    auto *gameInstance = static_cast<Game *>(userData);
+    const auto findCollider = [this](uint32_t objectId) -> RenderObject *
+    {
+        for (const auto &collider : colliders)
+        {
+            if (collider->GetObjectId() == objectId)
+            {
+                return collider.get();
+            }
+        }
 
-    if (gameInstance != nullptr)
+        return nullptr;
+    };
+
+    for (auto &contact : previousContacts)
     {
-        gameInstance->Loop();
+        contact.a = findCollider(static_cast<uint32_t>(contact.key >> 32U));
+        contact.b = findCollider(static_cast<uint32_t>(contact.key));
     }
+
+    // A contact with an object that has since stopped colliding is dropped,
+    // its exit was already dispatched.
+
+    previousContacts.erase(
+        std::remove_if(previousContacts.begin(), previousContacts.end(),
+                       [](const CollisionContact &contact)
+                       {
+                           return contact.a == nullptr ||
+                                  contact.b == nullptr;
+                       }),
+        previousContacts.end());
+
+    return isRestored && !reader.HasFailed();
 }
-#endif
 
 inline void Game::HandleInput()
 {
@@ -643,6 +2317,8 @@ inline void Game::HandleInput()
 
     while (SDL_PollEvent(&event) != 0)
     {
+        frameRequested = true;
+
         switch (event.type)
         {
         case SDL_QUIT:
@@ -651,10 +2327,15 @@ inline void Game::HandleInput()
 
         case SDL_WINDOWEVENT:
             if (event.window.event == SDL_WINDOWEVENT_RESIZED ||
-                event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ||
-                event.window.event == SDL_WINDOWEVENT_DISPLAY_CHANGED)
+                event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+            {
+                RecalculateScreenSize();
+            }
+            else if (event.window.event == SDL_WINDOWEVENT_DISPLAY_CHANGED)
             {
                 RecalculateScreenSize();
+
+                UpdateDisplayRefreshRate();
             }
             else if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
             {
@@ -673,9 +2354,63 @@ inline void Game::HandleInput()
     }
 }
 
+/**
+ * Lay the scene graph out in the transform store again. Called by
+ * UpdateTransforms when objects were added or removed since the last
+ * rebuild.
+ */
+inline void Game::RebuildTransformStore()
+{
+    transformStore.Clear();
+
+    for (const auto &child : children)
+    {
+        if (child != nullptr)
+        {
+            child->AddToTransformStore(transformStore, NO_TRANSFORM_INDEX);
+        }
+    }
+
+    transformStore.EndRebuild();
+}
+
+/**
+ * Resolve the world rects and bounding boxes of everything that moved this
+ * frame in one pass, so rendering and collisions read them without walking
+ * the scene graph.
+ */
+inline void Game::UpdateTransforms()
+{
+    if (transformStore.IsStructureDirty())
+    {
+        RebuildTransformStore();
+    }
+
+    transformStore.Update();
+}
+
+/**
+ * Copy the children of each node into the buffer iterated during the frame, so
+ * children added or destroyed mid frame don't invalidate the iteration. Only
+ * the nodes whose children changed since the last frame are copied.
+ */
 inline void Game::PopulateChildrenBuffer()
 {
-    childrenBuffer = children;
+    if (!childrenBufferIsDirty && !descendantChildrenBufferIsDirty)
+    {
+        return;
+    }
+
+    if (childrenBufferIsDirty)
+    {
+        childrenBuffer = children;
+
+        childrenBufferIsDirty = false;
+
+        renderOrderIsDirty = true;
+    }
+
+    descendantChildrenBufferIsDirty = false;
 
     for (const auto &iter : childrenBuffer)
     {
@@ -688,6 +2423,25 @@ inline void Game::PopulateChildrenBuffer()
     }
 }
 
+inline void Game::SetChildrenBufferAsDirty()
+{
+    childrenBufferIsDirty = true;
+
+    frameRequested = true;
+}
+
+inline void Game::SetDescendantChildrenBufferAsDirty()
+{
+    descendantChildrenBufferIsDirty = true;
+}
+
+inline void Game::SetRenderOrderAsDirty()
+{
+    renderOrderChanges += 1;
+
+    frameRequested = true;
+}
+
 inline void Game::Update()
 {
     elapsedTime += deltaTime;
@@ -707,49 +2461,91 @@ inline void Game::FixedUpdate()
 {
     fixedUpdateDeltaTime += deltaTime;
 
-    if (fixedUpdateDeltaTime > fixedFrameTime)
+    int steps = 0;
+
+    while (fixedUpdateDeltaTime >= fixedFrameTime)
     {
+        if (steps >= maxFixedStepsPerFrame)
+        {
+            fixedUpdateDeltaTime =
+                std::fmod(fixedUpdateDeltaTime, fixedFrameTime);
+
+            break;
+        }
+
         for (const auto &child : childrenBuffer)
         {
             if (child != nullptr && child->IsEnabled())
             {
-                child->InternalFixedUpdate(fixedUpdateDeltaTime);
+                child->InternalFixedUpdate(fixedFrameTime);
             }
         }
 
         fixedUpdateDeltaTime -= fixedFrameTime;
+
+        steps += 1;
     }
+
+    fixedUpdateAlpha = fixedUpdateDeltaTime / fixedFrameTime;
 }
 
 inline void Game::Render()
 {
-    SDL_SetRenderDrawColor(renderer, clearColor.r, clearColor.g, clearColor.b,
-                           clearColor.a);
+    renderBatch.ResetDrawCalls();
 
-    SDL_RenderClear(renderer);
+    renderBatch.ClearScreen(clearColor);
 
-    sort(childrenBuffer.begin(), childrenBuffer.end(),
-         [](const std::shared_ptr<RenderObject> &a,
-            const std::shared_ptr<RenderObject> &b) { return a->z < b->z; });
+    SortRenderOrder(childrenBuffer, renderOrder, renderOrderIsDirty,
+                    renderOrderChanges);
 
-    for (const auto &child : childrenBuffer)
+    for (const auto i : renderOrder)
     {
+        auto *child = childrenBuffer[i].get();
+
         if (child != nullptr && child->IsEnabled())
         {
-            child->Render(renderer);
+            HANDCRANK_ENGINE_PROFILE_OBJECT_SCOPE(child);
+
+            child->RenderSubtree(renderer);
         }
     }
 
-    SDL_RenderPresent(renderer);
+#if defined(HANDCRANK_ENGINE_DEBUG) && defined(HANDCRANK_ENGINE_PROFILER)
+    if (debug)
+    {
+        GetProfiler().RenderOverlay(renderer, renderBatch);
+    }
+#endif
+
+    renderBatch.Flush();
+
+    // When recording, the frame is presented once the buffer is replayed.
+
+    if (renderBatch.GetCommandBuffer() == nullptr)
+    {
+        SDL_RenderPresent(renderer);
+    }
 }
 
 inline void Game::ResolveCollisions()
 {
-    if (colliders.empty())
+    if (colliders.empty() && previousContacts.empty())
     {
         return;
     }
 
+    // Removed colliders are held until the end of the pass so contacts that
+    // end because of the removal can still report their exit.
+
+    for (const auto &collider : colliders)
+    {
+        if (!collider->IsCollisionEnabled() ||
+            collider->HasBeenMarkedForDestroy())
+        {
+            removedColliders.emplace_back(collider);
+        }
+    }
+
     colliders.erase(
         std::remove_if(colliders.begin(), colliders.end(),
                        [](const std::shared_ptr<RenderObject> &collider)
@@ -759,6 +2555,24 @@ inline void Game::ResolveCollisions()
                        }),
         colliders.end());
 
+    FindContacts();
+
+    DispatchContacts();
+
+    std::swap(contacts, previousContacts);
+
+    for (const auto &collider : colliders)
+    {
+        collider->UpdatePreviousTransformedRect();
+    }
+
+    removedColliders.clear();
+}
+
+inline void Game::FindContacts()
+{
+    contacts.clear();
+
     const auto count = colliders.size();
 
     if (count <= 1)
@@ -766,21 +2580,202 @@ inline void Game::ResolveCollisions()
         return;
     }
 
-    for (auto i = 0; i < count - 1; i += 1)
+    colliderRects.resize(count);
+    colliderPreviousRects.resize(count);
+    colliderBounds.resize(count);
+    colliderIds.resize(count);
+    colliderContinuous.resize(count);
+    colliderLayers.resize(count);
+    colliderMasks.resize(count);
+
+    for (size_t i = 0; i < count; i += 1)
+    {
+        const auto &collider = colliders[i];
+
+        colliderRects[i] = collider->GetTransformedRect();
+        colliderPreviousRects[i] = collider->GetPreviousTransformedRect();
+        colliderIds[i] = collider->GetObjectId();
+        colliderContinuous[i] = collider->IsContinuousCollisionEnabled();
+        colliderLayers[i] = collider->GetCollisionLayer();
+        colliderMasks[i] = collider->GetCollisionMask();
+
+        // Continuous colliders enter the broadphase with the area swept over
+        // the frame so fast movers still pair with what they passed through.
+
+        colliderBounds[i] =
+            colliderContinuous[i] != 0
+                ? UnionRect(colliderPreviousRects[i], colliderRects[i])
+                : colliderRects[i];
+    }
+
+    switch (broadphaseMode)
+    {
+    case BroadphaseMode::SPATIAL_HASH:
+        spatialHash.SetBounds(viewportf);
+        spatialHash.FindPairs(colliderBounds, collisionPairs);
+        break;
+
+    case BroadphaseMode::SWEEP_AND_PRUNE:
+        sweepAndPrune.FindPairs(colliderBounds, colliderIds, collisionPairs);
+        break;
+
+    default:
+        FindAllPairs(colliderBounds, collisionPairs);
+        break;
+    }
+
+    for (const auto &pair : collisionPairs)
     {
-        const auto &rectA = colliders[i]->GetTransformedRect();
+        const auto aAcceptsB =
+            (colliderMasks[pair.a] & colliderLayers[pair.b]) != 0;
+        const auto bAcceptsA =
+            (colliderMasks[pair.b] & colliderLayers[pair.a]) != 0;
 
-        for (auto j = i + 1; j < count; j += 1)
+        if (!aAcceptsB && !bAcceptsA)
         {
-            const auto &rectB = colliders[j]->GetTransformedRect();
+            continue;
+        }
+
+        auto isSwept = false;
 
-            if (SDL_HasIntersectionF(&rectA, &rectB) == SDL_TRUE)
+        SweptCollisionHit hit{};
+
+        if (SDL_HasIntersectionF(&colliderRects[pair.a],
+                                 &colliderRects[pair.b]) != SDL_TRUE)
+        {
+            if ((colliderContinuous[pair.a] == 0 &&
+                 colliderContinuous[pair.b] == 0) ||
+                !SweptAABB(colliderPreviousRects[pair.a], colliderRects[pair.a],
+                           colliderPreviousRects[pair.b], colliderRects[pair.b],
+                           hit))
             {
-                colliders[i]->OnCollision(colliders[j]);
-                colliders[j]->OnCollision(colliders[i]);
+                continue;
             }
+
+            isSwept = true;
+        }
+
+        auto *colliderA = colliders[pair.a].get();
+        auto *colliderB = colliders[pair.b].get();
+
+        // Contacts are keyed on the object IDs, lowest first, so the same two
+        // objects produce the same key on every frame.
+
+        if (colliderA->GetObjectId() > colliderB->GetObjectId())
+        {
+            std::swap(colliderA, colliderB);
+
+            hit.normal = hit.normal * -1;
+        }
+
+        contacts.emplace_back(CollisionContact{
+            (static_cast<Uint64>(colliderA->GetObjectId()) << 32U) |
+                static_cast<Uint32>(colliderB->GetObjectId()),
+            colliderA, colliderB, isSwept, hit});
+    }
+
+    std::sort(contacts.begin(), contacts.end(),
+              [](const CollisionContact &a, const CollisionContact &b)
+              { return a.key < b.key; });
+}
+
+inline void Game::DispatchContacts()
+{
+    auto current = contacts.begin();
+    auto previous = previousContacts.begin();
+
+    while (current != contacts.end() || previous != previousContacts.end())
+    {
+        if (previous == previousContacts.end() ||
+            (current != contacts.end() && current->key < previous->key))
+        {
+            DispatchContact(*current, CollisionContactState::ENTER);
+
+            ++current;
+        }
+        else if (current == contacts.end() || previous->key < current->key)
+        {
+            DispatchContact(*previous, CollisionContactState::EXIT);
+
+            ++previous;
+        }
+        else
+        {
+            DispatchContact(*current, CollisionContactState::STAY);
+
+            ++current;
+            ++previous;
+        }
+    }
+}
+
+inline void Game::DispatchContact(const CollisionContact &contact,
+                                  CollisionContactState state)
+{
+    auto *a = contact.a;
+    auto *b = contact.b;
+
+    const auto aAcceptsB =
+        (a->GetCollisionMask() & b->GetCollisionLayer()) != 0;
+    const auto bAcceptsA =
+        (b->GetCollisionMask() & a->GetCollisionLayer()) != 0;
+
+    if (state == CollisionContactState::EXIT)
+    {
+        if (aAcceptsB && !a->HasBeenMarkedForDestroy())
+        {
+            a->OnCollisionExit(b->shared_from_this());
+        }
+
+        if (bAcceptsA && !b->HasBeenMarkedForDestroy())
+        {
+            b->OnCollisionExit(a->shared_from_this());
+        }
+
+        return;
+    }
+
+    if (contact.isSwept)
+    {
+        if (aAcceptsB && a->IsCollisionEnabled() && b->IsCollisionEnabled())
+        {
+            a->OnContinuousCollision(b->shared_from_this(), contact.hit);
+        }
+
+        if (bAcceptsA && a->IsCollisionEnabled() && b->IsCollisionEnabled())
+        {
+            b->OnContinuousCollision(
+                a->shared_from_this(),
+                SweptCollisionHit{contact.hit.time, contact.hit.normal * -1});
         }
     }
+
+    if (state == CollisionContactState::STAY)
+    {
+        if (aAcceptsB && a->IsCollisionStayEnabled() &&
+            a->IsCollisionEnabled() && b->IsCollisionEnabled())
+        {
+            a->OnCollisionStay(b->shared_from_this());
+        }
+
+        if (bAcceptsA && b->IsCollisionStayEnabled() &&
+            a->IsCollisionEnabled() && b->IsCollisionEnabled())
+        {
+            b->OnCollisionStay(a->shared_from_this());
+        }
+
+        return;
+    }
+
+    if (aAcceptsB && a->IsCollisionEnabled() && b->IsCollisionEnabled())
+    {
+        a->OnCollisionEnter(b->shared_from_this());
+    }
+
+    if (bAcceptsA && a->IsCollisionEnabled() && b->IsCollisionEnabled())
+    {
+        b->OnCollisionEnter(a->shared_from_this());
+    }
 }
 
 inline void Game::DestroyChildObjects()
@@ -793,19 +2788,39 @@ inline void Game::DestroyChildObjects()
         }
     }
 
-    children.erase(std::remove_if(children.begin(), children.end(),
-                                  [](const auto &child)
-                                  {
-                                      if (child != nullptr &&
-                                          child->HasBeenMarkedForDestroy())
-                                      {
-                                          child->OnDestroy();
+    const auto end = std::remove_if(children.begin(), children.end(),
+                                    [](const auto &child)
+                                    {
+                                        if (child != nullptr &&
+                                            child->HasBeenMarkedForDestroy())
+                                        {
+                                            child->OnDestroy();
 
-                                          return true;
-                                      }
-                                      return false;
-                                  }),
-                   children.end());
+                                            child->UnregisterObject();
+
+                                            return true;
+                                        }
+                                        return false;
+                                    });
+
+    if (end != children.end())
+    {
+        children.erase(end, children.end());
+
+        SetChildrenBufferAsDirty();
+    }
+}
+
+/**
+ * Evict unused resources from any cache that went over its budget. Cheap when
+ * no budget is set or the caches fit.
+ */
+inline void Game::TrimResourceCaches()
+{
+    GetTextureCache().Trim();
+    GetFontCache().Trim();
+    GetMusicCache().Trim();
+    GetSFXCache().Trim();
 }
 
 inline void Game::Quit() { quit = true; }
@@ -814,6 +2829,33 @@ inline void Game::Quit() { quit = true; }
 inline void Game::ToggleDebug(bool state) { debug = state; }
 inline void Game::ToggleDebug() { debug = !debug; }
 inline auto Game::IsDebug() const -> bool { return debug; }
+
+/**
+ * Translucent texture drawn over objects in debug mode. Created on first use
+ * with this game's renderer.
+ */
+inline auto Game::GetDebugRectTexture() -> SDL_Texture *
+{
+    if (debugRectTexture == nullptr && renderer != nullptr)
+    {
+        auto *tempSurface =
+            SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_RGBA32);
+
+        if (tempSurface != nullptr)
+        {
+            SDL_FillRect(tempSurface, nullptr,
+                         SDL_MapRGBA(tempSurface->format, 0, 255, 0, 100));
+
+            debugRectTexture = std::shared_ptr<SDL_Texture>(
+                SDL_CreateTextureFromSurface(renderer, tempSurface),
+                TextureDeleter());
+
+            SDL_FreeSurface(tempSurface);
+        }
+    }
+
+    return debugRectTexture.get();
+}
 #endif
 
 inline RenderObject::RenderObject()
@@ -839,6 +2881,8 @@ inline RenderObject::RenderObject(float x, float y, float w, float h)
 
 inline RenderObject::~RenderObject()
 {
+    UnregisterObject();
+
     children.clear();
     childrenBuffer.clear();
 }
@@ -866,12 +2910,24 @@ inline auto RenderObject::IsCollisionEnabled() const -> bool
 
 inline auto RenderObject::GetIndex() const -> int { return index; }
 
+/**
+ * ID of the object within its game, given when it's added to the tree and 0
+ * before. Unlike GetIndex it doesn't depend on objects other games created,
+ * and it's saved in snapshots.
+ */
+inline auto RenderObject::GetObjectId() const -> uint32_t { return objectId; }
+
 inline auto RenderObject::GetName() const -> std::string
 {
     return name.empty() ? GetClassName() : name;
 }
 inline void RenderObject::SetName(const std::string &name)
 {
+    if (isRegistered)
+    {
+        game->GetObjectRegistry().UpdateName(this, this->name, name);
+    }
+
     this->name = name;
 }
 
@@ -879,13 +2935,37 @@ inline auto RenderObject::GetTag() const -> std::string
 {
     return tag.empty() ? "untagged" : tag;
 }
-inline void RenderObject::SetTag(const std::string &tag) { this->tag = tag; }
+inline void RenderObject::SetTag(const std::string &tag)
+{
+    if (isRegistered)
+    {
+        game->GetObjectRegistry().UpdateTag(this, this->tag, tag);
+    }
+
+    this->tag = tag;
+}
 
 inline auto RenderObject::GetClassName() const -> std::string
 {
     return GetClassNameSimple(*this);
 }
 
+#ifdef HANDCRANK_ENGINE_PROFILER
+/**
+ * Class name of the object as used by profiler object zones. Interned on
+ * first use so zones don't allocate.
+ */
+inline auto RenderObject::GetProfileName() const -> const char *
+{
+    if (profileName == nullptr)
+    {
+        profileName = GetProfiler().Intern(GetClassName());
+    }
+
+    return profileName;
+}
+#endif
+
 inline auto RenderObject::ShowInHierarchy() const -> std::string
 {
     if (parent != nullptr)
@@ -910,6 +2990,10 @@ RenderObject::AddChildObject(const std::shared_ptr<RenderObject> &child)
     child->game = game;
 
     children.emplace_back(child);
+
+    child->RegisterObject();
+
+    SetChildrenBufferAsDirty();
 }
 
 template <typename T>
@@ -979,9 +3063,118 @@ inline auto RenderObject::GetChildByType(bool nested) -> std::shared_ptr<T>
 
 inline auto RenderObject::GetChildCount() -> int { return children.size(); }
 
+/**
+ * Add this object and its children to the game's registry so they can be
+ * found by type, tag and name. Called when the object is added to the tree.
+ */
+inline void RenderObject::RegisterObject()
+{
+    if (game == nullptr || isRegistered)
+    {
+        return;
+    }
+
+    registeredType = std::type_index(typeid(*this));
+
+    objectId = game->AllocateObjectId();
+
+    game->GetObjectRegistry().Register(this, registeredType, tag, name);
+
+    game->GetTransformStore().SetStructureAsDirty();
+
+    for (auto *ancestor = parent;
+         ancestor != nullptr && !ancestor->hasUnstoredDescendants;
+         ancestor = ancestor->parent)
+    {
+        ancestor->hasUnstoredDescendants = true;
+    }
+
+    isRegistered = true;
+
+    for (const auto &child : children)
+    {
+        if (child != nullptr)
+        {
+            child->game = game;
+
+            child->RegisterObject();
+        }
+    }
+}
+
+/**
+ * Remove this object and its children from the game's registry. Called when
+ * the object is destroyed.
+ */
+inline void RenderObject::UnregisterObject()
+{
+    if (!isRegistered)
+    {
+        return;
+    }
+
+    game->GetObjectRegistry().Unregister(this, registeredType, tag, name);
+
+    if (transformIndex != NO_TRANSFORM_INDEX)
+    {
+        game->GetTransformStore().Remove(transformIndex);
+
+        transformIndex = NO_TRANSFORM_INDEX;
+    }
+
+    transformedRectIsDirty = true;
+    boundingBoxIsDirty = true;
+
+    renderCacheTexture = nullptr;
+    renderCacheIsDirty = true;
+
+    isRegistered = false;
+
+    for (const auto &child : children)
+    {
+        if (child != nullptr)
+        {
+            child->UnregisterObject();
+        }
+    }
+}
+
+inline void RenderObject::AddToTransformStore(TransformStore &transformStore,
+                                              int32_t parentIndex)
+{
+    transformIndex = transformStore.Add(parentIndex, GetLocalTransformedRect(),
+                                        scale, isEnabled);
+
+    hasUnstoredDescendants = false;
+
+    for (const auto &child : children)
+    {
+        if (child != nullptr && child->isRegistered)
+        {
+            child->AddToTransformStore(transformStore, transformIndex);
+        }
+    }
+
+    transformStore.EndSubtree(transformIndex);
+}
+
 inline void RenderObject::PopulateChildrenBuffer()
 {
-    childrenBuffer = children;
+    if (!childrenBufferIsDirty && !descendantChildrenBufferIsDirty)
+    {
+        return;
+    }
+
+    if (childrenBufferIsDirty)
+    {
+        childrenBuffer = children;
+
+        childrenBufferIsDirty = false;
+
+        renderOrderIsDirty = true;
+    }
+
+    descendantChildrenBufferIsDirty = false;
 
     for (const auto &iter : childrenBuffer)
     {
@@ -994,6 +3187,80 @@ inline void RenderObject::PopulateChildrenBuffer()
     }
 }
 
+/**
+ * Flag the children of this node as changed and let every ancestor know a
+ * buffer below them needs to be rebuilt.
+ */
+inline void RenderObject::SetChildrenBufferAsDirty()
+{
+    childrenBufferIsDirty = true;
+
+    SetRenderCacheAsDirty();
+
+    if (parent != nullptr)
+    {
+        parent->SetDescendantChildrenBufferAsDirty();
+    }
+    else if (game != nullptr)
+    {
+        game->SetDescendantChildrenBufferAsDirty();
+    }
+}
+
+inline auto RenderObject::GetZ() const -> int { return z; }
+
+/**
+ * Set the draw order of this object among its siblings. Higher values are
+ * drawn on top, siblings with the same value draw in the order they were
+ * added.
+ *
+ * @param z Draw order.
+ */
+inline void RenderObject::SetZ(int z)
+{
+    if (this->z == z)
+    {
+        return;
+    }
+
+    this->z = z;
+
+    if (parent != nullptr)
+    {
+        parent->SetRenderOrderAsDirty();
+    }
+    else if (game != nullptr)
+    {
+        game->SetRenderOrderAsDirty();
+    }
+}
+
+inline void RenderObject::SetRenderOrderAsDirty()
+{
+    renderOrderChanges += 1;
+
+    SetRenderCacheAsDirty();
+}
+
+inline void RenderObject::SetDescendantChildrenBufferAsDirty()
+{
+    if (descendantChildrenBufferIsDirty)
+    {
+        return;
+    }
+
+    descendantChildrenBufferIsDirty = true;
+
+    if (parent != nullptr)
+    {
+        parent->SetDescendantChildrenBufferAsDirty();
+    }
+    else if (game != nullptr)
+    {
+        game->SetDescendantChildrenBufferAsDirty();
+    }
+}
+
 inline void RenderObject::Start() {}
 
 inline void RenderObject::Update(double deltaTime) {}
@@ -1008,11 +3275,90 @@ inline void RenderObject::OnMouseDown() {}
 
 inline void RenderObject::OnMouseUp() {}
 
+/**
+ * Called when a collision with another object starts, and on every frame it
+ * continues when collision stay is enabled.
+ *
+ * @param other The object collided with.
+ *
+ * @deprecated Use OnCollisionEnter, OnCollisionStay and OnCollisionExit.
+ */
 inline void
 RenderObject::OnCollision(const std::shared_ptr<RenderObject> &other)
 {
 }
 
+/**
+ * Called on the first frame this object overlaps another.
+ *
+ * @param other The object collided with.
+ */
+inline void
+RenderObject::OnCollisionEnter(const std::shared_ptr<RenderObject> &other)
+{
+    OnCollision(other);
+}
+
+/**
+ * Called on every frame after the first that this object overlaps another.
+ * Only called when collision stay is enabled.
+ *
+ * @param other The object collided with.
+ */
+inline void
+RenderObject::OnCollisionStay(const std::shared_ptr<RenderObject> &other)
+{
+    OnCollision(other);
+}
+
+/**
+ * Called on the first frame this object no longer overlaps another.
+ *
+ * @param other The object collided with.
+ */
+inline void
+RenderObject::OnCollisionExit(const std::shared_ptr<RenderObject> &other)
+{
+}
+
+/**
+ * Called when a continuous collider would have passed through another object
+ * during the frame. Called before OnCollisionEnter.
+ *
+ * @param other The object collided with.
+ * @param hit Time of impact from 0 to 1 and the contact normal facing this
+ * object.
+ */
+inline void RenderObject::OnContinuousCollision(
+    const std::shared_ptr<RenderObject> &other, const SweptCollisionHit &hit)
+{
+}
+
+/**
+ * Start this object and everything under it that hasn't started yet, parents
+ * before their children, without updating any of them. Children added by a
+ * Start are started too.
+ */
+inline void RenderObject::StartTree()
+{
+    if (!hasStarted)
+    {
+        Start();
+
+        hasStarted = true;
+    }
+
+    for (size_t i = 0; i < children.size(); i += 1)
+    {
+        const auto child = children[i];
+
+        if (child != nullptr)
+        {
+            child->StartTree();
+        }
+    }
+}
+
 inline void RenderObject::InternalUpdate(double deltaTime)
 {
     if (!hasStarted)
@@ -1042,45 +3388,212 @@ inline void RenderObject::InternalUpdate(double deltaTime)
             isInputHovered = true;
         }
     }
-    else if (isInputHovered)
+    else if (isInputHovered)
+    {
+        OnMouseOut();
+
+        isInputHovered = false;
+    }
+
+    if (isInputActive && game->IsMouseButtonReleased(SDL_BUTTON_LEFT))
+    {
+        OnMouseUp();
+
+        isInputActive = false;
+    }
+
+    {
+        HANDCRANK_ENGINE_PROFILE_OBJECT_SCOPE(this);
+
+        Update(deltaTime);
+    }
+
+    for (const auto &child : childrenBuffer)
+    {
+        if (child != nullptr && child->IsEnabled())
+        {
+            child->InternalUpdate(deltaTime);
+        }
+    }
+}
+
+inline void RenderObject::InternalFixedUpdate(double fixedDeltaTime)
+{
+    if (isInterpolationEnabled)
+    {
+        previousFixedTransformedRect = GetTransformedRect();
+
+        hasPreviousFixedTransformedRect = true;
+    }
+
+    FixedUpdate(fixedDeltaTime);
+
+    for (const auto &child : childrenBuffer)
+    {
+        if (child != nullptr && child->IsEnabled())
+        {
+            child->InternalFixedUpdate(fixedDeltaTime);
+        }
+    }
+}
+
+inline void RenderObject::OnDestroy() {}
+
+/**
+ * Put a destroyed object back in the state it was constructed in, so an
+ * ObjectPool can hand it out again. Resets everything RenderObject owns and
+ * then calls OnRecycle, where types reset their own state. Overrides call
+ * their base type's OnRecycle first.
+ */
+inline void RenderObject::Recycle()
+{
+    UnregisterObject();
+
+    children.clear();
+    childrenBuffer.clear();
+
+    childrenBufferIsDirty = true;
+    descendantChildrenBufferIsDirty = true;
+
+    renderOrder.clear();
+    renderOrderIsDirty = true;
+    renderOrderChanges = 0;
+
+    name.clear();
+    tag.clear();
+
+    anchor = RectAnchor::TOP | RectAnchor::LEFT;
+    scale = 1;
+    z = 0;
+
+    hasStarted = false;
+    isEnabled = true;
+
+    isCollisionEnabled = false;
+    isCollisionStayEnabled = false;
+    isContinuousCollisionEnabled = false;
+    isInterpolationEnabled = false;
+
+    isRenderCacheEnabled = false;
+
+    renderCacheTexture = nullptr;
+    renderCacheIsDirty = true;
+
+    collisionLayer = DEFAULT_COLLISION_LAYER;
+    collisionMask = DEFAULT_COLLISION_MASK;
+
+    isMarkedForDestroy = false;
+
+    isInputHovered = false;
+    isInputActive = false;
+
+    game = nullptr;
+    parent = nullptr;
+
+    SetRect(0, 0, DEFAULT_RECT_WIDTH, DEFAULT_RECT_HEIGHT);
+
+    ClearPreviousTransformedRect();
+
+    OnRecycle();
+}
+
+inline void RenderObject::OnRecycle() {}
+
+/**
+ * Write the state needed to restore this object to the same point in the
+ * simulation. Types with state of their own override it, call the base
+ * version first and read it back in the same order in Deserialize.
+ *
+ * @param writer Writer to append to.
+ */
+inline void RenderObject::Serialize(BinaryWriter &writer) const
+{
+    writer.Write(rect);
+    writer.Write(scale);
+    writer.Write(isEnabled);
+
+    writer.Write(previousTransformedRect);
+    writer.Write(hasPreviousTransformedRect);
+}
+
+inline void RenderObject::Deserialize(BinaryReader &reader)
+{
+    auto restoredRect = rect;
+    auto restoredScale = scale;
+    auto restoredIsEnabled = isEnabled;
+
+    reader.Read(restoredRect);
+    reader.Read(restoredScale);
+    reader.Read(restoredIsEnabled);
+
+    reader.Read(previousTransformedRect);
+    reader.Read(hasPreviousTransformedRect);
+
+    SetRect(restoredRect);
+    SetScale(restoredScale);
+
+    if (restoredIsEnabled && !isEnabled)
+    {
+        Enable();
+    }
+    else if (!restoredIsEnabled && isEnabled)
     {
-        OnMouseOut();
-
-        isInputHovered = false;
+        Disable();
     }
+}
 
-    if (isInputActive && game->IsMouseButtonReleased(SDL_BUTTON_LEFT))
-    {
-        OnMouseUp();
+/**
+ * Serialize this object followed by its children, depth first.
+ *
+ * @param writer Writer to append to.
+ */
+inline void RenderObject::SerializeTree(BinaryWriter &writer) const
+{
+    writer.Write(objectId);
 
-        isInputActive = false;
-    }
+    Serialize(writer);
 
-    Update(deltaTime);
+    writer.Write(CountSerializedChildren(children));
 
-    for (const auto &child : childrenBuffer)
+    for (const auto &child : children)
     {
-        if (child != nullptr && child->IsEnabled())
+        if (child != nullptr)
         {
-            child->InternalUpdate(deltaTime);
+            child->SerializeTree(writer);
         }
     }
 }
 
-inline void RenderObject::InternalFixedUpdate(double fixedDeltaTime)
+/**
+ * Deserialize a subtree written by SerializeTree.
+ *
+ * @param reader Reader positioned at this object.
+ * @return False if the snapshot ended early or the number of children
+ * changed since it was taken.
+ */
+inline auto RenderObject::DeserializeTree(BinaryReader &reader) -> bool
 {
-    FixedUpdate(fixedDeltaTime);
+    reader.Read(objectId);
 
-    for (const auto &child : childrenBuffer)
+    Deserialize(reader);
+
+    const auto count = reader.Read<uint32_t>();
+
+    if (reader.HasFailed() || count != CountSerializedChildren(children))
     {
-        if (child != nullptr && child->IsEnabled())
+        return false;
+    }
+
+    for (const auto &child : children)
+    {
+        if (child != nullptr && !child->DeserializeTree(reader))
         {
-            child->InternalFixedUpdate(fixedDeltaTime);
+            return false;
         }
     }
-}
 
-inline void RenderObject::OnDestroy() {}
+    return !reader.HasFailed();
+}
 
 inline auto RenderObject::GetRect() const -> const SDL_FRect & { return rect; }
 
@@ -1152,8 +3665,22 @@ inline void RenderObject::SetScale(float scale)
     SetBoundingBoxAsDirty();
 }
 
+/**
+ * Rect in screen space. Objects in the game's transform store read it from
+ * there, objects added since the last rebuild resolve it from their parents.
+ * The store is only rebuilt once a frame, so reads in between spawns don't
+ * lay the scene graph out again.
+ */
 inline auto RenderObject::GetTransformedRect() const -> const SDL_FRect &
 {
+    if (transformIndex != NO_TRANSFORM_INDEX)
+    {
+        transformedRect =
+            game->GetTransformStore().GetWorldRect(transformIndex);
+
+        return transformedRect;
+    }
+
     if (transformedRectIsDirty)
     {
         SetTransformedRect();
@@ -1162,31 +3689,41 @@ inline auto RenderObject::GetTransformedRect() const -> const SDL_FRect &
     return transformedRect;
 }
 
-inline void RenderObject::SetTransformedRect() const
+/**
+ * Rect with scale and anchor applied, before the parent is.
+ */
+inline auto RenderObject::GetLocalTransformedRect() const -> SDL_FRect
 {
-    transformedRect = rect;
+    auto localRect = rect;
 
-    transformedRect.w *= scale;
-    transformedRect.h *= scale;
+    localRect.w *= scale;
+    localRect.h *= scale;
 
     if ((anchor & RectAnchor::HCENTER) == RectAnchor::HCENTER)
     {
-        transformedRect.x -= transformedRect.w / 2;
+        localRect.x -= localRect.w / 2;
     }
     else if ((anchor & RectAnchor::RIGHT) == RectAnchor::RIGHT)
     {
-        transformedRect.x -= transformedRect.w;
+        localRect.x -= localRect.w;
     }
 
     if ((anchor & RectAnchor::VCENTER) == RectAnchor::VCENTER)
     {
-        transformedRect.y -= transformedRect.h / 2;
+        localRect.y -= localRect.h / 2;
     }
     else if ((anchor & RectAnchor::BOTTOM) == RectAnchor::BOTTOM)
     {
-        transformedRect.y -= transformedRect.h;
+        localRect.y -= localRect.h;
     }
 
+    return localRect;
+}
+
+inline void RenderObject::SetTransformedRect() const
+{
+    transformedRect = GetLocalTransformedRect();
+
     if (parent != nullptr)
     {
         transformedRect.x += parent->GetTransformedRect().x;
@@ -1201,12 +3738,30 @@ inline void RenderObject::SetTransformedRect() const
 
 inline void RenderObject::SetTransformedRectAsDirty()
 {
-    if (transformedRectIsDirty)
+    if (transformIndex != NO_TRANSFORM_INDEX)
     {
-        return;
+        auto &transformStore = game->GetTransformStore();
+
+        transformStore.SetLocalRect(transformIndex, GetLocalTransformedRect(),
+                                    scale);
+
+        // The store covers the whole subtree, unless children were added
+        // that it doesn't know about yet.
+
+        if (!transformStore.IsStructureDirty())
+        {
+            return;
+        }
     }
+    else
+    {
+        if (transformedRectIsDirty)
+        {
+            return;
+        }
 
-    transformedRectIsDirty = true;
+        transformedRectIsDirty = true;
+    }
 
     for (const auto &child : children)
     {
@@ -1214,8 +3769,73 @@ inline void RenderObject::SetTransformedRectAsDirty()
     }
 }
 
+inline auto RenderObject::IsInterpolationEnabled() const -> bool
+{
+    return isInterpolationEnabled;
+}
+
+/**
+ * Blend between the transforms of the last two fixed steps when rendering.
+ * Only useful for objects that move in FixedUpdate.
+ */
+inline void RenderObject::EnableInterpolation()
+{
+    isInterpolationEnabled = true;
+}
+
+inline void RenderObject::DisableInterpolation()
+{
+    isInterpolationEnabled = false;
+    hasPreviousFixedTransformedRect = false;
+}
+
+/**
+ * Transformed rect blended between the previous and current fixed step by the
+ * fixed update alpha. Falls back to the transformed rect when interpolation
+ * is disabled or no fixed step has run yet.
+ */
+inline auto RenderObject::GetInterpolatedTransformedRect() const -> SDL_FRect
+{
+    const auto &current = GetTransformedRect();
+
+    if (!isInterpolationEnabled || !hasPreviousFixedTransformedRect ||
+        game == nullptr)
+    {
+        return current;
+    }
+
+    const auto alpha = static_cast<float>(game->GetFixedUpdateAlpha());
+
+    const auto &previous = previousFixedTransformedRect;
+
+    return SDL_FRect{previous.x + ((current.x - previous.x) * alpha),
+                     previous.y + ((current.y - previous.y) * alpha),
+                     previous.w + ((current.w - previous.w) * alpha),
+                     previous.h + ((current.h - previous.h) * alpha)};
+}
+
+/**
+ * Bounds of the object and its enabled descendants in screen space. The
+ * store's bounds don't cover objects added since the last rebuild, so an
+ * object with some under it merges its children's bounds itself until then.
+ */
 inline auto RenderObject::GetBoundingBox() const -> const SDL_FRect &
 {
+    if (transformIndex != NO_TRANSFORM_INDEX && !hasUnstoredDescendants)
+    {
+        boundingBox =
+            game->GetTransformStore().GetBoundingBox(transformIndex);
+
+        return boundingBox;
+    }
+
+    if (transformIndex != NO_TRANSFORM_INDEX)
+    {
+        SetBoundingBox();
+
+        return boundingBox;
+    }
+
     if (boundingBoxIsDirty)
     {
         SetBoundingBox();
@@ -1228,7 +3848,10 @@ inline void RenderObject::SetBoundingBox() const
 {
     boundingBox = GetTransformedRect();
 
-    for (const auto &child : childrenBuffer)
+    // Children added this frame aren't in the buffer yet, but count towards
+    // the bounds the same way they do in the transform store.
+
+    for (const auto &child : children)
     {
         if (child != nullptr && child->IsEnabled())
         {
@@ -1252,6 +3875,25 @@ inline void RenderObject::SetBoundingBox() const
 
 inline void RenderObject::SetBoundingBoxAsDirty()
 {
+    // Anything that moves or toggles an object changes what its ancestors
+    // draw, even when their own bounds stay the same.
+
+    if (parent != nullptr)
+    {
+        parent->SetRenderCacheAsDirty();
+    }
+    else if (game != nullptr)
+    {
+        game->RequestFrame();
+    }
+
+    if (transformIndex != NO_TRANSFORM_INDEX)
+    {
+        game->GetTransformStore().SetEnabled(transformIndex, isEnabled);
+
+        return;
+    }
+
     if (boundingBoxIsDirty)
     {
         return;
@@ -1267,12 +3909,104 @@ inline void RenderObject::SetBoundingBoxAsDirty()
 
 inline void RenderObject::EnableCollider()
 {
-    game->AddCollider(shared_from_this());
+    if (!isCollisionEnabled)
+    {
+        game->AddCollider(shared_from_this());
+    }
 
     isCollisionEnabled = true;
 }
+
+/**
+ * Enable collisions on a layer. The object is only told about collisions
+ * with objects whose layer is included in the mask.
+ *
+ * @param layer Layer bit the object is on.
+ * @param mask Layer bits the object collides with.
+ */
+inline void RenderObject::EnableCollider(Uint32 layer, Uint32 mask)
+{
+    collisionLayer = layer;
+    collisionMask = mask;
+
+    EnableCollider();
+}
+
 inline void RenderObject::DisableCollider() { isCollisionEnabled = false; }
 
+inline auto RenderObject::IsCollisionStayEnabled() const -> bool
+{
+    return isCollisionStayEnabled;
+}
+
+inline void RenderObject::SetCollisionStayEnabled(bool enabled)
+{
+    isCollisionStayEnabled = enabled;
+}
+
+inline auto RenderObject::IsContinuousCollisionEnabled() const -> bool
+{
+    return isContinuousCollisionEnabled;
+}
+
+/**
+ * Test collisions along the path moved since the last collision pass so fast
+ * moving objects can't skip through thin colliders.
+ */
+inline void RenderObject::EnableContinuousCollision()
+{
+    isContinuousCollisionEnabled = true;
+}
+
+inline void RenderObject::DisableContinuousCollision()
+{
+    isContinuousCollisionEnabled = false;
+}
+
+inline auto RenderObject::GetPreviousTransformedRect() const
+    -> const SDL_FRect &
+{
+    return hasPreviousTransformedRect ? previousTransformedRect
+                                      : GetTransformedRect();
+}
+
+inline void RenderObject::UpdatePreviousTransformedRect()
+{
+    previousTransformedRect = GetTransformedRect();
+
+    hasPreviousTransformedRect = true;
+}
+
+/**
+ * Forget the position from the last collision pass. Call after teleporting so
+ * the jump isn't tested as movement.
+ */
+inline void RenderObject::ClearPreviousTransformedRect()
+{
+    hasPreviousTransformedRect = false;
+    hasPreviousFixedTransformedRect = false;
+}
+
+inline auto RenderObject::GetCollisionLayer() const -> Uint32
+{
+    return collisionLayer;
+}
+
+inline void RenderObject::SetCollisionLayer(Uint32 layer)
+{
+    collisionLayer = layer;
+}
+
+inline auto RenderObject::GetCollisionMask() const -> Uint32
+{
+    return collisionMask;
+}
+
+inline void RenderObject::SetCollisionMask(Uint32 mask)
+{
+    collisionMask = mask;
+}
+
 inline auto RenderObject::CanRender() const -> bool
 {
     auto boundingBox = GetBoundingBox();
@@ -1289,15 +4023,18 @@ inline void RenderObject::Render(SDL_Renderer *renderer)
         return;
     }
 
-    sort(childrenBuffer.begin(), childrenBuffer.end(),
-         [](const std::shared_ptr<RenderObject> &a,
-            const std::shared_ptr<RenderObject> &b) { return a->z < b->z; });
+    SortRenderOrder(childrenBuffer, renderOrder, renderOrderIsDirty,
+                    renderOrderChanges);
 
-    for (const auto &child : childrenBuffer)
+    for (const auto i : renderOrder)
     {
+        auto *child = childrenBuffer[i].get();
+
         if (child != nullptr && child->IsEnabled())
         {
-            child->Render(renderer);
+            HANDCRANK_ENGINE_PROFILE_OBJECT_SCOPE(child);
+
+            child->RenderSubtree(renderer);
         }
     }
 
@@ -1306,28 +4043,191 @@ inline void RenderObject::Render(SDL_Renderer *renderer)
     {
         auto transformedRect = GetTransformedRect();
 
-        if (debugRectTexture == nullptr)
-        {
-            auto *tempSurface = SDL_CreateRGBSurfaceWithFormat(
-                0, 1, 1, 32, SDL_PIXELFORMAT_RGBA32);
+        game->GetRenderBatch().Copy(game->GetDebugRectTexture(), nullptr,
+                                    &transformedRect);
+    }
+#endif
+}
 
-            if (tempSurface != nullptr)
-            {
-                SDL_FillRect(tempSurface, nullptr,
-                             SDL_MapRGBA(tempSurface->format, 0, 255, 0, 100));
+inline auto RenderObject::IsRenderCacheEnabled() const -> bool
+{
+    return isRenderCacheEnabled;
+}
 
-                debugRectTexture = std::shared_ptr<SDL_Texture>(
-                    SDL_CreateTextureFromSurface(renderer, tempSurface),
-                    SDL_DestroyTexture);
+/**
+ * Draw this object and its children into a texture the size of the bounding
+ * box once, then draw that texture with a single copy every frame until
+ * something in the subtree changes. Moving the object as a whole only moves
+ * the texture. Changes to the rect, scale, anchor, enabled state, draw order
+ * or children of anything in the subtree, and the content setters of the
+ * built-in render objects, redraw it automatically. Objects that draw
+ * something else in Render, or outside of their bounding box, need to call
+ * SetRenderCacheAsDirty themselves.
+ *
+ * Worth it for subtrees that rarely change, such as HUDs and menus.
+ */
+inline void RenderObject::EnableRenderCache()
+{
+    isRenderCacheEnabled = true;
+    renderCacheIsDirty = true;
+}
 
-                SDL_FreeSurface(tempSurface);
-            }
+inline void RenderObject::DisableRenderCache()
+{
+    isRenderCacheEnabled = false;
+
+    renderCacheTexture = nullptr;
+}
+
+/**
+ * Redraw the cached layer of this object and of every ancestor that has one
+ * the next time they are rendered, and render the next frame of an idle
+ * game.
+ */
+inline void RenderObject::SetRenderCacheAsDirty()
+{
+    auto *object = this;
+
+    while (true)
+    {
+        object->renderCacheIsDirty = true;
+
+        if (object->parent == nullptr)
+        {
+            break;
         }
 
-        SDL_RenderCopyF(renderer, debugRectTexture.get(), nullptr,
-                        &transformedRect);
+        object = object->parent;
+    }
+
+    // Something on screen changed, so an idle game renders the next frame.
+
+    if (object->game != nullptr)
+    {
+        object->game->RequestFrame();
+    }
+}
+
+/**
+ * Render this object and its children, through the render cache when it is
+ * enabled. Falls back to Render when the renderer can't draw into textures,
+ * and while debug rects are shown.
+ *
+ * @param renderer A structure representing rendering state.
+ */
+inline void RenderObject::RenderSubtree(SDL_Renderer *renderer)
+{
+    if (!isRenderCacheEnabled || renderer == nullptr)
+    {
+        Render(renderer);
+
+        return;
+    }
+
+#ifdef HANDCRANK_ENGINE_DEBUG
+    if (game->IsDebug())
+    {
+        Render(renderer);
+
+        return;
     }
 #endif
+
+    if (!CanRender())
+    {
+        return;
+    }
+
+    const auto &boundingBox = GetBoundingBox();
+
+    const auto left = static_cast<int>(std::floor(boundingBox.x));
+    const auto top = static_cast<int>(std::floor(boundingBox.y));
+
+    const auto width =
+        static_cast<int>(std::ceil(boundingBox.x + boundingBox.w)) - left;
+    const auto height =
+        static_cast<int>(std::ceil(boundingBox.y + boundingBox.h)) - top;
+
+    // The viewport can only shift what is drawn towards the top left, so
+    // anything past the top or left edge of the screen is drawn directly.
+
+    if (width <= 0 || height <= 0 || left < 0 || top < 0)
+    {
+        Render(renderer);
+
+        return;
+    }
+
+    if (renderCacheTexture == nullptr || renderCacheRect.w != width ||
+        renderCacheRect.h != height)
+    {
+        renderCacheTexture = std::shared_ptr<SDL_Texture>(
+            SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                              SDL_TEXTUREACCESS_TARGET, width, height),
+            TextureDeleter());
+
+        if (renderCacheTexture == nullptr)
+        {
+            DisableRenderCache();
+
+            Render(renderer);
+
+            return;
+        }
+
+        // Blending into a transparent texture leaves it premultiplied, so it
+        // is drawn with a premultiplied blend where the renderer allows it.
+
+        const auto premultipliedBlendMode = SDL_ComposeCustomBlendMode(
+            SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE,
+            SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+
+        if (SDL_SetTextureBlendMode(renderCacheTexture.get(),
+                                    premultipliedBlendMode) != 0)
+        {
+            SDL_SetTextureBlendMode(renderCacheTexture.get(),
+                                    SDL_BLENDMODE_BLEND);
+        }
+
+        renderCacheRect.w = width;
+        renderCacheRect.h = height;
+
+        renderCacheIsDirty = true;
+    }
+
+    auto &renderBatch = game->GetRenderBatch();
+
+    if (renderCacheIsDirty)
+    {
+        renderCacheRect.x = left;
+        renderCacheRect.y = top;
+
+        renderCacheOffset.x = boundingBox.x - static_cast<float>(left);
+        renderCacheOffset.y = boundingBox.y - static_cast<float>(top);
+
+        renderBatch.PushTarget(
+            renderCacheTexture.get(),
+            SDL_Rect{-left, -top, left + width, top + height});
+
+        renderBatch.ClearScreen(SDL_Color{0, 0, 0, 0});
+
+        Render(renderer);
+
+        renderBatch.PopTarget();
+
+        renderCacheIsDirty = false;
+    }
+
+    // Drawn relative to the bounding box, so moving the whole subtree doesn't
+    // need a redraw.
+
+    const auto destRect = SDL_FRect{boundingBox.x - renderCacheOffset.x,
+                                    boundingBox.y - renderCacheOffset.y,
+                                    static_cast<float>(width),
+                                    static_cast<float>(height)};
+
+    renderBatch.Copy(renderCacheTexture.get(), nullptr, &destRect);
 }
 
 inline auto RenderObject::CheckCollisionAABB(
@@ -1348,19 +4248,27 @@ inline void RenderObject::DestroyChildObjects()
         }
     }
 
-    children.erase(std::remove_if(children.begin(), children.end(),
-                                  [](const auto &child)
-                                  {
-                                      if (child != nullptr &&
-                                          child->HasBeenMarkedForDestroy())
-                                      {
-                                          child->OnDestroy();
+    const auto end = std::remove_if(children.begin(), children.end(),
+                                    [](const auto &child)
+                                    {
+                                        if (child != nullptr &&
+                                            child->HasBeenMarkedForDestroy())
+                                        {
+                                            child->OnDestroy();
+
+                                            child->UnregisterObject();
+
+                                            return true;
+                                        }
+                                        return false;
+                                    });
 
-                                          return true;
-                                      }
-                                      return false;
-                                  }),
-                   children.end());
+    if (end != children.end())
+    {
+        children.erase(end, children.end());
+
+        SetChildrenBufferAsDirty();
+    }
 }
 
 inline auto RenderObject::HasBeenMarkedForDestroy() const -> bool
@@ -1383,4 +4291,69 @@ inline void RenderObject::Destroy()
     }
 }
 
+/**
+ * Sort the indices of a children buffer by z, keeping siblings with the same z
+ * in the order they were added. The order is kept between frames. A few z
+ * changes are fixed up with an insertion sort over the previous order, more
+ * than that or a rebuilt buffer sorts from scratch.
+ *
+ * @param buffer Children buffer being drawn.
+ * @param order Indices into the buffer in draw order.
+ * @param orderIsDirty Whether the buffer was rebuilt since the last sort.
+ * @param orderChanges Number of z changes since the last sort.
+ */
+inline void
+SortRenderOrder(const std::vector<std::shared_ptr<RenderObject>> &buffer,
+                std::vector<uint32_t> &order, bool &orderIsDirty,
+                int &orderChanges)
+{
+    if (order.size() != buffer.size())
+    {
+        orderIsDirty = true;
+    }
+
+    if (!orderIsDirty && orderChanges == 0)
+    {
+        return;
+    }
+
+    const auto isDrawnBefore = [&buffer](uint32_t a, uint32_t b)
+    {
+        const auto zA = buffer[a] != nullptr ? buffer[a]->GetZ() : 0;
+        const auto zB = buffer[b] != nullptr ? buffer[b]->GetZ() : 0;
+
+        return zA != zB ? zA < zB : a < b;
+    };
+
+    if (orderIsDirty || orderChanges > RENDER_ORDER_INSERTION_SORT_LIMIT)
+    {
+        order.resize(buffer.size());
+
+        std::iota(order.begin(), order.end(), 0);
+
+        std::sort(order.begin(), order.end(), isDrawnBefore);
+    }
+    else
+    {
+        for (size_t i = 1; i < order.size(); i += 1)
+        {
+            const auto current = order[i];
+
+            auto j = i;
+
+            while (j > 0 && isDrawnBefore(current, order[j - 1]))
+            {
+                order[j] = order[j - 1];
+
+                j -= 1;
+            }
+
+            order[j] = current;
+        }
+    }
+
+    orderIsDirty = false;
+    orderChanges = 0;
+}
+
 } // namespace HandcrankEngine
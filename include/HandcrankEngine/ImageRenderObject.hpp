@@ -33,21 +33,49 @@ class ImageRenderObject : public TextureRenderObject
 
     SDL_RendererFlip flip = SDL_FLIP_NONE;
 
+    SDL_Texture *sizedTexture = nullptr;
+
+    int textureWidth = 0;
+    int textureHeight = 0;
+
   public:
     using TextureRenderObject::TextureRenderObject;
 
-    void SetSrcRect(const SDL_Rect &srcRect)
+    void OnRecycle() override
     {
-        this->srcRect.x = srcRect.x;
-        this->srcRect.y = srcRect.y;
-        this->srcRect.w = srcRect.w;
-        this->srcRect.h = srcRect.h;
+        TextureRenderObject::OnRecycle();
 
-        srcRectSet = true;
+        srcRect = SDL_Rect();
+        srcRectSet = false;
+
+        centerPoint = SDL_FPoint();
+
+        tintColor = SDL_Color{MAX_R, MAX_G, MAX_B, MAX_ALPHA};
+        alpha = MAX_ALPHA;
+
+        flip = SDL_FLIP_NONE;
+
+        sizedTexture = nullptr;
+
+        textureWidth = 0;
+        textureHeight = 0;
+    }
+
+    void SetSrcRect(const SDL_Rect &srcRect)
+    {
+        SetSrcRect(srcRect.x, srcRect.y, srcRect.w, srcRect.h);
     }
 
     void SetSrcRect(int x, int y, int w, int h)
     {
+        // Sprites set this every frame, only a new frame needs a redraw.
+
+        if (!srcRectSet || this->srcRect.x != x || this->srcRect.y != y ||
+            this->srcRect.w != w || this->srcRect.h != h)
+        {
+            SetRenderCacheAsDirty();
+        }
+
         this->srcRect.x = x;
         this->srcRect.y = y;
         this->srcRect.w = w;
@@ -56,11 +84,18 @@ class ImageRenderObject : public TextureRenderObject
         srcRectSet = true;
     }
 
-    void SetFlip(const SDL_RendererFlip flip) { this->flip = flip; }
+    void SetFlip(const SDL_RendererFlip flip)
+    {
+        this->flip = flip;
+
+        SetRenderCacheAsDirty();
+    }
 
     void SetTintColor(const SDL_Color &tintColor)
     {
         this->tintColor = tintColor;
+
+        SetRenderCacheAsDirty();
     }
 
     void SetTintColor(const Uint8 r, const Uint8 g, const Uint8 b)
@@ -68,6 +103,8 @@ class ImageRenderObject : public TextureRenderObject
         this->tintColor.r = r;
         this->tintColor.g = g;
         this->tintColor.b = b;
+
+        SetRenderCacheAsDirty();
     }
 
     [[nodiscard]] auto GetTintColor() const -> const SDL_Color &
@@ -75,7 +112,12 @@ class ImageRenderObject : public TextureRenderObject
         return tintColor;
     }
 
-    void SetAlpha(int alpha) { this->alpha = alpha; }
+    void SetAlpha(int alpha)
+    {
+        this->alpha = alpha;
+
+        SetRenderCacheAsDirty();
+    }
 
     [[nodiscard]] auto GetAlpha() const -> int { return alpha; }
 
@@ -91,14 +133,33 @@ class ImageRenderObject : public TextureRenderObject
             return;
         }
 
-        auto transformedRect = GetTransformedRect();
-
-        SDL_SetTextureColorMod(texture, tintColor.r, tintColor.g, tintColor.b);
+        if (sizedTexture != texture)
+        {
+            SDL_QueryTexture(texture, nullptr, nullptr, &textureWidth,
+                             &textureHeight);
 
-        SDL_SetTextureAlphaMod(texture, alpha);
+            sizedTexture = texture;
+        }
 
-        SDL_RenderCopyExF(renderer, texture, srcRectSet ? &srcRect : nullptr,
-                          &transformedRect, 0, &centerPoint, flip);
+        const auto transformedRect = GetInterpolatedTransformedRect();
+
+        // Tinted through the vertex colors rather than the texture, so images
+        // sharing an atlas page batch into one draw call.
+
+        const auto sourceRect =
+            srcRectSet ? SDL_FRect{static_cast<float>(srcRect.x),
+                                   static_cast<float>(srcRect.y),
+                                   static_cast<float>(srcRect.w),
+                                   static_cast<float>(srcRect.h)}
+                       : SDL_FRect{0, 0, static_cast<float>(textureWidth),
+                                   static_cast<float>(textureHeight)};
+
+        game->GetRenderBatch().CopyQuad(
+            texture, static_cast<float>(textureWidth),
+            static_cast<float>(textureHeight), sourceRect, transformedRect,
+            SDL_Color{tintColor.r, tintColor.g, tintColor.b,
+                      static_cast<Uint8>(alpha)},
+            flip);
 
         RenderObject::Render(renderer);
     }
@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 
@@ -17,48 +20,161 @@
 namespace HandcrankEngine
 {
 
-inline const int DEFAULT_KEY_MAP_SIZE = 250;
-inline const int DEFAULT_MOUSE_BUTTON_MAP_SIZE = 48;
 inline const int DEFAULT_CONNECTED_GAME_CONTROLLER_MAP_SIZE = 12;
-inline const int DEFAULT_GAME_CONTROLLER_BUTTON_MAP_SIZE = 25;
 
+inline const size_t MOUSE_BUTTON_STATE_SIZE = UINT8_MAX + 1;
+
+using KeyMask = std::bitset<SDL_NUM_SCANCODES>;
+using MouseButtonMask = std::bitset<MOUSE_BUTTON_STATE_SIZE>;
+using ControllerButtonMask = std::bitset<SDL_CONTROLLER_BUTTON_MAX>;
+
+/**
+ * Build a mask of keys to test several keys with a single query. Build it
+ * once, not every frame.
+ *
+ * @param scancodes Physical keys to include.
+ */
+[[nodiscard]] inline auto
+MakeKeyMask(const std::vector<SDL_Scancode> &scancodes) -> KeyMask
+{
+    KeyMask mask;
+
+    for (const auto scancode : scancodes)
+    {
+        if (scancode > SDL_SCANCODE_UNKNOWN && scancode < SDL_NUM_SCANCODES)
+        {
+            mask.set(scancode);
+        }
+    }
+
+    return mask;
+}
+
+/**
+ * Build a mask of keys from key codes, using the current keyboard layout.
+ *
+ * @param keyCodes Virtual keys to include.
+ */
+[[nodiscard]] inline auto
+MakeKeyCodeMask(const std::vector<SDL_Keycode> &keyCodes) -> KeyMask
+{
+    KeyMask mask;
+
+    for (const auto keyCode : keyCodes)
+    {
+        const auto scancode = SDL_GetScancodeFromKey(keyCode);
+
+        if (scancode > SDL_SCANCODE_UNKNOWN && scancode < SDL_NUM_SCANCODES)
+        {
+            mask.set(scancode);
+        }
+    }
+
+    return mask;
+}
+
+/**
+ * Build a mask of controller buttons to test several buttons with a single
+ * query.
+ *
+ * @param controllerButtons Buttons to include.
+ */
+[[nodiscard]] inline auto MakeControllerButtonMask(
+    const std::vector<SDL_GameControllerButton> &controllerButtons)
+    -> ControllerButtonMask
+{
+    ControllerButtonMask mask;
+
+    for (const auto controllerButton : controllerButtons)
+    {
+        if (controllerButton > SDL_CONTROLLER_BUTTON_INVALID &&
+            controllerButton < SDL_CONTROLLER_BUTTON_MAX)
+        {
+            mask.set(controllerButton);
+        }
+    }
+
+    return mask;
+}
+
+/**
+ * Everything InputHandler answers queries from for one frame, so it can be
+ * recorded and played back. The bounced masks hold what was pressed and
+ * released, or released and pressed again, within the frame, which the
+ * state alone doesn't show.
+ */
+struct InputState
+{
+    KeyMask keys;
+
+    MouseButtonMask mouseButtons;
+
+    ControllerButtonMask controllerButtons;
+
+    SDL_FPoint mousePosition{};
+
+    KeyMask bouncedKeys;
+
+    MouseButtonMask bouncedMouseButtons;
+
+    ControllerButtonMask bouncedControllerButtons;
+};
+
+/**
+ * Keyboard, mouse and controller state kept as bitsets indexed by scancode,
+ * mouse button and controller button. Presses and releases are latched as
+ * the events arrive and cleared at the start of each frame, so a key tapped
+ * within a single frame still reads as pressed and released.
+ */
 class InputHandler
 {
   protected:
     SDL_Event event;
 
-    std::unordered_map<SDL_Keycode, bool> keyState;
-    std::unordered_map<SDL_Keycode, bool> keyPressedState;
-    std::unordered_map<SDL_Keycode, bool> keyReleasedState;
+    KeyMask keyState;
+    KeyMask previousKeyState;
+    KeyMask pressedKeys;
+    KeyMask releasedKeys;
 
     SDL_FPoint mousePosition{};
 
-    std::unordered_map<Uint8, bool> mouseState;
-    std::unordered_map<Uint8, bool> mousePressedState;
-    std::unordered_map<Uint8, bool> mouseReleasedState;
+    MouseButtonMask mouseState;
+    MouseButtonMask previousMouseState;
+    MouseButtonMask pressedMouseButtons;
+    MouseButtonMask releasedMouseButtons;
 
     std::unordered_map<Uint8, SDL_GameController *> connectedControllers;
 
-    std::unordered_map<SDL_GameControllerButton, bool> controllerButtonState;
-    std::unordered_map<SDL_GameControllerButton, bool>
-        controllerButtonPressedState;
-    std::unordered_map<SDL_GameControllerButton, bool>
-        controllerButtonReleasedState;
+    ControllerButtonMask controllerButtonState;
+    ControllerButtonMask previousControllerButtonState;
+    ControllerButtonMask pressedControllerButtons;
+    ControllerButtonMask releasedControllerButtons;
 
   public:
     inline InputHandler();
 
-    void HandleInputSetup();
-    void HandleInputPollEvent(SDL_Event event);
+    inline void HandleInputSetup();
+    inline void HandleInputPollEvent(SDL_Event event);
+
+    [[nodiscard]] inline auto GetInputState() const -> InputState;
+    inline void SetInputState(const InputState &state);
 
+    [[nodiscard]] inline auto IsKeyDown(SDL_Scancode scancode) const -> bool;
     [[nodiscard]] inline auto IsKeyDown(SDL_Keycode keyCode) const -> bool;
+    [[nodiscard]] inline auto IsKeyDown(const KeyMask &mask) const -> bool;
     [[nodiscard]] inline auto
     IsKeyDown(const std::vector<SDL_Keycode> &keyCodes) const -> bool;
     [[nodiscard]] inline auto IsAnyKeyPressed() const -> bool;
+    [[nodiscard]] inline auto IsKeyPressed(SDL_Scancode scancode) const
+        -> bool;
     [[nodiscard]] inline auto IsKeyPressed(SDL_Keycode keyCode) const -> bool;
+    [[nodiscard]] inline auto IsKeyPressed(const KeyMask &mask) const -> bool;
     [[nodiscard]] inline auto
     IsKeyPressed(const std::vector<SDL_Keycode> &keyCodes) const -> bool;
+    [[nodiscard]] inline auto IsKeyReleased(SDL_Scancode scancode) const
+        -> bool;
     [[nodiscard]] inline auto IsKeyReleased(SDL_Keycode keyCode) const -> bool;
+    [[nodiscard]] inline auto IsKeyReleased(const KeyMask &mask) const -> bool;
     [[nodiscard]] inline auto
     IsKeyReleased(const std::vector<SDL_Keycode> &keyCodes) const -> bool;
 
@@ -74,6 +190,8 @@ class InputHandler
     [[nodiscard]] inline auto
     IsControllerButtonDown(SDL_GameControllerButton controllerButton) const
         -> bool;
+    [[nodiscard]] inline auto
+    IsControllerButtonDown(const ControllerButtonMask &mask) const -> bool;
     [[nodiscard]] inline auto IsControllerButtonDown(
         const std::vector<SDL_GameControllerButton> &controllerButtons) const
         -> bool;
@@ -81,51 +199,49 @@ class InputHandler
     [[nodiscard]] inline auto
     IsControllerButtonPressed(SDL_GameControllerButton controllerButton) const
         -> bool;
+    [[nodiscard]] inline auto
+    IsControllerButtonPressed(const ControllerButtonMask &mask) const -> bool;
     [[nodiscard]] inline auto IsControllerButtonPressed(
         const std::vector<SDL_GameControllerButton> &controllerButtons) const
         -> bool;
     [[nodiscard]] inline auto
     IsControllerButtonReleased(SDL_GameControllerButton controllerButton) const
         -> bool;
+    [[nodiscard]] inline auto
+    IsControllerButtonReleased(const ControllerButtonMask &mask) const -> bool;
     [[nodiscard]] inline auto IsControllerButtonReleased(
         const std::vector<SDL_GameControllerButton> &controllerButtons) const
         -> bool;
+
+  private:
+    [[nodiscard]] static inline auto IsValidScancode(SDL_Scancode scancode)
+        -> bool;
+    [[nodiscard]] static inline auto
+    IsValidControllerButton(SDL_GameControllerButton controllerButton) -> bool;
 };
 
 InputHandler::InputHandler()
 {
-    keyState.reserve(DEFAULT_KEY_MAP_SIZE);
-    keyPressedState.reserve(DEFAULT_KEY_MAP_SIZE);
-    keyReleasedState.reserve(DEFAULT_KEY_MAP_SIZE);
-
-    mouseState.reserve(DEFAULT_MOUSE_BUTTON_MAP_SIZE);
-    mousePressedState.reserve(DEFAULT_MOUSE_BUTTON_MAP_SIZE);
-    mouseReleasedState.reserve(DEFAULT_MOUSE_BUTTON_MAP_SIZE);
-
     connectedControllers.reserve(DEFAULT_CONNECTED_GAME_CONTROLLER_MAP_SIZE);
-
-    controllerButtonState.reserve(DEFAULT_GAME_CONTROLLER_BUTTON_MAP_SIZE);
-    controllerButtonPressedState.reserve(
-        DEFAULT_GAME_CONTROLLER_BUTTON_MAP_SIZE);
-    controllerButtonReleasedState.reserve(
-        DEFAULT_GAME_CONTROLLER_BUTTON_MAP_SIZE);
 }
 
 void InputHandler::HandleInputSetup()
 {
-    keyPressedState.clear();
-    keyReleasedState.clear();
-
-    mousePressedState.clear();
-    mouseReleasedState.clear();
-
-    controllerButtonPressedState.clear();
-    controllerButtonReleasedState.clear();
+    previousKeyState = keyState;
+    previousMouseState = mouseState;
+    previousControllerButtonState = controllerButtonState;
+
+    pressedKeys.reset();
+    releasedKeys.reset();
+    pressedMouseButtons.reset();
+    releasedMouseButtons.reset();
+    pressedControllerButtons.reset();
+    releasedControllerButtons.reset();
 }
 
 void InputHandler::HandleInputPollEvent(const SDL_Event event)
 {
-    auto keyCode = event.key.keysym.sym;
+    auto scancode = event.key.keysym.scancode;
 
     auto mouseButtonIndex = event.button.button;
     auto controllerButton = (SDL_GameControllerButton)event.cbutton.button;
@@ -133,13 +249,19 @@ void InputHandler::HandleInputPollEvent(const SDL_Event event)
     switch (event.type)
     {
     case SDL_KEYDOWN:
-        keyPressedState[keyCode] = !keyState[keyCode];
-        keyState[keyCode] = true;
+        if (IsValidScancode(scancode) && !keyState.test(scancode))
+        {
+            keyState.set(scancode);
+            pressedKeys.set(scancode);
+        }
         break;
 
     case SDL_KEYUP:
-        keyState[keyCode] = false;
-        keyReleasedState[keyCode] = true;
+        if (IsValidScancode(scancode) && keyState.test(scancode))
+        {
+            keyState.reset(scancode);
+            releasedKeys.set(scancode);
+        }
         break;
 
     case SDL_MOUSEMOTION:
@@ -148,13 +270,19 @@ void InputHandler::HandleInputPollEvent(const SDL_Event event)
         break;
 
     case SDL_MOUSEBUTTONDOWN:
-        mousePressedState[mouseButtonIndex] = !mouseState[mouseButtonIndex];
-        mouseState[mouseButtonIndex] = true;
+        if (!mouseState.test(mouseButtonIndex))
+        {
+            mouseState.set(mouseButtonIndex);
+            pressedMouseButtons.set(mouseButtonIndex);
+        }
         break;
 
     case SDL_MOUSEBUTTONUP:
-        mouseState[mouseButtonIndex] = false;
-        mouseReleasedState[mouseButtonIndex] = true;
+        if (mouseState.test(mouseButtonIndex))
+        {
+            mouseState.reset(mouseButtonIndex);
+            releasedMouseButtons.set(mouseButtonIndex);
+        }
         break;
 
     case SDL_CONTROLLERDEVICEADDED:
@@ -192,13 +320,20 @@ void InputHandler::HandleInputPollEvent(const SDL_Event event)
         break;
 
     case SDL_CONTROLLERBUTTONDOWN:
-        controllerButtonPressedState[controllerButton] =
-            !controllerButtonState[controllerButton];
-        controllerButtonState[controllerButton] = true;
+        if (IsValidControllerButton(controllerButton) &&
+            !controllerButtonState.test(controllerButton))
+        {
+            controllerButtonState.set(controllerButton);
+            pressedControllerButtons.set(controllerButton);
+        }
         break;
     case SDL_CONTROLLERBUTTONUP:
-        controllerButtonState[controllerButton] = false;
-        controllerButtonReleasedState[controllerButton] = true;
+        if (IsValidControllerButton(controllerButton) &&
+            controllerButtonState.test(controllerButton))
+        {
+            controllerButtonState.reset(controllerButton);
+            releasedControllerButtons.set(controllerButton);
+        }
         break;
 
     default:
@@ -206,53 +341,121 @@ void InputHandler::HandleInputPollEvent(const SDL_Event event)
     }
 }
 
+auto InputHandler::GetInputState() const -> InputState
+{
+    return InputState{keyState,
+                      mouseState,
+                      controllerButtonState,
+                      mousePosition,
+                      pressedKeys & releasedKeys,
+                      pressedMouseButtons & releasedMouseButtons,
+                      pressedControllerButtons & releasedControllerButtons};
+}
+
+/**
+ * Replace the current input state, e.g. with a frame read from an InputLog.
+ * Pressed and released are worked out again against the state at the end of
+ * the last frame, plus whatever bounced within this one.
+ *
+ * @param state Input state to use for this frame.
+ */
+void InputHandler::SetInputState(const InputState &state)
+{
+    keyState = state.keys;
+    mouseState = state.mouseButtons;
+    controllerButtonState = state.controllerButtons;
+    mousePosition = state.mousePosition;
+
+    pressedKeys = (keyState & ~previousKeyState) | state.bouncedKeys;
+    releasedKeys = (previousKeyState & ~keyState) | state.bouncedKeys;
+
+    pressedMouseButtons =
+        (mouseState & ~previousMouseState) | state.bouncedMouseButtons;
+    releasedMouseButtons =
+        (previousMouseState & ~mouseState) | state.bouncedMouseButtons;
+
+    pressedControllerButtons =
+        (controllerButtonState & ~previousControllerButtonState) |
+        state.bouncedControllerButtons;
+    releasedControllerButtons =
+        (previousControllerButtonState & ~controllerButtonState) |
+        state.bouncedControllerButtons;
+}
+
+auto InputHandler::IsKeyDown(const SDL_Scancode scancode) const -> bool
+{
+    return IsValidScancode(scancode) && keyState.test(scancode);
+};
+
+/**
+ * Key codes are looked up through the current keyboard layout on each call,
+ * prefer scancodes or a KeyMask for keys checked every frame.
+ */
 auto InputHandler::IsKeyDown(const SDL_Keycode keyCode) const -> bool
 {
-    auto result = keyState.find(keyCode);
+    return IsKeyDown(SDL_GetScancodeFromKey(keyCode));
+};
 
-    return result != keyState.end() && result->second;
+auto InputHandler::IsKeyDown(const KeyMask &mask) const -> bool
+{
+    return (keyState & mask).any();
 };
 
+/**
+ * Builds a mask from the key codes on each call, for one-off checks. Keys
+ * checked every frame should use a KeyMask built once with MakeKeyMask.
+ */
 auto InputHandler::IsKeyDown(const std::vector<SDL_Keycode> &keyCodes) const
     -> bool
 {
-    return std::any_of(keyCodes.begin(), keyCodes.end(),
-                       [this](SDL_Keycode val) { return IsKeyDown(val); });
+    return IsKeyDown(MakeKeyCodeMask(keyCodes));
 };
 
 auto InputHandler::IsAnyKeyPressed() const -> bool
 {
-    auto result = keyPressedState.size() > 0;
+    return pressedKeys.any();
+};
 
-    return result;
+auto InputHandler::IsKeyPressed(const SDL_Scancode scancode) const -> bool
+{
+    return IsValidScancode(scancode) && pressedKeys.test(scancode);
 };
 
 auto InputHandler::IsKeyPressed(const SDL_Keycode keyCode) const -> bool
 {
-    auto result = keyPressedState.find(keyCode);
+    return IsKeyPressed(SDL_GetScancodeFromKey(keyCode));
+};
 
-    return result != keyPressedState.end() && result->second;
+auto InputHandler::IsKeyPressed(const KeyMask &mask) const -> bool
+{
+    return (pressedKeys & mask).any();
 };
 
 auto InputHandler::IsKeyPressed(const std::vector<SDL_Keycode> &keyCodes) const
     -> bool
 {
-    return std::any_of(keyCodes.begin(), keyCodes.end(),
-                       [this](SDL_Keycode val) { return IsKeyPressed(val); });
+    return IsKeyPressed(MakeKeyCodeMask(keyCodes));
+};
+
+auto InputHandler::IsKeyReleased(const SDL_Scancode scancode) const -> bool
+{
+    return IsValidScancode(scancode) && releasedKeys.test(scancode);
 };
 
 auto InputHandler::IsKeyReleased(const SDL_Keycode keyCode) const -> bool
 {
-    auto result = keyReleasedState.find(keyCode);
+    return IsKeyReleased(SDL_GetScancodeFromKey(keyCode));
+};
 
-    return result != keyReleasedState.end() && result->second;
+auto InputHandler::IsKeyReleased(const KeyMask &mask) const -> bool
+{
+    return (releasedKeys & mask).any();
 };
 
 auto InputHandler::IsKeyReleased(const std::vector<SDL_Keycode> &keyCodes) const
     -> bool
 {
-    return std::any_of(keyCodes.begin(), keyCodes.end(),
-                       [this](SDL_Keycode val) { return IsKeyReleased(val); });
+    return IsKeyReleased(MakeKeyCodeMask(keyCodes));
 };
 
 auto InputHandler::GetMousePosition() const -> SDL_FPoint
@@ -262,81 +465,101 @@ auto InputHandler::GetMousePosition() const -> SDL_FPoint
 
 auto InputHandler::IsMouseButtonDown(const Uint8 buttonIndex) const -> bool
 {
-    auto result = mouseState.find(buttonIndex);
-
-    return result != mouseState.end() && result->second;
+    return mouseState.test(buttonIndex);
 };
 
 auto InputHandler::IsMouseButtonPressed(const Uint8 buttonIndex) const -> bool
 {
-    auto result = mousePressedState.find(buttonIndex);
-
-    return result != mousePressedState.end() && result->second;
+    return pressedMouseButtons.test(buttonIndex);
 };
 
 auto InputHandler::IsMouseButtonReleased(const Uint8 buttonIndex) const -> bool
 {
-    auto result = mouseReleasedState.find(buttonIndex);
-
-    return result != mouseReleasedState.end() && result->second;
+    return releasedMouseButtons.test(buttonIndex);
 };
 
 auto InputHandler::IsControllerButtonDown(
     const SDL_GameControllerButton controllerButton) const -> bool
 {
-    auto result = controllerButtonState.find(controllerButton);
+    return IsValidControllerButton(controllerButton) &&
+           controllerButtonState.test(controllerButton);
+};
 
-    return result != controllerButtonState.end() && result->second;
+auto InputHandler::IsControllerButtonDown(
+    const ControllerButtonMask &mask) const -> bool
+{
+    return (controllerButtonState & mask).any();
 };
 
+/**
+ * Builds a mask from the buttons on each call, for one-off checks. Buttons
+ * checked every frame should use a mask built once with
+ * MakeControllerButtonMask.
+ */
 auto InputHandler::IsControllerButtonDown(
     const std::vector<SDL_GameControllerButton> &controllerButtons) const
     -> bool
 {
-    return std::any_of(controllerButtons.begin(), controllerButtons.end(),
-                       [this](SDL_GameControllerButton val)
-                       { return IsControllerButtonDown(val); });
+    return IsControllerButtonDown(MakeControllerButtonMask(controllerButtons));
 };
 
 auto InputHandler::IsAnyControllerButtonPressed() const -> bool
 {
-    auto result = controllerButtonPressedState.size() > 0;
-
-    return result;
+    return pressedControllerButtons.any();
 };
 
 auto InputHandler::IsControllerButtonPressed(
     const SDL_GameControllerButton controllerButton) const -> bool
 {
-    auto result = controllerButtonPressedState.find(controllerButton);
+    return IsValidControllerButton(controllerButton) &&
+           pressedControllerButtons.test(controllerButton);
+};
 
-    return result != controllerButtonPressedState.end() && result->second;
+auto InputHandler::IsControllerButtonPressed(
+    const ControllerButtonMask &mask) const -> bool
+{
+    return (pressedControllerButtons & mask).any();
 };
 
 auto InputHandler::IsControllerButtonPressed(
     const std::vector<SDL_GameControllerButton> &controllerButtons) const
     -> bool
 {
-    return std::any_of(controllerButtons.begin(), controllerButtons.end(),
-                       [this](SDL_GameControllerButton val)
-                       { return IsControllerButtonPressed(val); });
+    return IsControllerButtonPressed(
+        MakeControllerButtonMask(controllerButtons));
 };
 
 auto InputHandler::IsControllerButtonReleased(
     const SDL_GameControllerButton controllerButton) const -> bool
 {
-    auto result = controllerButtonReleasedState.find(controllerButton);
+    return IsValidControllerButton(controllerButton) &&
+           releasedControllerButtons.test(controllerButton);
+};
 
-    return result != controllerButtonReleasedState.end() && result->second;
+auto InputHandler::IsControllerButtonReleased(
+    const ControllerButtonMask &mask) const -> bool
+{
+    return (releasedControllerButtons & mask).any();
 };
 
 auto InputHandler::IsControllerButtonReleased(
     const std::vector<SDL_GameControllerButton> &controllerButtons) const
     -> bool
 {
-    return std::any_of(controllerButtons.begin(), controllerButtons.end(),
-                       [this](SDL_GameControllerButton val)
-                       { return IsControllerButtonReleased(val); });
+    return IsControllerButtonReleased(
+        MakeControllerButtonMask(controllerButtons));
+};
+
+auto InputHandler::IsValidScancode(const SDL_Scancode scancode) -> bool
+{
+    return scancode > SDL_SCANCODE_UNKNOWN && scancode < SDL_NUM_SCANCODES;
+};
+
+auto InputHandler::IsValidControllerButton(
+    const SDL_GameControllerButton controllerButton) -> bool
+{
+    return controllerButton > SDL_CONTROLLER_BUTTON_INVALID &&
+           controllerButton < SDL_CONTROLLER_BUTTON_MAX;
 };
 
 } // namespace HandcrankEngine
@@ -0,0 +1,453 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <SDL.h>
+
+#include "BinaryStream.hpp"
+#include "InputHandler.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const char *const INPUT_LOG_MAGIC = "HCIN";
+
+inline const uint32_t INPUT_LOG_VERSION = 1;
+
+inline const size_t INPUT_LOG_HEADER_SIZE = 12;
+
+inline const uint8_t INPUT_FRAME_MOUSE_MOVED = 0x01;
+inline const uint8_t INPUT_FRAME_FOCUSED = 0x02;
+
+enum class InputDevice : uint8_t
+{
+    KEY,
+    MOUSE_BUTTON,
+    CONTROLLER_BUTTON
+};
+
+/**
+ * Bits of a toggle below the device, enough for every scancode.
+ */
+inline const int INPUT_TOGGLE_INDEX_BITS = 12;
+
+inline const uint16_t INPUT_TOGGLE_DEVICE_MASK = 0x07;
+
+/**
+ * Set on a toggle for a key or button pressed and released, or released and
+ * pressed, within the frame, which leaves its state unchanged.
+ */
+inline const uint16_t INPUT_TOGGLE_BOUNCE = 0x8000;
+
+/**
+ * Per-frame input in an append-only binary format, read back one frame at a
+ * time. After a 12 byte header of magic, version and random seed, each frame
+ * is its delta time, a flags byte, the mouse position when it moved, and the
+ * keys and buttons that changed since the previous frame, or bounced within
+ * it, as a count followed by one u16 each. A frame with no input changes is
+ * 11 bytes.
+ *
+ * Frames can be written to a stream as they are recorded, so a crash still
+ * leaves every frame up to it on disk. Bytes written to the stream are
+ * dropped from memory, so a streamed recording doesn't grow for the whole
+ * session. A log played back keeps its bytes in memory.
+ */
+class InputLog
+{
+  private:
+    std::vector<uint8_t> bytes;
+
+    uint32_t seed = 0;
+
+    InputState writeState;
+    InputState readState;
+
+    size_t readPosition = INPUT_LOG_HEADER_SIZE;
+
+    uint32_t frameCount = 0;
+
+    SDL_RWops *stream = nullptr;
+
+    bool hasHeader = false;
+
+    template <size_t N>
+    static void WriteToggles(BinaryWriter &writer, const std::bitset<N> &bits,
+                             InputDevice device, uint16_t flags,
+                             uint16_t &count)
+    {
+        if (bits.none())
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < N; i += 1)
+        {
+            if (bits.test(i))
+            {
+                writer.Write(static_cast<uint16_t>(
+                    flags |
+                    (static_cast<uint16_t>(device) << INPUT_TOGGLE_INDEX_BITS) |
+                    i));
+
+                count += 1;
+            }
+        }
+    }
+
+    void WriteHeader()
+    {
+        BinaryWriter writer(bytes);
+
+        writer.WriteBytes(INPUT_LOG_MAGIC, 4);
+        writer.Write(INPUT_LOG_VERSION);
+        writer.Write(seed);
+
+        hasHeader = true;
+    }
+
+    // Clearing keeps the capacity, so once the buffer holds a frame,
+    // recording to a stream doesn't allocate.
+
+    void FlushStream()
+    {
+        if (stream == nullptr || bytes.empty())
+        {
+            return;
+        }
+
+        if (SDL_RWwrite(stream, bytes.data(), 1, bytes.size()) != bytes.size())
+        {
+            SDL_Log("Failed to write input log: %s", SDL_GetError());
+        }
+
+        bytes.clear();
+    }
+
+  public:
+    InputLog() = default;
+
+    InputLog(const InputLog &) = delete;
+    auto operator=(const InputLog &) -> InputLog & = delete;
+
+    ~InputLog() { SetStream(nullptr); }
+
+    /**
+     * Clear the log and start a new recording.
+     *
+     * @param seed Random seed the recording was made with, see
+     * Game::SetRandomSeed.
+     */
+    void BeginRecording(uint32_t seed)
+    {
+        bytes.clear();
+
+        this->seed = seed;
+
+        writeState = InputState();
+
+        frameCount = 0;
+
+        hasHeader = false;
+
+        WriteHeader();
+
+        FlushStream();
+
+        Rewind();
+    }
+
+    /**
+     * Append a frame of input.
+     *
+     * @param state Input state during the frame.
+     * @param focused Whether the window had focus.
+     * @param deltaTime Length of the frame in seconds.
+     */
+    void WriteFrame(const InputState &state, bool focused, double deltaTime)
+    {
+        if (!hasHeader)
+        {
+            WriteHeader();
+        }
+
+        BinaryWriter writer(bytes);
+
+        const auto mouseMoved =
+            state.mousePosition.x != writeState.mousePosition.x ||
+            state.mousePosition.y != writeState.mousePosition.y;
+
+        writer.Write(deltaTime);
+        writer.Write(static_cast<uint8_t>(
+            (mouseMoved ? INPUT_FRAME_MOUSE_MOVED : 0) |
+            (focused ? INPUT_FRAME_FOCUSED : 0)));
+
+        if (mouseMoved)
+        {
+            writer.Write(state.mousePosition.x);
+            writer.Write(state.mousePosition.y);
+        }
+
+        // The count goes ahead of the toggles, so it's patched in afterwards.
+
+        const auto countOffset = writer.GetSize();
+
+        uint16_t count = 0;
+
+        writer.Write(count);
+
+        WriteToggles(writer, writeState.keys ^ state.keys, InputDevice::KEY, 0,
+                     count);
+        WriteToggles(writer, writeState.mouseButtons ^ state.mouseButtons,
+                     InputDevice::MOUSE_BUTTON, 0, count);
+        WriteToggles(writer,
+                     writeState.controllerButtons ^ state.controllerButtons,
+                     InputDevice::CONTROLLER_BUTTON, 0, count);
+
+        WriteToggles(writer, state.bouncedKeys, InputDevice::KEY,
+                     INPUT_TOGGLE_BOUNCE, count);
+        WriteToggles(writer, state.bouncedMouseButtons,
+                     InputDevice::MOUSE_BUTTON, INPUT_TOGGLE_BOUNCE, count);
+        WriteToggles(writer, state.bouncedControllerButtons,
+                     InputDevice::CONTROLLER_BUTTON, INPUT_TOGGLE_BOUNCE,
+                     count);
+
+        std::memcpy(bytes.data() + countOffset, &count, sizeof(count));
+
+        writeState = state;
+
+        frameCount += 1;
+
+        FlushStream();
+    }
+
+    /**
+     * Read the next frame of input.
+     *
+     * @param state Set to the input state during the frame.
+     * @param focused Set to whether the window had focus.
+     * @param deltaTime Set to the length of the frame in seconds.
+     * @return False at the end of the log or if the frame is cut short.
+     */
+    auto ReadFrame(InputState &state, bool &focused, double &deltaTime)
+        -> bool
+    {
+        BinaryReader reader(bytes);
+
+        reader.Seek(readPosition);
+
+        if (reader.IsAtEnd())
+        {
+            return false;
+        }
+
+        auto frameDeltaTime = reader.Read<double>();
+        const auto flags = reader.Read<uint8_t>();
+
+        auto frameState = readState;
+
+        frameState.bouncedKeys.reset();
+        frameState.bouncedMouseButtons.reset();
+        frameState.bouncedControllerButtons.reset();
+
+        if ((flags & INPUT_FRAME_MOUSE_MOVED) != 0)
+        {
+            reader.Read(frameState.mousePosition.x);
+            reader.Read(frameState.mousePosition.y);
+        }
+
+        const auto count = reader.Read<uint16_t>();
+
+        for (uint16_t i = 0; i < count && !reader.HasFailed(); i += 1)
+        {
+            const auto toggle = reader.Read<uint16_t>();
+
+            const auto device = static_cast<InputDevice>(
+                (toggle >> INPUT_TOGGLE_INDEX_BITS) & INPUT_TOGGLE_DEVICE_MASK);
+            const size_t index =
+                toggle & ((1U << INPUT_TOGGLE_INDEX_BITS) - 1);
+
+            const auto isBounce = (toggle & INPUT_TOGGLE_BOUNCE) != 0;
+
+            if (device == InputDevice::KEY && index < SDL_NUM_SCANCODES)
+            {
+                (isBounce ? frameState.bouncedKeys : frameState.keys)
+                    .flip(index);
+            }
+            else if (device == InputDevice::MOUSE_BUTTON &&
+                     index < MOUSE_BUTTON_STATE_SIZE)
+            {
+                (isBounce ? frameState.bouncedMouseButtons
+                          : frameState.mouseButtons)
+                    .flip(index);
+            }
+            else if (device == InputDevice::CONTROLLER_BUTTON &&
+                     index < SDL_CONTROLLER_BUTTON_MAX)
+            {
+                (isBounce ? frameState.bouncedControllerButtons
+                          : frameState.controllerButtons)
+                    .flip(index);
+            }
+        }
+
+        if (reader.HasFailed())
+        {
+            return false;
+        }
+
+        readState = frameState;
+        readPosition = reader.GetPosition();
+
+        state = frameState;
+        focused = (flags & INPUT_FRAME_FOCUSED) != 0;
+        deltaTime = frameDeltaTime;
+
+        return true;
+    }
+
+    /**
+     * Go back to the first frame.
+     */
+    void Rewind()
+    {
+        readState = InputState();
+
+        readPosition = INPUT_LOG_HEADER_SIZE;
+    }
+
+    /**
+     * Read a log from memory, replacing this one.
+     *
+     * @param data Log bytes.
+     * @param size Size of the log in bytes.
+     */
+    auto Open(const void *data, size_t size) -> bool
+    {
+        const auto *begin = static_cast<const uint8_t *>(data);
+
+        BinaryReader reader(begin, size);
+
+        char magic[4] = {};
+
+        reader.ReadBytes(magic, sizeof(magic));
+
+        const auto version = reader.Read<uint32_t>();
+        const auto logSeed = reader.Read<uint32_t>();
+
+        if (reader.HasFailed() || std::memcmp(magic, INPUT_LOG_MAGIC, 4) != 0 ||
+            version != INPUT_LOG_VERSION)
+        {
+            SDL_Log("Not an input log or an unsupported version");
+
+            return false;
+        }
+
+        bytes.assign(begin, begin + size);
+
+        hasHeader = true;
+
+        seed = logSeed;
+
+        // Frames are counted by reading through them once.
+
+        Rewind();
+
+        frameCount = 0;
+
+        InputState state;
+        auto focused = false;
+        double deltaTime = 0;
+
+        while (ReadFrame(state, focused, deltaTime))
+        {
+            frameCount += 1;
+        }
+
+        Rewind();
+
+        writeState = readState;
+
+        return true;
+    }
+
+    auto Load(const char *path) -> bool
+    {
+        size_t size = 0;
+
+        auto *data = SDL_LoadFile(path, &size);
+
+        if (data == nullptr)
+        {
+            SDL_Log("Failed to load input log %s: %s", path, SDL_GetError());
+
+            return false;
+        }
+
+        const auto result = Open(data, size);
+
+        SDL_free(data);
+
+        return result;
+    }
+
+    auto Save(const char *path) const -> bool
+    {
+        auto *rw = SDL_RWFromFile(path, "wb");
+
+        if (rw == nullptr)
+        {
+            SDL_Log("Failed to save input log %s: %s", path, SDL_GetError());
+
+            return false;
+        }
+
+        const auto written = SDL_RWwrite(rw, bytes.data(), 1, bytes.size());
+
+        SDL_RWclose(rw);
+
+        return written == bytes.size();
+    }
+
+    /**
+     * Write frames to a stream as they are recorded, starting with anything
+     * recorded so far that is still in memory. The log closes the stream
+     * when it's replaced or the log is destroyed. GetBytes and Save only
+     * cover frames not yet written to a stream.
+     *
+     * @param stream A writable stream, or nullptr to stop streaming.
+     */
+    void SetStream(SDL_RWops *stream)
+    {
+        if (this->stream != nullptr)
+        {
+            SDL_RWclose(this->stream);
+        }
+
+        this->stream = stream;
+
+        FlushStream();
+    }
+
+    [[nodiscard]] auto GetSeed() const -> uint32_t { return seed; }
+
+    [[nodiscard]] auto GetFrameCount() const -> uint32_t { return frameCount; }
+
+    [[nodiscard]] auto GetBytes() const -> const std::vector<uint8_t> &
+    {
+        return bytes;
+    }
+};
+
+} // namespace HandcrankEngine
@@ -0,0 +1,372 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace HandcrankEngine
+{
+
+class RenderObject;
+
+inline const size_t DEFAULT_POOL_ARENA_BLOCK_SIZE = 32;
+
+/**
+ * Fixed-size slots carved out of larger blocks. Every allocation from one
+ * arena is expected to be the same size, the size of the first one, anything
+ * else falls through to the global heap. Freed slots go on a free list and
+ * blocks are only released with the arena.
+ */
+class PoolArena
+{
+  private:
+    struct FreeSlot
+    {
+        FreeSlot *next;
+    };
+
+    size_t slotSize = 0;
+
+    size_t slotsPerBlock = DEFAULT_POOL_ARENA_BLOCK_SIZE;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+
+    FreeSlot *freeSlots = nullptr;
+
+    size_t slotsInUse = 0;
+
+    void AddBlock()
+    {
+        blocks.emplace_back(std::make_unique<std::byte[]>(
+            slotSize * slotsPerBlock));
+
+        auto *block = blocks.back().get();
+
+        for (size_t i = slotsPerBlock; i > 0; i -= 1)
+        {
+            auto *slot = reinterpret_cast<FreeSlot *>(block +
+                                                      (slotSize * (i - 1)));
+
+            slot->next = freeSlots;
+
+            freeSlots = slot;
+        }
+    }
+
+  public:
+    explicit PoolArena(size_t slotsPerBlock = DEFAULT_POOL_ARENA_BLOCK_SIZE)
+        : slotsPerBlock(std::max<size_t>(slotsPerBlock, 1))
+    {
+    }
+
+    PoolArena(const PoolArena &) = delete;
+    auto operator=(const PoolArena &) -> PoolArena & = delete;
+
+    auto Allocate(size_t size) -> void *
+    {
+        if (slotSize == 0)
+        {
+            const auto alignment = alignof(std::max_align_t);
+
+            slotSize = std::max(size, sizeof(FreeSlot));
+            slotSize = (slotSize + alignment - 1) / alignment * alignment;
+        }
+
+        if (size > slotSize)
+        {
+            return ::operator new(size);
+        }
+
+        if (freeSlots == nullptr)
+        {
+            AddBlock();
+        }
+
+        auto *slot = freeSlots;
+
+        freeSlots = slot->next;
+
+        slotsInUse += 1;
+
+        return slot;
+    }
+
+    void Deallocate(void *pointer, size_t size)
+    {
+        if (size > slotSize)
+        {
+            ::operator delete(pointer);
+
+            return;
+        }
+
+        auto *slot = static_cast<FreeSlot *>(pointer);
+
+        slot->next = freeSlots;
+
+        freeSlots = slot;
+
+        slotsInUse -= 1;
+    }
+
+    [[nodiscard]] auto GetSlotsInUse() const -> size_t { return slotsInUse; }
+
+    [[nodiscard]] auto GetSlotCapacity() const -> size_t
+    {
+        return blocks.size() * slotsPerBlock;
+    }
+
+    [[nodiscard]] auto GetBytesReserved() const -> size_t
+    {
+        return blocks.size() * slotsPerBlock * slotSize;
+    }
+};
+
+/**
+ * Allocator for std::allocate_shared that places each object and its control
+ * block in one arena slot. Holds the arena alive until the last weak pointer
+ * to anything allocated from it is gone.
+ */
+template <typename T>
+class PoolAllocator
+{
+  private:
+    std::shared_ptr<PoolArena> arena;
+
+    template <typename U>
+    friend class PoolAllocator;
+
+  public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<PoolArena> arena)
+        : arena(std::move(arena))
+    {
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &other) : arena(other.arena)
+    {
+    }
+
+    auto allocate(size_t count) -> T *
+    {
+        return static_cast<T *>(arena->Allocate(sizeof(T) * count));
+    }
+
+    void deallocate(T *pointer, size_t count)
+    {
+        arena->Deallocate(pointer, sizeof(T) * count);
+    }
+
+    template <typename U>
+    auto operator==(const PoolAllocator<U> &other) const -> bool
+    {
+        return arena == other.arena;
+    }
+
+    template <typename U>
+    auto operator!=(const PoolAllocator<U> &other) const -> bool
+    {
+        return arena != other.arena;
+    }
+};
+
+struct ObjectPoolStats
+{
+    std::string typeName;
+
+    /** Instances owned by the pool, in use or not. */
+    size_t capacity = 0;
+
+    /** Instances currently held by anything other than the pool. */
+    size_t inUse = 0;
+
+    /** Highest inUse seen when the pool grew or stats were read. */
+    size_t peakInUse = 0;
+
+    /** Instances constructed, Reserve included. */
+    size_t constructed = 0;
+
+    /** Acquires served by recycling a released instance. */
+    size_t recycled = 0;
+
+    /** Bytes of arena blocks backing the instances. */
+    size_t bytesReserved = 0;
+};
+
+class ObjectPoolBase
+{
+  public:
+    virtual ~ObjectPoolBase() = default;
+
+    [[nodiscard]] virtual auto GetStats() const -> ObjectPoolStats = 0;
+
+    virtual void Clear() = 0;
+};
+
+/**
+ * Hands out instances of one RenderObject type and takes them back once they
+ * have been destroyed. An instance is free again when the pool holds the only
+ * reference to it, which is the case after DestroyChildObjects has removed it
+ * from its parent and nothing else kept a copy. Recycled instances go through
+ * RenderObject::Recycle, which resets the engine state and calls OnRecycle
+ * for the type to reset its own.
+ *
+ * After Reserve, or once a game reaches its steady state, Acquire doesn't
+ * allocate.
+ */
+template <typename T>
+class ObjectPool : public ObjectPoolBase
+{
+  private:
+    std::shared_ptr<PoolArena> arena;
+
+    std::vector<std::shared_ptr<T>> instances;
+
+    std::vector<bool> hasBeenAcquired;
+
+    size_t cursor = 0;
+
+    mutable ObjectPoolStats stats;
+
+    auto Construct() -> size_t
+    {
+        instances.emplace_back(
+            std::allocate_shared<T>(PoolAllocator<T>(arena)));
+        hasBeenAcquired.emplace_back(false);
+
+        stats.constructed += 1;
+
+        if (stats.typeName.empty())
+        {
+            stats.typeName = instances.back()->GetClassName();
+        }
+
+        return instances.size() - 1;
+    }
+
+  public:
+    explicit ObjectPool(size_t blockSize = DEFAULT_POOL_ARENA_BLOCK_SIZE)
+        : arena(std::make_shared<PoolArena>(blockSize))
+    {
+        static_assert(std::is_base_of_v<RenderObject, T>,
+                      "T must be derived from RenderObject");
+        static_assert(std::is_default_constructible_v<T>,
+                      "T must be default constructible");
+    }
+
+    ObjectPool(const ObjectPool &) = delete;
+    auto operator=(const ObjectPool &) -> ObjectPool & = delete;
+
+    ~ObjectPool() override { Clear(); }
+
+    /**
+     * Construct instances up front so the first Acquires don't allocate.
+     *
+     * @param count Total number of instances the pool should hold.
+     */
+    void Reserve(size_t count)
+    {
+        instances.reserve(count);
+        hasBeenAcquired.reserve(count);
+
+        while (instances.size() < count)
+        {
+            Construct();
+        }
+    }
+
+    /**
+     * Get a free instance, recycling a released one when there is one and
+     * constructing a new one when there isn't.
+     */
+    [[nodiscard]] auto Acquire() -> std::shared_ptr<T>
+    {
+        const auto size = instances.size();
+
+        for (size_t i = 0; i < size; i += 1)
+        {
+            const auto index = (cursor + i) % size;
+
+            auto &instance = instances[index];
+
+            if (instance.use_count() > 1)
+            {
+                continue;
+            }
+
+            cursor = (index + 1) % size;
+
+            if (hasBeenAcquired[index])
+            {
+                instance->Recycle();
+
+                stats.recycled += 1;
+            }
+
+            hasBeenAcquired[index] = true;
+
+            return instance;
+        }
+
+        const auto index = Construct();
+
+        hasBeenAcquired[index] = true;
+
+        // Only grows when nothing was free, so every instance is in use.
+
+        stats.peakInUse = std::max(stats.peakInUse, instances.size());
+
+        return instances[index];
+    }
+
+    [[nodiscard]] auto GetInUseCount() const -> size_t
+    {
+        return std::count_if(instances.begin(), instances.end(),
+                             [](const auto &instance)
+                             { return instance.use_count() > 1; });
+    }
+
+    [[nodiscard]] auto GetCapacity() const -> size_t
+    {
+        return instances.size();
+    }
+
+    [[nodiscard]] auto GetStats() const -> ObjectPoolStats override
+    {
+        stats.capacity = instances.size();
+        stats.inUse = GetInUseCount();
+        stats.peakInUse = std::max(stats.peakInUse, stats.inUse);
+        stats.bytesReserved = arena->GetBytesReserved();
+
+        return stats;
+    }
+
+    /**
+     * Let go of every instance. Instances still in use stay alive with
+     * whatever holds them and free their slot when they are released.
+     */
+    void Clear() override
+    {
+        instances.clear();
+        hasBeenAcquired.clear();
+
+        cursor = 0;
+    }
+};
+
+} // namespace HandcrankEngine
@@ -0,0 +1,273 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace HandcrankEngine
+{
+
+class RenderObject;
+
+/**
+ * Read-only view over objects in a registry bucket. Doesn't own or copy
+ * anything, so it is only valid until objects are next added or destroyed.
+ */
+template <typename T>
+class ObjectView
+{
+  private:
+    inline static const std::vector<RenderObject *> noObjects;
+
+    const std::vector<RenderObject *> *objects = &noObjects;
+
+  public:
+    class Iterator
+    {
+      private:
+        std::vector<RenderObject *>::const_iterator iter;
+
+      public:
+        explicit Iterator(std::vector<RenderObject *>::const_iterator iter)
+            : iter(iter)
+        {
+        }
+
+        auto operator*() const -> T * { return static_cast<T *>(*iter); }
+
+        auto operator++() -> Iterator &
+        {
+            ++iter;
+
+            return *this;
+        }
+
+        auto operator!=(const Iterator &other) const -> bool
+        {
+            return iter != other.iter;
+        }
+    };
+
+    ObjectView() = default;
+
+    explicit ObjectView(const std::vector<RenderObject *> *objects)
+        : objects(objects != nullptr ? objects : &noObjects)
+    {
+    }
+
+    [[nodiscard]] auto begin() const -> Iterator
+    {
+        return Iterator(objects->begin());
+    }
+
+    [[nodiscard]] auto end() const -> Iterator
+    {
+        return Iterator(objects->end());
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return objects->size(); }
+
+    [[nodiscard]] auto empty() const -> bool { return objects->empty(); }
+
+    [[nodiscard]] auto operator[](size_t index) const -> T *
+    {
+        return static_cast<T *>((*objects)[index]);
+    }
+
+    [[nodiscard]] auto front() const -> T *
+    {
+        return empty() ? nullptr : static_cast<T *>(objects->front());
+    }
+};
+
+/**
+ * Index of live objects by their exact type, tag and name. Removing an object
+ * moves the last object in its bucket into its slot, so buckets aren't kept in
+ * the order objects were added. Lookups are a single hash lookup and never
+ * allocate.
+ */
+class ObjectRegistry
+{
+  private:
+    /**
+     * Buckets of objects for one kind of key, and each object's slot in its
+     * bucket. An object is in at most one bucket per index.
+     */
+    template <typename K>
+    struct Index
+    {
+        std::unordered_map<K, std::vector<RenderObject *>> buckets;
+
+        std::unordered_map<const RenderObject *, size_t> slots;
+    };
+
+    Index<std::type_index> byType;
+
+    Index<std::string> byTag;
+    Index<std::string> byName;
+
+    template <typename K>
+    static void Add(Index<K> &index, const K &key, RenderObject *object)
+    {
+        auto &objects = index.buckets[key];
+
+        index.slots[object] = objects.size();
+
+        objects.emplace_back(object);
+    }
+
+    template <typename K>
+    static void Remove(Index<K> &index, const K &key, RenderObject *object)
+    {
+        auto match = index.buckets.find(key);
+        auto slot = index.slots.find(object);
+
+        if (match == index.buckets.end() || slot == index.slots.end())
+        {
+            return;
+        }
+
+        auto &objects = match->second;
+        const auto position = slot->second;
+
+        if (position >= objects.size() || objects[position] != object)
+        {
+            return;
+        }
+
+        index.slots.erase(slot);
+
+        auto *last = objects.back();
+
+        objects.pop_back();
+
+        if (last != object)
+        {
+            objects[position] = last;
+            index.slots[last] = position;
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] static auto Find(const Index<K> &index, const K &key)
+        -> const std::vector<RenderObject *> *
+    {
+        auto match = index.buckets.find(key);
+
+        return match != index.buckets.end() ? &match->second : nullptr;
+    }
+
+    template <typename K>
+    static void Clear(Index<K> &index)
+    {
+        index.buckets.clear();
+        index.slots.clear();
+    }
+
+  public:
+    /**
+     * Add an object. Empty tags and names aren't indexed.
+     *
+     * @param object Object to add.
+     * @param type Exact type of the object.
+     * @param tag Tag of the object.
+     * @param name Name of the object.
+     */
+    void Register(RenderObject *object, std::type_index type,
+                  const std::string &tag, const std::string &name)
+    {
+        Add(byType, type, object);
+
+        if (!tag.empty())
+        {
+            Add(byTag, tag, object);
+        }
+
+        if (!name.empty())
+        {
+            Add(byName, name, object);
+        }
+    }
+
+    void Unregister(RenderObject *object, std::type_index type,
+                    const std::string &tag, const std::string &name)
+    {
+        Remove(byType, type, object);
+
+        if (!tag.empty())
+        {
+            Remove(byTag, tag, object);
+        }
+
+        if (!name.empty())
+        {
+            Remove(byName, name, object);
+        }
+    }
+
+    void UpdateTag(RenderObject *object, const std::string &previousTag,
+                   const std::string &tag)
+    {
+        if (!previousTag.empty())
+        {
+            Remove(byTag, previousTag, object);
+        }
+
+        if (!tag.empty())
+        {
+            Add(byTag, tag, object);
+        }
+    }
+
+    void UpdateName(RenderObject *object, const std::string &previousName,
+                    const std::string &name)
+    {
+        if (!previousName.empty())
+        {
+            Remove(byName, previousName, object);
+        }
+
+        if (!name.empty())
+        {
+            Add(byName, name, object);
+        }
+    }
+
+    template <typename T>
+    [[nodiscard]] auto FindAllByType() const -> ObjectView<T>
+    {
+        return ObjectView<T>(Find(byType, std::type_index(typeid(T))));
+    }
+
+    [[nodiscard]] auto FindAllByTag(const std::string &tag) const
+        -> ObjectView<RenderObject>
+    {
+        return ObjectView<RenderObject>(Find(byTag, tag));
+    }
+
+    [[nodiscard]] auto FindAllByName(const std::string &name) const
+        -> ObjectView<RenderObject>
+    {
+        return ObjectView<RenderObject>(Find(byName, name));
+    }
+
+    void Clear()
+    {
+        Clear(byType);
+        Clear(byTag);
+        Clear(byName);
+    }
+};
+
+} // namespace HandcrankEngine
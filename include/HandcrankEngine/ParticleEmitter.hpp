@@ -0,0 +1,431 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <SDL.h>
+
+#include "HandcrankEngine.hpp"
+#include "TextureRenderObject.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const size_t DEFAULT_PARTICLE_EMITTER_MAX_PARTICLES = 1024;
+
+inline const float DEFAULT_PARTICLE_SIZE = 4;
+
+inline const float DEFAULT_PARTICLE_LIFETIME = 1;
+
+inline const float DEFAULT_PARTICLE_SPEED = 100;
+
+inline const float DEGREES_TO_RADIANS = 3.14159265358979F / 180;
+
+/**
+ * Simulates and draws many small quads without a render object per particle.
+ * Particles are kept structure-of-arrays in buffers sized once by
+ * SetMaxParticles, so updating them is a few straight loops over floats and
+ * drawing them is a single SDL_RenderGeometry call.
+ *
+ * Particles are spawned at random points inside the transformed rect of the
+ * emitter and live in screen space from then on, so moving the emitter leaves
+ * a trail behind it. Without a texture each particle is a solid quad.
+ */
+class ParticleEmitter : public TextureRenderObject
+{
+  protected:
+    size_t maxParticles = DEFAULT_PARTICLE_EMITTER_MAX_PARTICLES;
+
+    size_t particleCount = 0;
+
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> life;
+    std::vector<float> lifetime;
+    std::vector<SDL_Color> colors;
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    SDL_Texture *quadTexture = nullptr;
+    bool quadsAreDirty = true;
+
+    SDL_FRect sourceRect = SDL_FRect();
+    bool sourceRectSet = false;
+
+    float emissionRate = 0;
+    float emissionAccumulator = 0;
+
+    float minLifetime = DEFAULT_PARTICLE_LIFETIME;
+    float maxLifetime = DEFAULT_PARTICLE_LIFETIME;
+
+    float minSpeed = DEFAULT_PARTICLE_SPEED;
+    float maxSpeed = DEFAULT_PARTICLE_SPEED;
+
+    float direction = 0;
+    float spread = 360;
+
+    Vector2 gravity = Vector2(0, 0);
+
+    float drag = 0;
+
+    float startSize = DEFAULT_PARTICLE_SIZE;
+    float endSize = DEFAULT_PARTICLE_SIZE;
+
+    SDL_Color minStartColor = DEFAULT_COLOR;
+    SDL_Color maxStartColor = DEFAULT_COLOR;
+    SDL_Color endColor = {DEFAULT_COLOR.r, DEFAULT_COLOR.g, DEFAULT_COLOR.b,
+                          0};
+
+    SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+
+  public:
+    using TextureRenderObject::TextureRenderObject;
+
+    /**
+     * Resize the particle buffers, which are otherwise allocated on the first
+     * Emit. Live particles past the new size are dropped.
+     *
+     * @param maxParticles Most particles alive at once.
+     */
+    void SetMaxParticles(size_t maxParticles)
+    {
+        this->maxParticles = maxParticles;
+
+        particleCount = std::min(particleCount, maxParticles);
+
+        positionX.resize(maxParticles);
+        positionY.resize(maxParticles);
+        velocityX.resize(maxParticles);
+        velocityY.resize(maxParticles);
+        life.resize(maxParticles);
+        lifetime.resize(maxParticles);
+        colors.resize(maxParticles);
+
+        quadsAreDirty = true;
+    }
+
+    [[nodiscard]] auto GetMaxParticles() const -> size_t
+    {
+        return maxParticles;
+    }
+
+    [[nodiscard]] auto GetParticleCount() const -> size_t
+    {
+        return particleCount;
+    }
+
+    /**
+     * Spawn particles continuously.
+     *
+     * @param emissionRate Particles per second, 0 to only emit bursts.
+     */
+    void SetEmissionRate(float emissionRate)
+    {
+        this->emissionRate = emissionRate;
+    }
+
+    void SetLifetime(float minLifetime, float maxLifetime)
+    {
+        this->minLifetime = minLifetime;
+        this->maxLifetime = maxLifetime;
+    }
+
+    void SetSpeed(float minSpeed, float maxSpeed)
+    {
+        this->minSpeed = minSpeed;
+        this->maxSpeed = maxSpeed;
+    }
+
+    /**
+     * Set which way particles are launched.
+     *
+     * @param direction Angle in degrees, 0 is to the right and 90 is down.
+     * @param spread Width of the cone around the direction, in degrees.
+     */
+    void SetDirection(float direction, float spread)
+    {
+        this->direction = direction;
+        this->spread = spread;
+    }
+
+    void SetGravity(const Vector2 &gravity) { this->gravity = gravity; }
+
+    /**
+     * Fraction of velocity lost each second.
+     *
+     * @param drag Drag value to set.
+     */
+    void SetDrag(float drag) { this->drag = drag; }
+
+    void SetParticleSize(float startSize, float endSize)
+    {
+        this->startSize = startSize;
+        this->endSize = endSize;
+    }
+
+    /**
+     * Each particle starts at a random color between two colors and fades to
+     * the end color over its life.
+     *
+     * @param minStartColor Lower bound of the start color.
+     * @param maxStartColor Upper bound of the start color.
+     * @param endColor Color at the end of life.
+     */
+    void SetColor(const SDL_Color &minStartColor,
+                  const SDL_Color &maxStartColor, const SDL_Color &endColor)
+    {
+        this->minStartColor = minStartColor;
+        this->maxStartColor = maxStartColor;
+        this->endColor = endColor;
+    }
+
+    void SetBlendMode(SDL_BlendMode blendMode)
+    {
+        this->blendMode = blendMode;
+    }
+
+    /**
+     * Part of the texture drawn for each particle. Defaults to all of it.
+     *
+     * @param sourceRect Rect in texture pixels.
+     */
+    void SetSourceRect(const SDL_FRect &sourceRect)
+    {
+        this->sourceRect = sourceRect;
+
+        sourceRectSet = true;
+
+        quadsAreDirty = true;
+    }
+
+    /**
+     * Spawn a burst of particles. Particles over the limit are not spawned.
+     *
+     * @param count Number of particles to spawn.
+     */
+    void Emit(size_t count)
+    {
+        if (positionX.size() != maxParticles)
+        {
+            SetMaxParticles(maxParticles);
+        }
+
+        const auto &spawnRect = GetTransformedRect();
+
+        const auto end = std::min(particleCount + count, maxParticles);
+
+        auto &gen =
+            game != nullptr ? game->GetRandomGenerator() : GetRandomGenerator();
+
+        for (auto i = particleCount; i < end; i += 1)
+        {
+            const auto angle =
+                (direction +
+                 RandomNumberRange(gen, -spread / 2, spread / 2)) *
+                DEGREES_TO_RADIANS;
+            const auto speed = RandomNumberRange(gen, minSpeed, maxSpeed);
+
+            positionX[i] =
+                spawnRect.x + RandomNumberRange(gen, 0.0F, spawnRect.w);
+            positionY[i] =
+                spawnRect.y + RandomNumberRange(gen, 0.0F, spawnRect.h);
+            velocityX[i] = std::cos(angle) * speed;
+            velocityY[i] = std::sin(angle) * speed;
+            lifetime[i] = RandomNumberRange(gen, minLifetime, maxLifetime);
+            life[i] = lifetime[i];
+            colors[i] = RandomColorRange(gen, minStartColor, maxStartColor);
+        }
+
+        particleCount = end;
+    }
+
+    void Clear()
+    {
+        particleCount = 0;
+
+        emissionAccumulator = 0;
+
+        SetRenderCacheAsDirty();
+    }
+
+    void Update(double deltaTime) override
+    {
+        const auto dt = static_cast<float>(deltaTime);
+
+        if (emissionRate > 0)
+        {
+            emissionAccumulator += emissionRate * dt;
+
+            const auto count = static_cast<size_t>(emissionAccumulator);
+
+            emissionAccumulator -= static_cast<float>(count);
+
+            Emit(count);
+        }
+
+        if (particleCount > 0 || emissionRate > 0)
+        {
+            SetRenderCacheAsDirty();
+        }
+
+        // Kept free of branches and calls so the compiler can vectorize it.
+
+        const auto damping = std::max(1 - (drag * dt), 0.0F);
+        const auto gravityX = gravity.x * dt;
+        const auto gravityY = gravity.y * dt;
+
+        auto *x = positionX.data();
+        auto *y = positionY.data();
+        auto *vx = velocityX.data();
+        auto *vy = velocityY.data();
+        auto *remaining = life.data();
+
+        for (size_t i = 0; i < particleCount; i += 1)
+        {
+            vx[i] = (vx[i] * damping) + gravityX;
+            vy[i] = (vy[i] * damping) + gravityY;
+
+            x[i] += vx[i] * dt;
+            y[i] += vy[i] * dt;
+
+            remaining[i] -= dt;
+        }
+
+        // Swap dead particles with the last live one, order doesn't matter.
+
+        size_t i = 0;
+
+        while (i < particleCount)
+        {
+            if (remaining[i] > 0)
+            {
+                i += 1;
+
+                continue;
+            }
+
+            particleCount -= 1;
+
+            positionX[i] = positionX[particleCount];
+            positionY[i] = positionY[particleCount];
+            velocityX[i] = velocityX[particleCount];
+            velocityY[i] = velocityY[particleCount];
+            life[i] = life[particleCount];
+            lifetime[i] = lifetime[particleCount];
+            colors[i] = colors[particleCount];
+        }
+    }
+
+    void Render(SDL_Renderer *renderer) override
+    {
+        if (particleCount > 0)
+        {
+            if (quadsAreDirty || quadTexture != texture)
+            {
+                GenerateQuads();
+            }
+
+            UpdateQuads();
+
+            auto &renderBatch = game->GetRenderBatch();
+
+            if (texture != nullptr)
+            {
+                SDL_SetTextureBlendMode(texture, blendMode);
+            }
+            else
+            {
+                renderBatch.SetBlendMode(blendMode);
+            }
+
+            renderBatch.Geometry(texture, vertices.data(),
+                                 static_cast<int>(particleCount * 4),
+                                 indices.data(),
+                                 static_cast<int>(particleCount * 6));
+        }
+
+        RenderObject::Render(renderer);
+    }
+
+    void OnRecycle() override { Clear(); }
+
+  protected:
+    /**
+     * Lay out one quad per particle slot with GenerateTextureQuad, after which
+     * only positions and colors change.
+     */
+    void GenerateQuads()
+    {
+        int width = 1;
+        int height = 1;
+
+        if (texture != nullptr)
+        {
+            SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
+        }
+
+        const auto srcRect =
+            sourceRectSet ? sourceRect
+                          : SDL_FRect{0, 0, static_cast<float>(width),
+                                      static_cast<float>(height)};
+
+        vertices.clear();
+        indices.clear();
+
+        vertices.reserve(maxParticles * 4);
+        indices.reserve(maxParticles * 6);
+
+        for (size_t i = 0; i < maxParticles; i += 1)
+        {
+            GenerateTextureQuad(vertices, indices, SDL_FRect(), srcRect,
+                                DEFAULT_COLOR, static_cast<float>(width),
+                                static_cast<float>(height));
+        }
+
+        quadTexture = texture;
+
+        quadsAreDirty = false;
+    }
+
+    void UpdateQuads()
+    {
+        for (size_t i = 0; i < particleCount; i += 1)
+        {
+            const auto t = lifetime[i] > 0 ? 1 - (life[i] / lifetime[i]) : 1;
+
+            const auto size = Lerp(startSize, endSize, t);
+
+            const auto color =
+                SDL_Color{static_cast<Uint8>(Lerp(colors[i].r, endColor.r, t)),
+                          static_cast<Uint8>(Lerp(colors[i].g, endColor.g, t)),
+                          static_cast<Uint8>(Lerp(colors[i].b, endColor.b, t)),
+                          static_cast<Uint8>(Lerp(colors[i].a, endColor.a, t))};
+
+            auto *quad = vertices.data() + (i * 4);
+
+            UpdateTextureQuad(quad,
+                              SDL_FRect{positionX[i] - (size / 2),
+                                        positionY[i] - (size / 2), size, size});
+
+            quad[0].color = color;
+            quad[1].color = color;
+            quad[2].color = color;
+            quad[3].color = color;
+        }
+    }
+};
+
+} // namespace HandcrankEngine
@@ -0,0 +1,542 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+// #define HANDCRANK_ENGINE_PROFILER 1
+
+#define HANDCRANK_ENGINE_PROFILE_CONCAT_INNER(a, b) a##b
+#define HANDCRANK_ENGINE_PROFILE_CONCAT(a, b)                                  \
+    HANDCRANK_ENGINE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef HANDCRANK_ENGINE_PROFILER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include "FontCache.hpp"
+#include "RenderBatch.hpp"
+#include "TextureCache.hpp"
+
+/**
+ * Time the rest of the enclosing scope under a name. The name has to outlive
+ * the profiler, string literals or names from Profiler::Intern.
+ */
+#define HANDCRANK_ENGINE_PROFILE_SCOPE(name)                                   \
+    HandcrankEngine::ProfileScope HANDCRANK_ENGINE_PROFILE_CONCAT(             \
+        profileScope, __LINE__)(name)
+
+/**
+ * Time the rest of the enclosing scope under the class name of an object,
+ * when object zones are enabled.
+ */
+#define HANDCRANK_ENGINE_PROFILE_OBJECT_SCOPE(object)                          \
+    HandcrankEngine::ProfileScope HANDCRANK_ENGINE_PROFILE_CONCAT(             \
+        profileScope, __LINE__)(                                               \
+        HandcrankEngine::GetProfiler().IsObjectZonesEnabled()                  \
+            ? (object)->GetProfileName()                                       \
+            : nullptr)
+
+#else
+
+#define HANDCRANK_ENGINE_PROFILE_SCOPE(name)
+#define HANDCRANK_ENGINE_PROFILE_OBJECT_SCOPE(object)
+
+#endif
+
+#ifdef HANDCRANK_ENGINE_PROFILER
+
+namespace HandcrankEngine
+{
+
+inline const size_t DEFAULT_PROFILER_CAPACITY = 1 << 16;
+inline const int PROFILER_SUMMARY_DEPTH = 1;
+inline const double PROFILER_SUMMARY_SMOOTHING = 0.1;
+inline const double PROFILER_FRAME_BUDGET = 1 / 60.0;
+
+inline const float PROFILER_OVERLAY_X = 10;
+inline const float PROFILER_OVERLAY_Y = 10;
+inline const float PROFILER_OVERLAY_LABEL_WIDTH = 140;
+inline const float PROFILER_OVERLAY_BAR_WIDTH = 300;
+inline const float PROFILER_OVERLAY_ROW_HEIGHT = 16;
+
+inline const std::array<SDL_Color, 6> PROFILER_OVERLAY_COLORS = {
+    SDL_Color{230, 80, 80, 220},  SDL_Color{80, 200, 120, 220},
+    SDL_Color{80, 140, 230, 220}, SDL_Color{230, 190, 70, 220},
+    SDL_Color{190, 100, 220, 220}, SDL_Color{80, 210, 210, 220}};
+
+struct ProfileEvent
+{
+    const char *name;
+    Uint64 start;
+    Uint64 end;
+    uint32_t threadId;
+    uint32_t depth;
+};
+
+struct ProfileSummary
+{
+    const char *name;
+    uint32_t threadId;
+    uint32_t depth;
+    double lastTime;
+    double averageTime;
+    double frameTime;
+};
+
+/**
+ * Records timed scopes into a fixed-size ring buffer. Writers claim a slot
+ * with a single atomic increment, so recording never locks or allocates and
+ * the oldest events are overwritten once the buffer is full. Reading while
+ * other threads record can see a partly written event, which only affects
+ * that one event. Frame and phase scopes are also added to a summary per
+ * thread, which takes a lock for those few scopes each frame.
+ */
+class Profiler
+{
+  private:
+    std::vector<ProfileEvent> events;
+
+    std::atomic<uint64_t> writeIndex = 0;
+
+    Uint64 startTime = SDL_GetPerformanceCounter();
+
+    std::atomic<bool> isEnabled = true;
+    std::atomic<bool> isObjectZonesEnabled = false;
+
+    mutable std::mutex summaryMutex;
+    std::vector<ProfileSummary> summaries;
+
+    std::mutex internMutex;
+    std::unordered_set<std::string> internedNames;
+
+    std::shared_ptr<TTF_Font> overlayFont;
+    SDL_Renderer *overlayLabelRenderer = nullptr;
+    std::map<const char *, std::shared_ptr<SDL_Texture>> overlayLabels;
+
+  public:
+    explicit Profiler(size_t capacity = DEFAULT_PROFILER_CAPACITY)
+        : events(capacity)
+    {
+    }
+
+    [[nodiscard]] auto IsEnabled() const -> bool { return isEnabled; }
+    void SetEnabled(bool enabled) { isEnabled = enabled; }
+
+    [[nodiscard]] auto IsObjectZonesEnabled() const -> bool
+    {
+        return isEnabled && isObjectZonesEnabled;
+    }
+
+    /**
+     * Also time the Update and Render of every object, named by class.
+     *
+     * @param enabled Whether object zones are recorded.
+     */
+    void SetObjectZonesEnabled(bool enabled) { isObjectZonesEnabled = enabled; }
+
+    /**
+     * Keep a copy of a name for as long as the profiler lives.
+     *
+     * @param name Name to keep.
+     */
+    auto Intern(const std::string &name) -> const char *
+    {
+        std::lock_guard<std::mutex> lock(internMutex);
+
+        return internedNames.insert(name).first->c_str();
+    }
+
+    static auto GetThreadId() -> uint32_t
+    {
+        static std::atomic<uint32_t> nextThreadId = 0;
+
+        thread_local const uint32_t threadId = nextThreadId++;
+
+        return threadId;
+    }
+
+    void Record(const char *name, Uint64 start, Uint64 end, uint32_t depth)
+    {
+        const auto index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+
+        const auto threadId = GetThreadId();
+
+        events[index % events.size()] =
+            ProfileEvent{name, start, end, threadId, depth};
+
+        if (depth <= PROFILER_SUMMARY_DEPTH)
+        {
+            AddToSummary(name, threadId, depth, end - start);
+        }
+    }
+
+    /**
+     * Close the current frame, moving the time of each phase recorded this
+     * frame, on any thread, into its summary. Called by the game at the end of
+     * each frame, after the simulation thread has finished.
+     */
+    void EndFrame()
+    {
+        std::lock_guard<std::mutex> lock(summaryMutex);
+
+        for (auto &summary : summaries)
+        {
+            summary.lastTime = summary.frameTime;
+            summary.averageTime +=
+                (summary.lastTime - summary.averageTime) *
+                PROFILER_SUMMARY_SMOOTHING;
+            summary.frameTime = 0;
+        }
+    }
+
+    /**
+     * Time spent in each frame and phase scope per thread, in recording order,
+     * in seconds.
+     */
+    [[nodiscard]] auto GetSummaries() const -> std::vector<ProfileSummary>
+    {
+        std::lock_guard<std::mutex> lock(summaryMutex);
+
+        return summaries;
+    }
+
+    void Clear()
+    {
+        writeIndex = 0;
+
+        std::lock_guard<std::mutex> lock(summaryMutex);
+
+        summaries.clear();
+    }
+
+    /**
+     * Font used to label the overlay rows. Without one the rows are bars
+     * only, in the order of GetSummaries.
+     *
+     * @param font Font for the labels.
+     */
+    void SetOverlayFont(const std::shared_ptr<TTF_Font> &font)
+    {
+        overlayFont = font;
+
+        overlayLabels.clear();
+    }
+
+    /**
+     * Release the labels drawn with a renderer. Called before the renderer is
+     * destroyed, so a renderer created at the same address later doesn't
+     * draw them.
+     *
+     * @param renderer A structure representing rendering state.
+     */
+    void ReleaseOverlayLabels(SDL_Renderer *renderer)
+    {
+        if (renderer != overlayLabelRenderer)
+        {
+            return;
+        }
+
+        overlayLabels.clear();
+
+        overlayLabelRenderer = nullptr;
+    }
+
+    /**
+     * Release the font and every label. Called by the last game before
+     * SDL_ttf is shut down, as the profiler itself outlives it.
+     */
+    void ReleaseOverlay()
+    {
+        overlayLabels.clear();
+
+        overlayLabelRenderer = nullptr;
+
+        overlayFont = nullptr;
+    }
+
+    /**
+     * Draw one bar per phase, scaled so the full width is a 60 fps frame,
+     * with a marker at the budget.
+     *
+     * @param renderer A structure representing rendering state.
+     * @param renderBatch Batch the bars are queued into.
+     */
+    void RenderOverlay(SDL_Renderer *renderer, RenderBatch &renderBatch)
+    {
+        if (renderer != overlayLabelRenderer)
+        {
+            overlayLabels.clear();
+
+            overlayLabelRenderer = renderer;
+        }
+
+        const auto rows = GetSummaries();
+
+        const auto barX = PROFILER_OVERLAY_X + PROFILER_OVERLAY_LABEL_WIDTH;
+
+        const auto height =
+            PROFILER_OVERLAY_ROW_HEIGHT * static_cast<float>(rows.size());
+
+        renderBatch.FillRect(
+            SDL_FRect{PROFILER_OVERLAY_X - 4, PROFILER_OVERLAY_Y - 4,
+                      PROFILER_OVERLAY_LABEL_WIDTH +
+                          PROFILER_OVERLAY_BAR_WIDTH + 8,
+                      height + 8},
+            SDL_Color{0, 0, 0, 180});
+
+        for (size_t i = 0; i < rows.size(); i += 1)
+        {
+            const auto row = static_cast<float>(i);
+
+            const auto y =
+                PROFILER_OVERLAY_Y + (PROFILER_OVERLAY_ROW_HEIGHT * row);
+
+            const auto width = static_cast<float>(
+                std::min(rows[i].averageTime / PROFILER_FRAME_BUDGET,
+                         1.0) *
+                PROFILER_OVERLAY_BAR_WIDTH);
+
+            renderBatch.FillRect(
+                SDL_FRect{barX, y + 2, std::max(width, 1.0F),
+                          PROFILER_OVERLAY_ROW_HEIGHT - 4},
+                PROFILER_OVERLAY_COLORS[i % PROFILER_OVERLAY_COLORS.size()]);
+        }
+
+        renderBatch.FillRect(SDL_FRect{barX + PROFILER_OVERLAY_BAR_WIDTH - 1,
+                                       PROFILER_OVERLAY_Y, 1, height},
+                             SDL_Color{255, 255, 255, 255});
+
+        if (overlayFont == nullptr)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < rows.size(); i += 1)
+        {
+            auto *label = GetOverlayLabel(renderer, rows[i].name);
+
+            if (label == nullptr)
+            {
+                continue;
+            }
+
+            int width = 0;
+            int height = 0;
+
+            SDL_QueryTexture(label, nullptr, nullptr, &width, &height);
+
+            const auto scale = std::min(
+                (PROFILER_OVERLAY_ROW_HEIGHT - 2) / static_cast<float>(height),
+                1.0F);
+
+            const auto destRect = SDL_FRect{
+                PROFILER_OVERLAY_X +
+                    (static_cast<float>(rows[i].depth) * 8),
+                PROFILER_OVERLAY_Y +
+                    (PROFILER_OVERLAY_ROW_HEIGHT * static_cast<float>(i)) + 1,
+                static_cast<float>(width) * scale,
+                static_cast<float>(height) * scale};
+
+            renderBatch.Copy(label, nullptr, &destRect);
+        }
+    }
+
+    /**
+     * Write the recorded events as Chrome trace JSON, which can be opened in
+     * chrome://tracing or https://ui.perfetto.dev.
+     *
+     * @param path File path to write to.
+     */
+    auto WriteChromeTrace(const char *path) const -> bool
+    {
+        auto *file = std::fopen(path, "w");
+
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        const auto frequency =
+            static_cast<double>(SDL_GetPerformanceFrequency());
+
+        const auto count = std::min<uint64_t>(writeIndex, events.size());
+        const auto first = writeIndex - count;
+
+        std::fprintf(file, "{\"traceEvents\":[");
+
+        auto isFirst = true;
+
+        for (uint64_t i = 0; i < count; i += 1)
+        {
+            const auto &event = events[(first + i) % events.size()];
+
+            if (event.name == nullptr)
+            {
+                continue;
+            }
+
+            const auto start =
+                static_cast<double>(event.start - startTime) / frequency;
+            const auto duration =
+                static_cast<double>(event.end - event.start) / frequency;
+
+            std::fprintf(file, "%s{\"name\":\"", isFirst ? "" : ",");
+
+            isFirst = false;
+
+            for (const auto *c = event.name; *c != '\0'; c += 1)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    std::fputc('\\', file);
+                }
+
+                std::fputc(*c, file);
+            }
+
+            std::fprintf(file,
+                         "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,"
+                         "\"tid\":%u}",
+                         start * 1000000, duration * 1000000, event.threadId);
+        }
+
+        std::fprintf(file, "]}\n");
+
+        std::fclose(file);
+
+        return true;
+    }
+
+  private:
+    void AddToSummary(const char *name, uint32_t threadId, uint32_t depth,
+                      Uint64 ticks)
+    {
+        const auto time = static_cast<double>(ticks) /
+                          static_cast<double>(SDL_GetPerformanceFrequency());
+
+        std::lock_guard<std::mutex> lock(summaryMutex);
+
+        for (auto &summary : summaries)
+        {
+            if (summary.name == name && summary.threadId == threadId)
+            {
+                summary.frameTime += time;
+
+                return;
+            }
+        }
+
+        summaries.emplace_back(
+            ProfileSummary{name, threadId, depth, 0, 0, time});
+    }
+
+    auto GetOverlayLabel(SDL_Renderer *renderer, const char *name)
+        -> SDL_Texture *
+    {
+        auto match = overlayLabels.find(name);
+
+        if (match != overlayLabels.end())
+        {
+            return match->second.get();
+        }
+
+        std::shared_ptr<SDL_Texture> texture;
+
+        SDL_Surface *surface = nullptr;
+
+        {
+            const auto lock = LockFonts();
+
+            surface = TTF_RenderText_Blended(overlayFont.get(), name,
+                                             SDL_Color{255, 255, 255, 255});
+        }
+
+        if (surface != nullptr)
+        {
+            texture = std::shared_ptr<SDL_Texture>(
+                SDL_CreateTextureFromSurface(renderer, surface),
+                TextureDeleter());
+
+            SDL_FreeSurface(surface);
+        }
+
+        overlayLabels.insert_or_assign(name, texture);
+
+        return texture.get();
+    }
+};
+
+/**
+ * The profiler shared by every game in the process.
+ */
+inline auto GetProfiler() -> Profiler &
+{
+    static Profiler profiler;
+
+    return profiler;
+}
+
+/**
+ * Records the time from construction to destruction. Does nothing when the
+ * name is nullptr or the profiler is disabled.
+ */
+class ProfileScope
+{
+  private:
+    inline static thread_local uint32_t depth = 0;
+
+    const char *name;
+
+    Uint64 start = 0;
+
+  public:
+    explicit ProfileScope(const char *name)
+        : name(GetProfiler().IsEnabled() ? name : nullptr)
+    {
+        if (this->name != nullptr)
+        {
+            start = SDL_GetPerformanceCounter();
+
+            depth += 1;
+        }
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    auto operator=(const ProfileScope &) -> ProfileScope & = delete;
+
+    ~ProfileScope()
+    {
+        if (name == nullptr)
+        {
+            return;
+        }
+
+        depth -= 1;
+
+        GetProfiler().Record(name, start, SDL_GetPerformanceCounter(), depth);
+    }
+};
+
+} // namespace HandcrankEngine
+
+#endif
@@ -32,6 +32,19 @@ class RectRenderObject : public RenderObject
   public:
     using RenderObject::RenderObject;
 
+    void OnRecycle() override
+    {
+        RenderObject::OnRecycle();
+
+        borderColor = SDL_Color();
+        borderColorSet = false;
+
+        fillColor = SDL_Color();
+        fillColorSet = false;
+
+        blendMode = SDL_BLENDMODE_BLEND;
+    }
+
     /**
      * Set rect border color.
      *
@@ -42,6 +55,10 @@ class RectRenderObject : public RenderObject
         this->borderColor = borderColor;
 
         borderColorSet = true;
+
+        SetRenderCacheAsDirty();
+
+        SetRenderCacheAsDirty();
     }
 
     void SetBorderColor(const Uint8 r, const Uint8 g, const Uint8 b,
@@ -53,6 +70,10 @@ class RectRenderObject : public RenderObject
         borderColor.a = a;
 
         borderColorSet = true;
+
+        SetRenderCacheAsDirty();
+
+        SetRenderCacheAsDirty();
     }
 
     [[nodiscard]] auto GetBorderColor() const -> const SDL_Color &
@@ -70,6 +91,10 @@ class RectRenderObject : public RenderObject
         this->fillColor = fillColor;
 
         fillColorSet = true;
+
+        SetRenderCacheAsDirty();
+
+        SetRenderCacheAsDirty();
     }
 
     void SetFillColor(const Uint8 r, const Uint8 g, const Uint8 b,
@@ -81,6 +106,10 @@ class RectRenderObject : public RenderObject
         fillColor.a = a;
 
         fillColorSet = true;
+
+        SetRenderCacheAsDirty();
+
+        SetRenderCacheAsDirty();
     }
 
     [[nodiscard]] auto GetFillColor() const -> const SDL_Color &
@@ -100,24 +129,20 @@ class RectRenderObject : public RenderObject
             return;
         }
 
-        SDL_SetRenderDrawBlendMode(renderer, blendMode);
+        auto &renderBatch = game->GetRenderBatch();
+
+        renderBatch.SetBlendMode(blendMode);
 
-        auto transformedRect = GetTransformedRect();
+        auto transformedRect = GetInterpolatedTransformedRect();
 
         if (fillColorSet)
         {
-            SDL_SetRenderDrawColor(renderer, fillColor.r, fillColor.g,
-                                   fillColor.b, fillColor.a);
-
-            SDL_RenderFillRectF(renderer, &transformedRect);
+            renderBatch.FillRect(transformedRect, fillColor);
         }
 
         if (borderColorSet)
         {
-            SDL_SetRenderDrawColor(renderer, borderColor.r, borderColor.g,
-                                   borderColor.b, borderColor.a);
-
-            SDL_RenderDrawRectF(renderer, &transformedRect);
+            renderBatch.DrawRect(transformedRect, borderColor);
         }
 
         RenderObject::Render(renderer);
@@ -0,0 +1,518 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "RenderCommandBuffer.hpp"
+#include "Utilities.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const int DEFAULT_RENDER_BATCH_QUAD_CAPACITY = 256;
+
+/**
+ * Collects solid rects, outlines, lines and textured quads drawn during a
+ * frame and sends them to the renderer in as few calls as possible. Quads
+ * batch until the texture changes, so sprites from one atlas page drawn one
+ * after another cost a single call. Other textures and geometry go through
+ * Copy and Geometry, which flush the batch first so the draw order is kept.
+ * With a command buffer set, nothing is sent to the renderer and every call
+ * is recorded into the buffer instead.
+ */
+class RenderBatch
+{
+  private:
+    SDL_Renderer *renderer = nullptr;
+
+    RenderCommandBuffer *commandBuffer = nullptr;
+
+    SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+
+    struct RenderTarget
+    {
+        SDL_Texture *texture;
+        SDL_Rect viewport;
+    };
+
+    std::vector<RenderTarget> targets;
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    std::vector<SDL_FRect> rects;
+
+    SDL_Texture *batchTexture = nullptr;
+
+    SDL_Color rectsColor = SDL_Color();
+
+    bool canFillRects = true;
+
+    int drawCalls = 0;
+
+  public:
+    RenderBatch()
+    {
+        vertices.reserve(DEFAULT_RENDER_BATCH_QUAD_CAPACITY * 4);
+        indices.reserve(DEFAULT_RENDER_BATCH_QUAD_CAPACITY * 6);
+        rects.reserve(DEFAULT_RENDER_BATCH_QUAD_CAPACITY);
+    }
+
+    void SetRenderer(SDL_Renderer *renderer)
+    {
+        Clear();
+
+        this->renderer = renderer;
+    }
+
+    /**
+     * Record into a command buffer instead of drawing, or draw again when set
+     * to nullptr. Anything queued is flushed to the previous target first.
+     *
+     * @param commandBuffer Buffer to record into.
+     */
+    void SetCommandBuffer(RenderCommandBuffer *commandBuffer)
+    {
+        Flush();
+
+        this->commandBuffer = commandBuffer;
+    }
+
+    [[nodiscard]] auto GetCommandBuffer() const -> RenderCommandBuffer *
+    {
+        return commandBuffer;
+    }
+
+    [[nodiscard]] auto GetBlendMode() const -> SDL_BlendMode
+    {
+        return blendMode;
+    }
+
+    /**
+     * Set the blend mode of the primitives that follow. Changing it flushes
+     * anything already queued with the previous mode.
+     *
+     * @param blendMode Blend mode used when drawing.
+     */
+    void SetBlendMode(SDL_BlendMode blendMode)
+    {
+        if (this->blendMode == blendMode)
+        {
+            return;
+        }
+
+        Flush();
+
+        this->blendMode = blendMode;
+    }
+
+    [[nodiscard]] auto IsEmpty() const -> bool { return rects.empty(); }
+
+    /**
+     * Number of draw calls made by flushes since the last reset.
+     */
+    [[nodiscard]] auto GetDrawCalls() const -> int { return drawCalls; }
+
+    void ResetDrawCalls() { drawCalls = 0; }
+
+    /**
+     * Queue a filled rect.
+     *
+     * @param rect Rect to fill.
+     * @param color Fill color.
+     */
+    void FillRect(const SDL_FRect &rect, const SDL_Color &color)
+    {
+        const auto x2 = rect.x + rect.w;
+        const auto y2 = rect.y + rect.h;
+
+        AddQuad(SDL_FPoint{rect.x, rect.y}, SDL_FPoint{x2, rect.y},
+                SDL_FPoint{x2, y2}, SDL_FPoint{rect.x, y2}, color, rect);
+    }
+
+    /**
+     * Queue a one pixel outline along the inside edge of a rect, matching
+     * SDL_RenderDrawRectF.
+     *
+     * @param rect Rect to outline.
+     * @param color Outline color.
+     */
+    void DrawRect(const SDL_FRect &rect, const SDL_Color &color)
+    {
+        if (rect.w <= 2 || rect.h <= 2)
+        {
+            FillRect(rect, color);
+
+            return;
+        }
+
+        FillRect(SDL_FRect{rect.x, rect.y, rect.w, 1}, color);
+        FillRect(SDL_FRect{rect.x, rect.y + rect.h - 1, rect.w, 1}, color);
+        FillRect(SDL_FRect{rect.x, rect.y + 1, 1, rect.h - 2}, color);
+        FillRect(SDL_FRect{rect.x + rect.w - 1, rect.y + 1, 1, rect.h - 2},
+                 color);
+    }
+
+    /**
+     * Queue a line as a quad.
+     *
+     * @param x1 Start x position.
+     * @param y1 Start y position.
+     * @param x2 End x position.
+     * @param y2 End y position.
+     * @param color Line color.
+     * @param thickness Line thickness.
+     */
+    void DrawLine(float x1, float y1, float x2, float y2,
+                  const SDL_Color &color, float thickness = 1)
+    {
+        const auto dx = x2 - x1;
+        const auto dy = y2 - y1;
+
+        const auto length = std::sqrt((dx * dx) + (dy * dy));
+
+        if (length == 0)
+        {
+            return;
+        }
+
+        const auto halfThickness = thickness / 2;
+
+        const auto nx = -dy / length * halfThickness;
+        const auto ny = dx / length * halfThickness;
+
+        if (dx == 0 || dy == 0)
+        {
+            const auto left = std::min(x1, x2) - std::abs(nx);
+            const auto top = std::min(y1, y2) - std::abs(ny);
+
+            FillRect(SDL_FRect{left, top, std::abs(dx) + (std::abs(nx) * 2),
+                               std::abs(dy) + (std::abs(ny) * 2)},
+                     color);
+
+            return;
+        }
+
+        canFillRects = false;
+
+        AddQuad(SDL_FPoint{x1 + nx, y1 + ny}, SDL_FPoint{x2 + nx, y2 + ny},
+                SDL_FPoint{x2 - nx, y2 - ny}, SDL_FPoint{x1 - nx, y1 - ny},
+                color, SDL_FRect());
+    }
+
+    /**
+     * Queue a textured quad. The texture's color and alpha mod are not
+     * applied, tint with the color instead.
+     *
+     * @param texture Texture to draw from.
+     * @param textureWidth Width of the texture in pixels.
+     * @param textureHeight Height of the texture in pixels.
+     * @param srcRect Part of the texture to draw.
+     * @param destRect Where to draw it.
+     * @param color Tint and alpha of the quad.
+     * @param flip Whether to flip the quad.
+     */
+    void CopyQuad(SDL_Texture *texture, float textureWidth,
+                  float textureHeight, const SDL_FRect &srcRect,
+                  const SDL_FRect &destRect, const SDL_Color &color,
+                  SDL_RendererFlip flip = SDL_FLIP_NONE)
+    {
+        if (texture == nullptr || textureWidth <= 0 || textureHeight <= 0)
+        {
+            return;
+        }
+
+        if (texture != batchTexture)
+        {
+            Flush();
+
+            batchTexture = texture;
+        }
+
+        const auto start = vertices.size();
+
+        GenerateTextureQuad(vertices, indices, destRect, srcRect, color,
+                            textureWidth, textureHeight);
+
+        auto *quad = vertices.data() + start;
+
+        if ((flip & SDL_FLIP_HORIZONTAL) != 0)
+        {
+            std::swap(quad[0].tex_coord, quad[1].tex_coord);
+            std::swap(quad[2].tex_coord, quad[3].tex_coord);
+        }
+
+        if ((flip & SDL_FLIP_VERTICAL) != 0)
+        {
+            std::swap(quad[0].tex_coord, quad[3].tex_coord);
+            std::swap(quad[1].tex_coord, quad[2].tex_coord);
+        }
+
+        rects.emplace_back(destRect);
+
+        canFillRects = false;
+    }
+
+    /**
+     * Fill the whole render target.
+     *
+     * @param color Clear color.
+     */
+    void ClearScreen(const SDL_Color &color)
+    {
+        Clear();
+
+        if (commandBuffer != nullptr)
+        {
+            commandBuffer->ClearScreen(color);
+        }
+        else if (renderer != nullptr)
+        {
+            SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b,
+                                   color.a);
+
+            SDL_RenderClear(renderer);
+        }
+    }
+
+    /**
+     * Draw into a texture until the matching PopTarget. Targets nest, popping
+     * one goes back to the texture and viewport of the one below it.
+     *
+     * @param texture Texture created with SDL_TEXTUREACCESS_TARGET.
+     * @param viewport Viewport within the texture, which can be offset to
+     * move what is drawn into it.
+     */
+    void PushTarget(SDL_Texture *texture, const SDL_Rect &viewport)
+    {
+        Flush();
+
+        targets.emplace_back(RenderTarget{texture, viewport});
+
+        ApplyTarget(texture, &viewport);
+    }
+
+    void PopTarget()
+    {
+        if (targets.empty())
+        {
+            return;
+        }
+
+        Flush();
+
+        targets.pop_back();
+
+        if (targets.empty())
+        {
+            // Going back to the window restores its own viewport.
+
+            ApplyTarget(nullptr, nullptr);
+        }
+        else
+        {
+            ApplyTarget(targets.back().texture, &targets.back().viewport);
+        }
+    }
+
+    /**
+     * Draw a texture, after anything queued so far.
+     *
+     * @param texture Texture to draw.
+     * @param srcRect Part of the texture to draw, or nullptr for all of it.
+     * @param destRect Where to draw it, or nullptr for the whole target.
+     * @param angle Rotation in degrees, clockwise.
+     * @param center Point to rotate around, or nullptr for the center.
+     * @param flip Whether to flip the texture.
+     */
+    void Copy(SDL_Texture *texture, const SDL_Rect *srcRect,
+              const SDL_FRect *destRect, double angle = 0,
+              const SDL_FPoint *center = nullptr,
+              SDL_RendererFlip flip = SDL_FLIP_NONE)
+    {
+        Flush();
+
+        if (commandBuffer != nullptr)
+        {
+            commandBuffer->Copy(texture, srcRect, destRect, angle, center,
+                                flip);
+        }
+        else if (renderer != nullptr)
+        {
+            SDL_RenderCopyExF(renderer, texture, srcRect, destRect, angle,
+                              center, flip);
+        }
+
+        drawCalls += 1;
+    }
+
+    /**
+     * Draw triangles, after anything queued so far. Untextured geometry uses
+     * the blend mode of the batch.
+     *
+     * @param texture Texture to map, or nullptr.
+     * @param vertices Vertices to draw.
+     * @param vertexCount Number of vertices.
+     * @param indices Triangle indices, or nullptr.
+     * @param indexCount Number of indices.
+     */
+    void Geometry(SDL_Texture *texture, const SDL_Vertex *vertices,
+                  int vertexCount, const int *indices, int indexCount)
+    {
+        Flush();
+
+        if (commandBuffer != nullptr)
+        {
+            commandBuffer->Geometry(texture, blendMode, vertices, vertexCount,
+                                    indices, indexCount);
+        }
+        else if (renderer != nullptr)
+        {
+            if (texture == nullptr)
+            {
+                SDL_SetRenderDrawBlendMode(renderer, blendMode);
+            }
+
+            SDL_RenderGeometry(renderer, texture, vertices, vertexCount,
+                               indices, indexCount);
+        }
+
+        drawCalls += 1;
+    }
+
+    /**
+     * Draw everything queued so far. Primitives that are all rects of the
+     * same color go through SDL_RenderFillRectsF, anything else through a
+     * single SDL_RenderGeometry call.
+     */
+    void Flush()
+    {
+        if (rects.empty())
+        {
+            return;
+        }
+
+        if (commandBuffer != nullptr)
+        {
+            if (canFillRects)
+            {
+                commandBuffer->FillRects(blendMode, rectsColor, rects.data(),
+                                         static_cast<int>(rects.size()));
+            }
+            else
+            {
+                commandBuffer->Geometry(batchTexture, blendMode,
+                                        vertices.data(),
+                                        static_cast<int>(vertices.size()),
+                                        indices.data(),
+                                        static_cast<int>(indices.size()));
+            }
+
+            drawCalls += 1;
+        }
+        else if (renderer != nullptr)
+        {
+            SDL_SetRenderDrawBlendMode(renderer, blendMode);
+
+            if (canFillRects)
+            {
+                SDL_SetRenderDrawColor(renderer, rectsColor.r, rectsColor.g,
+                                       rectsColor.b, rectsColor.a);
+
+                SDL_RenderFillRectsF(renderer, rects.data(),
+                                     static_cast<int>(rects.size()));
+            }
+            else
+            {
+                SDL_RenderGeometry(renderer, batchTexture, vertices.data(),
+                                   static_cast<int>(vertices.size()),
+                                   indices.data(),
+                                   static_cast<int>(indices.size()));
+            }
+
+            drawCalls += 1;
+        }
+
+        Clear();
+    }
+
+    void Clear()
+    {
+        vertices.clear();
+        indices.clear();
+        rects.clear();
+
+        batchTexture = nullptr;
+
+        canFillRects = true;
+    }
+
+  private:
+    void ApplyTarget(SDL_Texture *texture, const SDL_Rect *viewport)
+    {
+        if (commandBuffer != nullptr)
+        {
+            commandBuffer->SetTarget(texture, viewport);
+        }
+        else if (renderer != nullptr)
+        {
+            SDL_SetRenderTarget(renderer, texture);
+
+            if (viewport != nullptr)
+            {
+                SDL_RenderSetViewport(renderer, viewport);
+            }
+        }
+    }
+
+    void AddQuad(const SDL_FPoint &a, const SDL_FPoint &b, const SDL_FPoint &c,
+                 const SDL_FPoint &d, const SDL_Color &color,
+                 const SDL_FRect &rect)
+    {
+        if (batchTexture != nullptr)
+        {
+            Flush();
+        }
+
+        if (rects.empty())
+        {
+            rectsColor = color;
+        }
+        else if (color.r != rectsColor.r || color.g != rectsColor.g ||
+                 color.b != rectsColor.b || color.a != rectsColor.a)
+        {
+            canFillRects = false;
+        }
+
+        const auto start = static_cast<int>(vertices.size());
+
+        vertices.emplace_back(SDL_Vertex{a, color, SDL_FPoint{0, 0}});
+        vertices.emplace_back(SDL_Vertex{b, color, SDL_FPoint{0, 0}});
+        vertices.emplace_back(SDL_Vertex{c, color, SDL_FPoint{0, 0}});
+        vertices.emplace_back(SDL_Vertex{d, color, SDL_FPoint{0, 0}});
+
+        indices.emplace_back(start);
+        indices.emplace_back(start + 1);
+        indices.emplace_back(start + 2);
+        indices.emplace_back(start);
+        indices.emplace_back(start + 2);
+        indices.emplace_back(start + 3);
+
+        rects.emplace_back(rect);
+    }
+};
+
+} // namespace HandcrankEngine
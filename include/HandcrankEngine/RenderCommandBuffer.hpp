@@ -0,0 +1,319 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDL.h>
+
+namespace HandcrankEngine
+{
+
+enum class RenderCommandType : uint8_t
+{
+    CLEAR,
+    FILL_RECTS,
+    GEOMETRY,
+    COPY,
+    TARGET
+};
+
+struct RenderCommand
+{
+    RenderCommandType type;
+
+    SDL_Texture *texture;
+
+    SDL_BlendMode blendMode;
+
+    /** Draw color, or the color and alpha mod of the texture. */
+    SDL_Color color;
+
+    int first;
+    int count;
+
+    int firstIndex;
+    int indexCount;
+
+    SDL_Rect srcRect;
+    bool hasSrcRect;
+
+    SDL_FRect destRect;
+    bool hasDestRect;
+
+    double angle;
+
+    SDL_FPoint center;
+    bool hasCenter;
+
+    SDL_RendererFlip flip;
+
+    SDL_Rect viewport;
+    bool hasViewport;
+};
+
+/**
+ * A frame of draw calls recorded instead of sent to the renderer, so it can
+ * be replayed later while the scene graph is busy with the next frame.
+ * Everything a call reads is copied in, apart from textures, which have to
+ * stay alive until the buffer is replayed. Texture color, alpha and blend
+ * modes are captured when recording.
+ */
+class RenderCommandBuffer
+{
+  private:
+    std::vector<RenderCommand> commands;
+
+    std::vector<SDL_FRect> rects;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    [[nodiscard]] static auto MakeCommand(RenderCommandType type)
+        -> RenderCommand
+    {
+        return RenderCommand{type,
+                             nullptr,
+                             SDL_BLENDMODE_NONE,
+                             SDL_Color(),
+                             0,
+                             0,
+                             0,
+                             0,
+                             SDL_Rect(),
+                             false,
+                             SDL_FRect(),
+                             false,
+                             0,
+                             SDL_FPoint(),
+                             false,
+                             SDL_FLIP_NONE,
+                             SDL_Rect(),
+                             false};
+    }
+
+  public:
+    [[nodiscard]] auto IsEmpty() const -> bool { return commands.empty(); }
+
+    [[nodiscard]] auto GetCommandCount() const -> size_t
+    {
+        return commands.size();
+    }
+
+    void ClearScreen(const SDL_Color &color)
+    {
+        auto command = MakeCommand(RenderCommandType::CLEAR);
+
+        command.color = color;
+
+        commands.emplace_back(command);
+    }
+
+    void FillRects(SDL_BlendMode blendMode, const SDL_Color &color,
+                   const SDL_FRect *rects, int count)
+    {
+        auto command = MakeCommand(RenderCommandType::FILL_RECTS);
+
+        command.blendMode = blendMode;
+        command.color = color;
+        command.first = static_cast<int>(this->rects.size());
+        command.count = count;
+
+        this->rects.insert(this->rects.end(), rects, rects + count);
+
+        commands.emplace_back(command);
+    }
+
+    /**
+     * Record an SDL_RenderGeometry call. Untextured geometry is drawn with
+     * the given blend mode, textured geometry with the texture's.
+     */
+    void Geometry(SDL_Texture *texture, SDL_BlendMode blendMode,
+                  const SDL_Vertex *vertices, int vertexCount,
+                  const int *indices, int indexCount)
+    {
+        auto command = MakeCommand(RenderCommandType::GEOMETRY);
+
+        command.texture = texture;
+        command.blendMode = blendMode;
+
+        if (texture != nullptr)
+        {
+            SDL_GetTextureBlendMode(texture, &command.blendMode);
+        }
+
+        command.first = static_cast<int>(this->vertices.size());
+        command.count = vertexCount;
+        command.firstIndex = static_cast<int>(this->indices.size());
+        command.indexCount = indexCount;
+
+        this->vertices.insert(this->vertices.end(), vertices,
+                              vertices + vertexCount);
+
+        if (indices != nullptr)
+        {
+            this->indices.insert(this->indices.end(), indices,
+                                 indices + indexCount);
+        }
+        else
+        {
+            command.indexCount = 0;
+        }
+
+        commands.emplace_back(command);
+    }
+
+    void Copy(SDL_Texture *texture, const SDL_Rect *srcRect,
+              const SDL_FRect *destRect, double angle,
+              const SDL_FPoint *center, SDL_RendererFlip flip)
+    {
+        if (texture == nullptr)
+        {
+            return;
+        }
+
+        auto command = MakeCommand(RenderCommandType::COPY);
+
+        command.texture = texture;
+
+        SDL_GetTextureBlendMode(texture, &command.blendMode);
+        SDL_GetTextureColorMod(texture, &command.color.r, &command.color.g,
+                               &command.color.b);
+        SDL_GetTextureAlphaMod(texture, &command.color.a);
+
+        if (srcRect != nullptr)
+        {
+            command.srcRect = *srcRect;
+            command.hasSrcRect = true;
+        }
+
+        if (destRect != nullptr)
+        {
+            command.destRect = *destRect;
+            command.hasDestRect = true;
+        }
+
+        command.angle = angle;
+
+        if (center != nullptr)
+        {
+            command.center = *center;
+            command.hasCenter = true;
+        }
+
+        command.flip = flip;
+
+        commands.emplace_back(command);
+    }
+
+    /**
+     * Record an SDL_SetRenderTarget call, followed by a viewport change when
+     * one is given.
+     */
+    void SetTarget(SDL_Texture *texture, const SDL_Rect *viewport)
+    {
+        auto command = MakeCommand(RenderCommandType::TARGET);
+
+        command.texture = texture;
+
+        if (viewport != nullptr)
+        {
+            command.viewport = *viewport;
+            command.hasViewport = true;
+        }
+
+        commands.emplace_back(command);
+    }
+
+    /**
+     * Send every recorded call to a renderer, in order.
+     *
+     * @param renderer A structure representing rendering state.
+     */
+    void Replay(SDL_Renderer *renderer) const
+    {
+        for (const auto &command : commands)
+        {
+            switch (command.type)
+            {
+            case RenderCommandType::CLEAR:
+                SDL_SetRenderDrawColor(renderer, command.color.r,
+                                       command.color.g, command.color.b,
+                                       command.color.a);
+                SDL_RenderClear(renderer);
+                break;
+            case RenderCommandType::FILL_RECTS:
+                SDL_SetRenderDrawBlendMode(renderer, command.blendMode);
+                SDL_SetRenderDrawColor(renderer, command.color.r,
+                                       command.color.g, command.color.b,
+                                       command.color.a);
+                SDL_RenderFillRectsF(renderer, rects.data() + command.first,
+                                     command.count);
+                break;
+            case RenderCommandType::GEOMETRY:
+                if (command.texture != nullptr)
+                {
+                    SDL_SetTextureBlendMode(command.texture, command.blendMode);
+                }
+                else
+                {
+                    SDL_SetRenderDrawBlendMode(renderer, command.blendMode);
+                }
+
+                SDL_RenderGeometry(renderer, command.texture,
+                                   vertices.data() + command.first,
+                                   command.count,
+                                   command.indexCount > 0
+                                       ? indices.data() + command.firstIndex
+                                       : nullptr,
+                                   command.indexCount);
+                break;
+            case RenderCommandType::COPY:
+                SDL_SetTextureBlendMode(command.texture, command.blendMode);
+                SDL_SetTextureColorMod(command.texture, command.color.r,
+                                       command.color.g, command.color.b);
+                SDL_SetTextureAlphaMod(command.texture, command.color.a);
+
+                SDL_RenderCopyExF(renderer, command.texture,
+                                  command.hasSrcRect ? &command.srcRect
+                                                     : nullptr,
+                                  command.hasDestRect ? &command.destRect
+                                                      : nullptr,
+                                  command.angle,
+                                  command.hasCenter ? &command.center
+                                                    : nullptr,
+                                  command.flip);
+                break;
+            case RenderCommandType::TARGET:
+                SDL_SetRenderTarget(renderer, command.texture);
+
+                if (command.hasViewport)
+                {
+                    SDL_RenderSetViewport(renderer, &command.viewport);
+                }
+                break;
+            }
+        }
+    }
+
+    /**
+     * Drop the recorded calls, keeping the capacity for the next frame.
+     */
+    void Clear()
+    {
+        commands.clear();
+
+        rects.clear();
+        vertices.clear();
+        indices.clear();
+    }
+};
+
+} // namespace HandcrankEngine
@@ -0,0 +1,397 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "Utilities.hpp"
+
+namespace HandcrankEngine
+{
+
+struct ResourceCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+/**
+ * Cache key for a resource loaded from a path.
+ *
+ * @param path File path to the resource.
+ */
+[[nodiscard]] inline auto ResourcePathKey(const char *path) -> std::string
+{
+    return std::string("path:") + path;
+}
+
+/**
+ * Cache key for a resource loaded from an asset pack.
+ *
+ * @param pack File path or URL of the pack.
+ * @param name Name of the resource in the pack.
+ */
+[[nodiscard]] inline auto ResourcePackKey(const std::string &pack,
+                                          const std::string &name)
+    -> std::string
+{
+    return "pack:" + pack + ":" + name;
+}
+
+/**
+ * Cache key for a resource loaded from a read-only buffer. Combines the
+ * address, size and a hash of the contents, so two different buffers only
+ * share an entry when all three match.
+ *
+ * @param mem A pointer to a read-only buffer.
+ * @param size The buffer size, in bytes.
+ */
+[[nodiscard]] inline auto ResourceMemKey(const void *mem, size_t size)
+    -> std::string
+{
+    return "mem:" + std::to_string(reinterpret_cast<uintptr_t>(mem)) + ":" +
+           std::to_string(size) + ":" + std::to_string(MemHash(mem, size));
+}
+
+/**
+ * Size of a file on disk, used as the byte size of resources whose memory use
+ * can't be queried.
+ *
+ * @param path File path to the resource.
+ */
+[[nodiscard]] inline auto GetFileBytes(const char *path) -> size_t
+{
+    auto *rw = SDL_RWFromFile(path, "rb");
+
+    if (rw == nullptr)
+    {
+        return 0;
+    }
+
+    const auto size = SDL_RWsize(rw);
+
+    SDL_RWclose(rw);
+
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+/**
+ * Keyed cache of shared resources with byte accounting. When a budget is set,
+ * the least recently used entries that nothing outside the cache references
+ * anymore are evicted until the cache fits. Entries still in use are never
+ * evicted, so the cache can go over budget while they are alive.
+ *
+ * Safe to use from several threads. Resources the cache lets go of are freed
+ * after its lock is released, so their deleters can use other caches.
+ */
+template <typename T>
+class ResourceCache
+{
+  private:
+    struct Entry
+    {
+        std::shared_ptr<T> resource;
+        size_t bytes;
+        std::list<std::string>::iterator usage;
+    };
+
+    using Released = std::vector<std::shared_ptr<T>>;
+
+    mutable std::mutex mutex;
+
+    std::unordered_map<std::string, Entry> entries;
+
+    std::list<std::string> usage;
+
+    size_t usedBytes = 0;
+    size_t budget = 0;
+
+    ResourceCacheStats stats;
+
+    std::function<void(const std::shared_ptr<T> &)> onEvict;
+
+    auto RemoveEntry(typename std::unordered_map<std::string, Entry>::iterator
+                         match,
+                     Released &released) ->
+        typename std::unordered_map<std::string, Entry>::iterator
+    {
+        usedBytes -= match->second.bytes;
+
+        usage.erase(match->second.usage);
+
+        released.emplace_back(std::move(match->second.resource));
+
+        return entries.erase(match);
+    }
+
+    void TrimEntries(Released &evicted)
+    {
+        if (budget == 0 || usedBytes <= budget)
+        {
+            return;
+        }
+
+        auto iter = usage.end();
+
+        while (iter != usage.begin() && usedBytes > budget)
+        {
+            iter = std::prev(iter);
+
+            auto match = entries.find(*iter);
+
+            if (match->second.resource.use_count() > 1)
+            {
+                continue;
+            }
+
+            usedBytes -= match->second.bytes;
+
+            evicted.emplace_back(std::move(match->second.resource));
+
+            entries.erase(match);
+
+            iter = usage.erase(iter);
+
+            stats.evictions += 1;
+        }
+    }
+
+    void NotifyEvicted(const Released &evicted) const
+    {
+        if (!onEvict)
+        {
+            return;
+        }
+
+        for (const auto &resource : evicted)
+        {
+            onEvict(resource);
+        }
+    }
+
+  public:
+    /**
+     * Find a resource and mark it as recently used.
+     *
+     * @param key Full key of the resource including its load parameters.
+     */
+    [[nodiscard]] auto Find(const std::string &key) -> std::shared_ptr<T>
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto match = entries.find(key);
+
+        if (match == entries.end())
+        {
+            stats.misses += 1;
+
+            return nullptr;
+        }
+
+        stats.hits += 1;
+
+        usage.splice(usage.begin(), usage, match->second.usage);
+
+        return match->second.resource;
+    }
+
+    /**
+     * Whether a resource is cached, without counting a hit or a miss or
+     * marking it as used.
+     *
+     * @param key Full key of the resource including its load parameters.
+     */
+    [[nodiscard]] auto Contains(const std::string &key) const -> bool
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return entries.find(key) != entries.end();
+    }
+
+    /**
+     * Add a resource, replacing any entry with the same key, then evict
+     * unused entries if the cache is over budget.
+     *
+     * @param key Full key of the resource including its load parameters.
+     * @param resource Resource to cache.
+     * @param bytes Approximate memory used by the resource.
+     */
+    void Insert(const std::string &key, const std::shared_ptr<T> &resource,
+                size_t bytes)
+    {
+        Released released;
+        Released evicted;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto match = entries.find(key);
+
+            if (match != entries.end())
+            {
+                RemoveEntry(match, released);
+            }
+
+            usage.emplace_front(key);
+
+            entries.emplace(key, Entry{resource, bytes, usage.begin()});
+
+            usedBytes += bytes;
+
+            TrimEntries(evicted);
+        }
+
+        NotifyEvicted(evicted);
+    }
+
+    /**
+     * Remove an entry. Anything still holding the resource keeps it alive.
+     *
+     * @param key Full key of the resource.
+     */
+    void Erase(const std::string &key)
+    {
+        Released released;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto match = entries.find(key);
+
+        if (match != entries.end())
+        {
+            RemoveEntry(match, released);
+        }
+    }
+
+    /**
+     * Remove every entry whose key matches. Anything still holding the
+     * resources keeps them alive.
+     *
+     * @param predicate Function returning true for keys to remove.
+     */
+    void EraseIf(const std::function<bool(const std::string &)> &predicate)
+    {
+        Released released;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto iter = entries.begin(); iter != entries.end();)
+        {
+            iter = predicate(iter->first) ? RemoveEntry(iter, released)
+                                          : std::next(iter);
+        }
+    }
+
+    /**
+     * Evict the least recently used entries nothing else references until the
+     * cache fits in its budget.
+     */
+    void Trim()
+    {
+        Released evicted;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            TrimEntries(evicted);
+        }
+
+        NotifyEvicted(evicted);
+    }
+
+    void Clear()
+    {
+        std::unordered_map<std::string, Entry> released;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::swap(entries, released);
+
+        usage.clear();
+
+        usedBytes = 0;
+    }
+
+    /**
+     * Limit the memory used by the cache. A budget of 0 disables eviction.
+     *
+     * @param budget Budget in bytes.
+     */
+    void SetBudget(size_t budget)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            this->budget = budget;
+        }
+
+        Trim();
+    }
+
+    [[nodiscard]] auto GetBudget() const -> size_t
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return budget;
+    }
+
+    [[nodiscard]] auto GetUsedBytes() const -> size_t
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return usedBytes;
+    }
+
+    [[nodiscard]] auto GetCount() const -> size_t
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return entries.size();
+    }
+
+    [[nodiscard]] auto GetStats() const -> ResourceCacheStats
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return stats;
+    }
+
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        stats = ResourceCacheStats();
+    }
+
+    /**
+     * Called with each resource evicted by the budget, before the resource is
+     * freed. Set it before the cache is shared between threads.
+     *
+     * @param onEvict Callback function.
+     */
+    void SetOnEvict(std::function<void(const std::shared_ptr<T> &)> onEvict)
+    {
+        this->onEvict = std::move(onEvict);
+    }
+};
+
+} // namespace HandcrankEngine
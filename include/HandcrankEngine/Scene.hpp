@@ -9,18 +9,42 @@
 
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <typeindex>
+#include <vector>
 
 #include "HandcrankEngine.hpp"
 
 namespace HandcrankEngine
 {
 
+/**
+ * Where a scene is in its lifecycle. Only an ACTIVE scene is updated and
+ * rendered, a WARM scene keeps its subtree and assets so showing it again
+ * takes a single frame.
+ */
+enum class SceneState : uint8_t
+{
+    UNLOADED,
+    PRELOADING,
+    WARM,
+    ACTIVE
+};
+
 class Scene : public RenderObject
 {
   private:
     std::function<void(std::type_index)> SetCurrentScene;
 
+    SceneState state = SceneState::UNLOADED;
+
+    std::vector<std::weak_ptr<RenderObject>> suspendedColliders;
+
+  protected:
+    AssetManifest assetManifest;
+
   public:
     using RenderObject::RenderObject;
 
@@ -30,6 +54,101 @@ class Scene : public RenderObject
         SetCurrentScene = callback;
     }
 
+    /**
+     * Assets loaded in the background before the scene is shown. Add to it
+     * in the constructor, before the scene is switched to.
+     */
+    [[nodiscard]] auto GetAssetManifest() -> AssetManifest &
+    {
+        return assetManifest;
+    }
+
+    [[nodiscard]] auto GetState() const -> SceneState { return state; }
+
+    /**
+     * Set by SceneManager as the scene is preloaded, shown, kept warm and
+     * unloaded.
+     *
+     * @param state State to set.
+     */
+    void SetState(SceneState state) { this->state = state; }
+
+    /**
+     * Build the scene's subtree now instead of on the first frame it's
+     * shown, starting the scene and every object in it that hasn't started.
+     * Call it while the scene is disabled, nothing is updated.
+     */
+    void Warm()
+    {
+        StartTree();
+
+        PopulateChildrenBuffer();
+    }
+
+    /**
+     * Stop updating and rendering the scene and turn off the colliders in its
+     * subtree, so a warm scene can't collide with the current one.
+     */
+    void Suspend()
+    {
+        Disable();
+
+        for (const auto &child : GetChildrenByType<RenderObject>(true))
+        {
+            if (child->IsCollisionEnabled())
+            {
+                child->DisableCollider();
+
+                suspendedColliders.emplace_back(child);
+            }
+        }
+    }
+
+    /**
+     * Undo Suspend, turning back on the colliders it turned off.
+     */
+    void Resume()
+    {
+        Enable();
+
+        for (const auto &collider : suspendedColliders)
+        {
+            if (auto child = collider.lock())
+            {
+                if (!child->HasBeenMarkedForDestroy())
+                {
+                    child->EnableCollider();
+                }
+            }
+        }
+
+        suspendedColliders.clear();
+    }
+
+    /**
+     * Put an unloaded scene back in a state it can be added to the tree
+     * again, after which Start builds its subtree from scratch.
+     */
+    void ResetForReload()
+    {
+        hasStarted = false;
+        isMarkedForDestroy = false;
+
+        suspendedColliders.clear();
+    }
+
+    /**
+     * Called each time the scene becomes the current scene, including the
+     * first time after Start.
+     */
+    virtual void OnActivate() {}
+
+    /**
+     * Called when another scene becomes current and this one is kept warm or
+     * unloaded.
+     */
+    virtual void OnDeactivate() {}
+
     template <typename T> void SwitchToScene()
     {
         static_assert(std::is_base_of_v<Scene, T>,
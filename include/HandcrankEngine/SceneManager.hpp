@@ -9,8 +9,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 #include "HandcrankEngine.hpp"
 #include "Scene.hpp"
@@ -18,6 +20,25 @@
 namespace HandcrankEngine
 {
 
+/**
+ * Scenes kept warm after being switched away from. 0 unloads the outgoing
+ * scene, so coming back to it builds it from scratch.
+ */
+inline const size_t DEFAULT_MAX_WARM_SCENES = 0;
+
+struct ScenePreload
+{
+    std::shared_ptr<Scene> scene;
+    AssetPreload preload;
+};
+
+/**
+ * Switches between scenes, which go through UNLOADED, PRELOADING, WARM and
+ * ACTIVE. Every scene that isn't unloaded is a child of the manager, warm
+ * scenes are disabled so they aren't updated or rendered. Showing a warm
+ * scene only enables it, so preloading the next scene or keeping recent
+ * scenes warm makes the switch take a single frame.
+ */
 class SceneManager : public RenderObject
 {
 
@@ -25,33 +46,54 @@ class SceneManager : public RenderObject
     std::vector<std::shared_ptr<Scene>> scenes;
     std::shared_ptr<Scene> currentScene;
 
+    std::shared_ptr<Scene> loadingScene;
+
+    std::vector<ScenePreload> preloads;
+
+    /**
+     * Scenes switched away from and kept warm, most recently shown first.
+     */
+    std::vector<std::shared_ptr<Scene>> warmScenes;
+
+    size_t maxWarmScenes = DEFAULT_MAX_WARM_SCENES;
+
   public:
     using RenderObject::RenderObject;
 
     void Start() override {}
 
+    /**
+     * Switch to a scene. A warm scene is shown right away. Otherwise when the
+     * scene has an asset manifest and a game to load it with, the current
+     * scene stays up until every asset has loaded or failed.
+     *
+     * @param scene Scene to switch to.
+     */
     auto SetCurrentScene(const std::shared_ptr<Scene> &scene) -> bool
     {
         if (currentScene == scene)
         {
+            loadingScene = nullptr;
+
             return false;
         }
 
-        if (currentScene != nullptr)
+        if (scene != nullptr && scene->GetState() == SceneState::WARM)
         {
-            currentScene->Destroy();
+            return ShowScene(scene);
         }
 
-        currentScene = scene;
-
-        if (currentScene != nullptr)
+        if (scene != nullptr && game != nullptr &&
+            !scene->GetAssetManifest().IsEmpty())
         {
-            AddChildObject(currentScene);
+            Preload(scene);
+
+            loadingScene = scene;
 
             return true;
         }
 
-        return false;
+        return ShowScene(scene);
     }
 
     template <typename T> auto SetCurrentScene() -> bool
@@ -59,14 +101,9 @@ class SceneManager : public RenderObject
         static_assert(std::is_base_of_v<Scene, T>,
                       "T must be derive from Scene");
 
-        auto it =
-            std::find_if(scenes.begin(), scenes.end(),
-                         [](const std::shared_ptr<Scene> &scene)
-                         { return dynamic_cast<T *>(scene.get()) != nullptr; });
-
-        if (it != scenes.end())
+        if (auto scene = FindScene<T>())
         {
-            return SetCurrentScene(*it);
+            return SetCurrentScene(scene);
         }
 
         return false;
@@ -82,6 +119,119 @@ class SceneManager : public RenderObject
 
     auto GetCurrentScene() -> std::shared_ptr<Scene> { return currentScene; }
 
+    /**
+     * Load a scene's assets in the background and then build its subtree,
+     * leaving it warm until it's switched to. Preloaded scenes don't count
+     * towards the warm scene limit until they have been shown.
+     *
+     * @param scene Scene to preload.
+     */
+    auto Preload(const std::shared_ptr<Scene> &scene) -> bool
+    {
+        if (scene == nullptr || game == nullptr)
+        {
+            return false;
+        }
+
+        if (scene->GetState() != SceneState::UNLOADED)
+        {
+            return true;
+        }
+
+        MountScene(scene);
+
+        if (scene->GetAssetManifest().IsEmpty())
+        {
+            WarmScene(scene);
+        }
+        else
+        {
+            scene->SetState(SceneState::PRELOADING);
+
+            preloads.emplace_back(ScenePreload{
+                scene,
+                game->GetAssetLoader().Preload(scene->GetAssetManifest())});
+        }
+
+        return true;
+    }
+
+    template <typename T> auto Preload() -> bool
+    {
+        static_assert(std::is_base_of_v<Scene, T>,
+                      "T must be derive from Scene");
+
+        return Preload(FindScene<T>());
+    }
+
+    /**
+     * Destroy the subtree of a scene that isn't current and let go of it, so
+     * switching to it again builds it from scratch.
+     *
+     * @param scene Scene to unload.
+     */
+    auto Unload(const std::shared_ptr<Scene> &scene) -> bool
+    {
+        if (scene == nullptr || scene == currentScene ||
+            scene->GetState() == SceneState::UNLOADED)
+        {
+            return false;
+        }
+
+        UnloadScene(scene);
+
+        return true;
+    }
+
+    template <typename T> auto Unload() -> bool
+    {
+        static_assert(std::is_base_of_v<Scene, T>,
+                      "T must be derive from Scene");
+
+        return Unload(FindScene<T>());
+    }
+
+    /**
+     * Number of recently shown scenes to keep warm. The least recently shown
+     * scene past the limit is unloaded at the end of the next update.
+     *
+     * @param maxWarmScenes Scenes to keep warm, 0 to unload every scene when
+     * it's switched away from.
+     */
+    void SetMaxWarmScenes(size_t maxWarmScenes)
+    {
+        this->maxWarmScenes = maxWarmScenes;
+    }
+
+    [[nodiscard]] auto GetMaxWarmScenes() const -> size_t
+    {
+        return maxWarmScenes;
+    }
+
+    /**
+     * True while the next scene's assets are loading.
+     */
+    [[nodiscard]] auto IsLoadingScene() const -> bool
+    {
+        return loadingScene != nullptr;
+    }
+
+    /**
+     * Loading progress of the next scene's assets, from 0 to 1.
+     */
+    [[nodiscard]] auto GetLoadingProgress() const -> float
+    {
+        for (const auto &preload : preloads)
+        {
+            if (preload.scene == loadingScene)
+            {
+                return preload.preload.GetProgress();
+            }
+        }
+
+        return 1;
+    }
+
     void AddScene(std::shared_ptr<Scene> scene)
     {
         if (std::find(scenes.begin(), scenes.end(), scene) == scenes.end())
@@ -125,9 +275,151 @@ class SceneManager : public RenderObject
     }
 
   private:
-    void SetupCurrentScene() {}
+    template <typename T> auto FindScene() -> std::shared_ptr<Scene>
+    {
+        auto it =
+            std::find_if(scenes.begin(), scenes.end(),
+                         [](const std::shared_ptr<Scene> &scene)
+                         { return dynamic_cast<T *>(scene.get()) != nullptr; });
+
+        return it != scenes.end() ? *it : nullptr;
+    }
+
+    /**
+     * Add a scene to the tree disabled, so it's registered and can load but
+     * isn't updated or rendered.
+     */
+    void MountScene(const std::shared_ptr<Scene> &scene)
+    {
+        scene->Disable();
+
+        AddChildObject(scene);
+    }
+
+    void WarmScene(const std::shared_ptr<Scene> &scene)
+    {
+        scene->Warm();
+        scene->Suspend();
+
+        scene->SetState(SceneState::WARM);
+    }
+
+    void UnloadScene(const std::shared_ptr<Scene> &scene)
+    {
+        if (loadingScene == scene)
+        {
+            loadingScene = nullptr;
+        }
+
+        preloads.erase(std::remove_if(preloads.begin(), preloads.end(),
+                                      [&scene](const ScenePreload &preload)
+                                      { return preload.scene == scene; }),
+                       preloads.end());
+
+        warmScenes.erase(
+            std::remove(warmScenes.begin(), warmScenes.end(), scene),
+            warmScenes.end());
+
+        // Removed right away instead of at the end of the frame, so the
+        // scene can be mounted again before then.
+
+        scene->Destroy();
+        scene->DestroyChildObjects();
+        scene->OnDestroy();
+        scene->UnregisterObject();
+
+        children.erase(std::remove(children.begin(), children.end(), scene),
+                       children.end());
+
+        SetChildrenBufferAsDirty();
+
+        // Left disabled, it may still be in this frame's children buffer.
+
+        scene->ResetForReload();
+
+        scene->SetState(SceneState::UNLOADED);
+    }
+
+    auto ShowScene(const std::shared_ptr<Scene> &scene) -> bool
+    {
+        loadingScene = nullptr;
+
+        if (scene != nullptr)
+        {
+            if (scene->GetState() == SceneState::UNLOADED)
+            {
+                MountScene(scene);
+            }
 
-    void CleanupCurrentScene() {}
+            preloads.erase(std::remove_if(preloads.begin(), preloads.end(),
+                                          [&scene](const ScenePreload &preload)
+                                          { return preload.scene == scene; }),
+                           preloads.end());
+
+            warmScenes.erase(
+                std::remove(warmScenes.begin(), warmScenes.end(), scene),
+                warmScenes.end());
+        }
+
+        if (currentScene != nullptr)
+        {
+            currentScene->Suspend();
+            currentScene->SetState(SceneState::WARM);
+            currentScene->OnDeactivate();
+
+            warmScenes.insert(warmScenes.begin(), currentScene);
+        }
+
+        currentScene = scene;
+
+        if (currentScene != nullptr)
+        {
+            currentScene->Warm();
+            currentScene->Resume();
+            currentScene->SetState(SceneState::ACTIVE);
+            currentScene->OnActivate();
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void SetupCurrentScene()
+    {
+        for (size_t i = 0; i < preloads.size();)
+        {
+            if (!preloads[i].preload.IsDone())
+            {
+                i += 1;
+
+                continue;
+            }
+
+            auto scene = preloads[i].scene;
+
+            preloads.erase(preloads.begin() + static_cast<ptrdiff_t>(i));
+
+            WarmScene(scene);
+        }
+
+        if (loadingScene != nullptr &&
+            loadingScene->GetState() == SceneState::WARM)
+        {
+            ShowScene(loadingScene);
+        }
+    }
+
+    /**
+     * Unload the least recently shown warm scenes past the limit.
+     */
+    void CleanupCurrentScene()
+    {
+        while (warmScenes.size() > maxWarmScenes)
+        {
+            UnloadScene(warmScenes.back());
+        }
+    }
 };
 
 } // namespace HandcrankEngine
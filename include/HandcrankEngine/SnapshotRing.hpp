@@ -0,0 +1,150 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BinaryStream.hpp"
+#include "HandcrankEngine.hpp"
+
+namespace HandcrankEngine
+{
+
+/**
+ * Frames of history kept, enough to roll back a few frames of latency.
+ */
+inline const size_t DEFAULT_SNAPSHOT_RING_SIZE = 16;
+
+inline const size_t DEFAULT_SNAPSHOT_BUFFER_SIZE = 64 * 1024;
+
+struct Snapshot
+{
+    uint32_t frame = 0;
+
+    bool isValid = false;
+
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * Game snapshots of the last few frames, each in a buffer allocated up front
+ * and reused as the ring wraps, so saving a snapshot every frame doesn't
+ * allocate once the buffers are big enough.
+ *
+ * For rollback, save a snapshot at the start of each frame. When late input
+ * arrives for an earlier frame, restore that frame and call Game::Resimulate
+ * for each frame since, with the corrected input set through SetInputState.
+ */
+class SnapshotRing
+{
+  private:
+    std::vector<Snapshot> snapshots;
+
+    size_t bufferSize;
+
+    [[nodiscard]] auto GetSlot(uint32_t frame) const -> size_t
+    {
+        return frame % snapshots.size();
+    }
+
+  public:
+    explicit SnapshotRing(size_t size = DEFAULT_SNAPSHOT_RING_SIZE,
+                          size_t bufferSize = DEFAULT_SNAPSHOT_BUFFER_SIZE)
+        : snapshots(std::max<size_t>(size, 1)), bufferSize(bufferSize)
+    {
+        for (auto &snapshot : snapshots)
+        {
+            snapshot.bytes.reserve(bufferSize);
+        }
+    }
+
+    /**
+     * Snapshot a game, replacing the snapshot of the frame size frames ago.
+     *
+     * @param game Game to snapshot.
+     * @param frame Frame number the snapshot is of.
+     */
+    void Save(const Game &game, uint32_t frame)
+    {
+        auto &snapshot = snapshots[GetSlot(frame)];
+
+        snapshot.bytes.clear();
+
+        BinaryWriter writer(snapshot.bytes);
+
+        game.SaveSnapshot(writer);
+
+        snapshot.frame = frame;
+        snapshot.isValid = true;
+    }
+
+    /**
+     * Put a game back to a saved frame.
+     *
+     * @param game Game to restore.
+     * @param frame Frame number to go back to.
+     * @return False when the frame has already been overwritten or the game
+     * couldn't be restored, see Game::RestoreSnapshot.
+     */
+    auto Restore(Game &game, uint32_t frame) const -> bool
+    {
+        if (!Contains(frame))
+        {
+            return false;
+        }
+
+        BinaryReader reader(snapshots[GetSlot(frame)].bytes);
+
+        return game.RestoreSnapshot(reader);
+    }
+
+    [[nodiscard]] auto Contains(uint32_t frame) const -> bool
+    {
+        const auto &snapshot = snapshots[GetSlot(frame)];
+
+        return snapshot.isValid && snapshot.frame == frame;
+    }
+
+    /**
+     * Forget every snapshot, keeping the buffers.
+     */
+    void Clear()
+    {
+        for (auto &snapshot : snapshots)
+        {
+            snapshot.isValid = false;
+        }
+    }
+
+    [[nodiscard]] auto GetSize() const -> size_t { return snapshots.size(); }
+
+    /**
+     * Size in bytes of the largest snapshot held, to tune the buffer size
+     * the ring is created with.
+     */
+    [[nodiscard]] auto GetLargestSnapshotSize() const -> size_t
+    {
+        size_t largest = 0;
+
+        for (const auto &snapshot : snapshots)
+        {
+            largest = std::max(largest, snapshot.bytes.size());
+        }
+
+        return largest;
+    }
+
+    [[nodiscard]] auto GetBufferSize() const -> size_t { return bufferSize; }
+};
+
+} // namespace HandcrankEngine
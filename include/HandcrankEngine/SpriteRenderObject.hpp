@@ -37,12 +37,29 @@ class SpriteRenderObject : public ImageRenderObject
   public:
     using ImageRenderObject::ImageRenderObject;
 
+    void OnRecycle() override
+    {
+        ImageRenderObject::OnRecycle();
+
+        spriteFrames.clear();
+
+        frame = 0;
+        frameSpeed = DEFAULT_FRAME_SPEED;
+
+        isPlaying = false;
+        isLooping = true;
+
+        nextTick = 0;
+    }
+
     void Play() { isPlaying = true; }
     void PlayOnce()
     {
         frame = 0;
         isPlaying = true;
         isLooping = false;
+
+        SetRenderCacheAsDirty();
     }
     void Pause() { isPlaying = false; }
     void Resume() { isPlaying = true; }
@@ -72,6 +89,8 @@ class SpriteRenderObject : public ImageRenderObject
         if (frameIndex < spriteFramesSize)
         {
             frame = frameIndex;
+
+            SetRenderCacheAsDirty();
         }
     }
 
@@ -127,11 +146,20 @@ class SpriteRenderObject : public ImageRenderObject
 
         if (nextTick < frameSpeed)
         {
+            // Nothing to draw until the next frame is due.
+
+            if (game != nullptr)
+            {
+                game->RequestFrame(frameSpeed - nextTick);
+            }
+
             return;
         }
 
         frame += 1;
 
+        SetRenderCacheAsDirty();
+
         if (frame == spriteFramesSize)
         {
             if (!isLooping)
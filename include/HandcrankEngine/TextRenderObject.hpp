@@ -9,13 +9,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
 #include "FontCache.hpp"
+#include "GlyphAtlas.hpp"
 #include "HandcrankEngine.hpp"
+#include "TextureCache.hpp"
+#include "Utilities.hpp"
 
 namespace HandcrankEngine
 {
@@ -25,36 +30,91 @@ class TextRenderObject : public RenderObject
   protected:
     TTF_Font *font = nullptr;
 
+    std::shared_ptr<TTF_Font> fontReference;
+
     SDL_Color color{MAX_R, MAX_G, MAX_B, MAX_ALPHA};
 
-    const char *text = nullptr;
+    std::string text;
 
     SDL_Surface *textSurface = nullptr;
 
     SDL_Texture *textTexture = nullptr;
 
+    bool useGlyphAtlas = false;
+
+    std::shared_ptr<GlyphAtlas> glyphAtlas;
+
+    std::vector<float> glyphOffsets;
+
+    SDL_FPoint glyphLayoutSize = SDL_FPoint();
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    bool verticesAreDirty = true;
+
+    SDL_FRect verticesRect = SDL_FRect();
+
   public:
     using RenderObject::RenderObject;
 
-    ~TextRenderObject() override
+    ~TextRenderObject() override { FreeTextSurface(); };
+
+    void OnRecycle() override
     {
-        if (textTexture != nullptr)
-        {
-            SDL_DestroyTexture(textTexture);
-        }
+        RenderObject::OnRecycle();
 
-        if (textSurface != nullptr)
-        {
-            SDL_FreeSurface(textSurface);
-        }
-    };
+        FreeTextSurface();
+
+        font = nullptr;
+        fontReference = nullptr;
+
+        color = SDL_Color{MAX_R, MAX_G, MAX_B, MAX_ALPHA};
+
+        text.clear();
+
+        useGlyphAtlas = false;
+        glyphAtlas = nullptr;
+        glyphOffsets.clear();
+        glyphLayoutSize = SDL_FPoint();
+
+        vertices.clear();
+        indices.clear();
+
+        verticesAreDirty = true;
+        verticesRect = SDL_FRect();
+    }
 
     /**
      * Set text font.
      *
      * @param font Font value to set.
      */
-    void SetFont(TTF_Font *font) { this->font = font; }
+    void SetFont(TTF_Font *font)
+    {
+        this->font = font;
+
+        fontReference = nullptr;
+
+        glyphAtlas = nullptr;
+
+        verticesAreDirty = true;
+
+        SetRenderCacheAsDirty();
+    }
+
+    /**
+     * Set text font from a shared font, such as one from the font cache. The
+     * reference keeps the font from being evicted while in use.
+     *
+     * @param font Font value to set.
+     */
+    void SetFont(const std::shared_ptr<TTF_Font> &font)
+    {
+        SetFont(font.get());
+
+        fontReference = font;
+    }
 
     /**
      * Load font from a path.
@@ -67,7 +127,7 @@ class TextRenderObject : public RenderObject
      */
     void LoadFont(const char *path, int ptSize = DEFAULT_FONT_SIZE)
     {
-        font = LoadCachedFont(path, ptSize);
+        SetFont(LoadCachedFont(path, ptSize));
     }
 
     /**
@@ -79,7 +139,7 @@ class TextRenderObject : public RenderObject
      */
     void LoadFontRW(const void *mem, int size, int ptSize = DEFAULT_FONT_SIZE)
     {
-        font = LoadCachedFont(mem, size, ptSize);
+        SetFont(LoadCachedFont(mem, size, ptSize));
     }
 
     /**
@@ -87,14 +147,24 @@ class TextRenderObject : public RenderObject
      *
      * @param color Color value to set.
      */
-    void SetColor(const SDL_Color color) { this->color = color; }
+    void SetColor(const SDL_Color color)
+    {
+        this->color = color;
+
+        verticesAreDirty = true;
+
+        SetRenderCacheAsDirty();
+    }
+
+    [[nodiscard]] auto GetColor() const -> const SDL_Color & { return color; }
 
     /**
-     * Set text content.
+     * Set text content. Printable ASCII text is drawn from the glyph atlas of
+     * the font, anything else is rasterized into a texture.
      *
      * @param text Text value to set.
      */
-    void SetText(const char *text)
+    void SetText(const std::string &text)
     {
         if (font == nullptr)
         {
@@ -103,28 +173,23 @@ class TextRenderObject : public RenderObject
 
         this->text = text;
 
-        if (textTexture != nullptr)
-        {
-            SDL_DestroyTexture(textTexture);
-            textTexture = nullptr;
-        }
+        FreeTextSurface();
 
-        if (textSurface != nullptr)
-        {
-            SDL_FreeSurface(textSurface);
-            textSurface = nullptr;
-        }
+        SetRenderCacheAsDirty();
 
-        textSurface = TTF_RenderText_Blended(font, this->text, color);
+        useGlyphAtlas =
+            std::all_of(this->text.begin(), this->text.end(),
+                        [](char character)
+                        { return GlyphAtlas::HasGlyph(character); });
 
-        if (textSurface == nullptr)
+        if (useGlyphAtlas)
         {
-            throw std::runtime_error("ERROR! Failed to generate text surface.");
+            LayoutGlyphs();
+        }
+        else
+        {
+            RasterizeText();
         }
-
-        SetDimension(textSurface->w, textSurface->h);
-
-        textTexture = nullptr;
     }
 
     /**
@@ -132,14 +197,15 @@ class TextRenderObject : public RenderObject
      *
      * @param text Text value to set.
      */
-    void SetText(const std::string &text) { SetText(text.c_str()); }
+    void SetText(const char *text) { SetText(std::string(text)); }
 
     /**
-     * Set wrapped text content.
+     * Set wrapped text content. Wrapped text is always rasterized into a
+     * texture.
      *
      * @param text Text value to set.
      */
-    void SetWrappedText(const char *text)
+    void SetWrappedText(const std::string &text)
     {
         if (font == nullptr)
         {
@@ -148,20 +214,18 @@ class TextRenderObject : public RenderObject
 
         this->text = text;
 
-        if (textTexture != nullptr)
-        {
-            SDL_DestroyTexture(textTexture);
-            textTexture = nullptr;
-        }
+        FreeTextSurface();
+
+        SetRenderCacheAsDirty();
+
+        useGlyphAtlas = false;
 
-        if (textSurface != nullptr)
         {
-            SDL_FreeSurface(textSurface);
-            textSurface = nullptr;
-        }
+            const auto lock = LockFonts();
 
-        textSurface = TTF_RenderText_Blended_Wrapped(font, this->text, color,
-                                                     GetRect().w);
+            textSurface = TTF_RenderText_Blended_Wrapped(
+                font, this->text.c_str(), color, GetRect().w);
+        }
 
         if (textSurface == nullptr)
         {
@@ -169,8 +233,6 @@ class TextRenderObject : public RenderObject
         }
 
         SetDimension(textSurface->w, textSurface->h);
-
-        textTexture = nullptr;
     }
 
     /**
@@ -178,38 +240,200 @@ class TextRenderObject : public RenderObject
      *
      * @param text Text value to set.
      */
-    void SetWrappedText(const std::string &text)
+    void SetWrappedText(const char *text) { SetWrappedText(std::string(text)); }
+
+    [[nodiscard]] auto GetText() const -> const std::string & { return text; }
+
+    /**
+     * Render text to the scene.
+     *
+     * @param renderer A structure representing rendering state.
+     */
+    void Render(SDL_Renderer *renderer) override
     {
-        SetWrappedText(text.c_str());
+        if (!CanRender())
+        {
+            return;
+        }
+
+        auto transformedRect = GetInterpolatedTransformedRect();
+
+        if (useGlyphAtlas && glyphAtlas == nullptr)
+        {
+            const auto lock = LockFonts();
+
+            glyphAtlas = LoadCachedGlyphAtlas(renderer, font);
+
+            if (glyphAtlas == nullptr)
+            {
+                useGlyphAtlas = false;
+
+                RasterizeText();
+            }
+        }
+
+        if (useGlyphAtlas)
+        {
+            RenderGlyphs(renderer, transformedRect);
+        }
+        else
+        {
+            if (textTexture == nullptr && textSurface != nullptr)
+            {
+                textTexture =
+                    SDL_CreateTextureFromSurface(renderer, textSurface);
+            }
+
+            game->GetRenderBatch().Copy(textTexture, nullptr,
+                                        &transformedRect);
+        }
+
+        RenderObject::Render(renderer);
     }
 
-    auto GetText() -> std::string
+  protected:
+    /**
+     * Position each glyph along the baseline using the advance and kerning
+     * of the font. Doesn't need a renderer, so text can be set before the
+     * object is mounted.
+     */
+    void LayoutGlyphs()
     {
-        return text != nullptr ? std::string(text) : std::string();
+        const auto lock = LockFonts();
+
+        glyphOffsets.clear();
+
+        float x = 0;
+
+        Uint16 previous = 0;
+
+        for (const auto character : text)
+        {
+            const auto glyph =
+                static_cast<Uint16>(static_cast<unsigned char>(character));
+
+            if (previous != 0)
+            {
+                x += static_cast<float>(
+                    TTF_GetFontKerningSizeGlyphs(font, previous, glyph));
+            }
+
+            int advance = 0;
+
+            TTF_GlyphMetrics(font, glyph, nullptr, nullptr, nullptr, nullptr,
+                             &advance);
+
+            glyphOffsets.emplace_back(x);
+
+            x += static_cast<float>(advance);
+
+            previous = glyph;
+        }
+
+        glyphLayoutSize =
+            SDL_FPoint{x, static_cast<float>(TTF_FontHeight(font))};
+
+        SetDimension(glyphLayoutSize.x, glyphLayoutSize.y);
+
+        verticesAreDirty = true;
     }
 
     /**
-     * Render text to the scene.
+     * Draw the glyph quads. Vertices are only regenerated when the text or
+     * color changes and only moved when the transformed rect changes.
      *
      * @param renderer A structure representing rendering state.
+     * @param transformedRect Rect the text is drawn into.
      */
-    void Render(SDL_Renderer *renderer) override
+    void RenderGlyphs(SDL_Renderer *renderer, const SDL_FRect &transformedRect)
     {
-        if (!CanRender())
+        const auto rectChanged = transformedRect.x != verticesRect.x ||
+                                 transformedRect.y != verticesRect.y ||
+                                 transformedRect.w != verticesRect.w ||
+                                 transformedRect.h != verticesRect.h;
+
+        if (verticesAreDirty)
+        {
+            vertices.clear();
+            indices.clear();
+        }
+
+        if (verticesAreDirty || rectChanged)
+        {
+            const auto scaleX = glyphLayoutSize.x > 0
+                                    ? transformedRect.w / glyphLayoutSize.x
+                                    : 1;
+            const auto scaleY = glyphLayoutSize.y > 0
+                                    ? transformedRect.h / glyphLayoutSize.y
+                                    : 1;
+
+            for (size_t i = 0; i < glyphOffsets.size(); i += 1)
+            {
+                const auto &srcRect = glyphAtlas->GetSrcRect(text[i]);
+
+                const auto destRect =
+                    SDL_FRect{transformedRect.x + (glyphOffsets[i] * scaleX),
+                              transformedRect.y, srcRect.w * scaleX,
+                              srcRect.h * scaleY};
+
+                if (verticesAreDirty)
+                {
+                    GenerateTextureQuad(vertices, indices, destRect, srcRect,
+                                        color, glyphAtlas->GetTextureWidth(),
+                                        glyphAtlas->GetTextureHeight());
+                }
+                else
+                {
+                    UpdateTextureQuad(vertices.data() + (i * 4), destRect);
+                }
+            }
+
+            verticesRect = transformedRect;
+
+            verticesAreDirty = false;
+        }
+
+        if (indices.empty())
         {
             return;
         }
 
-        if (textTexture == nullptr && textSurface != nullptr)
+        game->GetRenderBatch().Geometry(glyphAtlas->GetTexture(),
+                                        vertices.data(),
+                                        static_cast<int>(vertices.size()),
+                                        indices.data(),
+                                        static_cast<int>(indices.size()));
+    }
+
+    void RasterizeText()
+    {
         {
-            textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
+            const auto lock = LockFonts();
+
+            textSurface = TTF_RenderText_Blended(font, text.c_str(), color);
         }
 
-        auto transformedRect = GetTransformedRect();
+        if (textSurface == nullptr)
+        {
+            throw std::runtime_error("ERROR! Failed to generate text surface.");
+        }
 
-        SDL_RenderCopyF(renderer, textTexture, nullptr, &transformedRect);
+        SetDimension(textSurface->w, textSurface->h);
+    }
 
-        RenderObject::Render(renderer);
+    void FreeTextSurface()
+    {
+        if (textTexture != nullptr)
+        {
+            DestroyTexture(textTexture);
+            textTexture = nullptr;
+        }
+
+        if (textSurface != nullptr)
+        {
+            SDL_FreeSurface(textSurface);
+            textSurface = nullptr;
+        }
     }
 };
 
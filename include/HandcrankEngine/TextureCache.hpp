@@ -9,9 +9,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <SDL.h>
 #include <SDL_image.h>
 
+#include "ResourceCache.hpp"
 #include "Utilities.hpp"
 
 namespace HandcrankEngine
@@ -19,45 +28,156 @@ namespace HandcrankEngine
 
 namespace
 {
-inline std::unordered_map<std::size_t, std::shared_ptr<SDL_Texture>>
-    textureCache =
-        std::unordered_map<std::size_t, std::shared_ptr<SDL_Texture>>();
+inline ResourceCache<SDL_Texture> textureCache = ResourceCache<SDL_Texture>();
+
+inline std::atomic<std::thread::id> renderThread = std::this_thread::get_id();
+
+inline std::mutex deferredTexturesMutex;
+
+inline std::vector<SDL_Texture *> deferredTextures;
 }
 
-struct TextureDeleter
+/**
+ * Make the calling thread the one textures are destroyed on. Game calls this
+ * when it creates its renderer.
+ */
+inline void SetRenderThread() { renderThread = std::this_thread::get_id(); }
+
+/**
+ * Destroy a texture. Called from any other thread than the render thread,
+ * such as the simulation thread, the texture is queued instead and
+ * destroyed by DestroyDeferredTextures, as a recorded frame may still draw
+ * it.
+ *
+ * @param texture A texture.
+ */
+inline void DestroyTexture(SDL_Texture *texture)
 {
-    void operator()(SDL_Texture *texture) const
+    if (texture == nullptr)
     {
-        if (texture != nullptr)
-        {
-            SDL_DestroyTexture(texture);
-        }
+        return;
+    }
+
+    if (std::this_thread::get_id() == renderThread)
+    {
+        SDL_DestroyTexture(texture);
+
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(deferredTexturesMutex);
+
+    deferredTextures.emplace_back(texture);
+}
+
+/**
+ * Destroy the textures queued by DestroyTexture. Call from the render thread
+ * once no recorded frame references them.
+ */
+inline void DestroyDeferredTextures()
+{
+    std::vector<SDL_Texture *> textures;
+
+    {
+        std::lock_guard<std::mutex> lock(deferredTexturesMutex);
+
+        textures.swap(deferredTextures);
     }
+
+    for (auto *texture : textures)
+    {
+        SDL_DestroyTexture(texture);
+    }
+}
+
+struct TextureDeleter
+{
+    void operator()(SDL_Texture *texture) const { DestroyTexture(texture); }
 };
 
-inline auto ClearTextureCache() -> void { textureCache.clear(); }
+/**
+ * Textures shared by every game in the process, keyed by renderer so games
+ * don't draw each other's textures.
+ */
+inline auto GetTextureCache() -> ResourceCache<SDL_Texture> &
+{
+    return textureCache;
+}
+
+inline auto ClearTextureCache() -> void { textureCache.Clear(); }
 
 /**
- * Load texture from a path.
+ * Approximate GPU memory used by a texture.
  *
- * @param renderer A structure representing rendering state.
- * @param path File path to texture file.
+ * @param texture A texture.
  */
-
-inline auto LoadCachedTexture(SDL_Renderer *renderer, const char *path)
-    -> SDL_Texture *
+[[nodiscard]] inline auto GetTextureBytes(SDL_Texture *texture) -> size_t
 {
-    auto cacheKey = std::hash<std::string_view>{}(std::string_view(path));
+    Uint32 format = 0;
 
-    auto match = textureCache.find(cacheKey);
+    int width = 0;
+    int height = 0;
 
-    if (match != textureCache.end())
+    if (SDL_QueryTexture(texture, &format, nullptr, &width, &height) != 0)
     {
-        return match->second.get();
+        return 0;
     }
 
-    auto *surface = IMG_Load(path);
+    return static_cast<size_t>(width) * height * SDL_BYTESPERPIXEL(format);
+}
+
+/**
+ * Cache key prefix of the textures uploaded to a renderer. Textures can only
+ * be drawn with the renderer that created them, so each renderer has its own
+ * entries.
+ *
+ * @param renderer A structure representing rendering state.
+ */
+[[nodiscard]] inline auto TextureRendererKey(SDL_Renderer *renderer)
+    -> std::string
+{
+    return "renderer:" + std::to_string(reinterpret_cast<uintptr_t>(renderer)) +
+           "|";
+}
 
+/**
+ * Drop the cached textures of a renderer, for when the renderer is destroyed.
+ *
+ * @param renderer A structure representing rendering state.
+ */
+inline auto ReleaseRendererTextures(SDL_Renderer *renderer) -> void
+{
+    const auto prefix = TextureRendererKey(renderer);
+
+    textureCache.EraseIf(
+        [&prefix](const std::string &key)
+        { return key.compare(0, prefix.size(), prefix) == 0; });
+}
+
+/**
+ * Cache key suffix for a color keyed texture.
+ *
+ * @param colorKey The color to use as the transparent color key.
+ */
+[[nodiscard]] inline auto TextureColorKeyParams(const SDL_Color colorKey)
+    -> std::string
+{
+    return "|colorKey:" + std::to_string(colorKey.r) + "," +
+           std::to_string(colorKey.g) + "," + std::to_string(colorKey.b);
+}
+
+/**
+ * Upload a surface, cache the texture and free the surface.
+ *
+ * @param renderer A structure representing rendering state.
+ * @param cacheKey Full cache key of the texture.
+ * @param surface Surface to upload.
+ */
+inline auto CacheTextureFromSurface(SDL_Renderer *renderer,
+                                    const std::string &cacheKey,
+                                    SDL_Surface *surface)
+    -> std::shared_ptr<SDL_Texture>
+{
     if (surface == nullptr)
     {
         return nullptr;
@@ -73,9 +193,44 @@ inline auto LoadCachedTexture(SDL_Renderer *renderer, const char *path)
         return nullptr;
     }
 
-    textureCache.insert_or_assign(cacheKey, texture);
+    textureCache.Insert(cacheKey, texture, GetTextureBytes(texture.get()));
 
-    return texture.get();
+    return texture;
+}
+
+/**
+ * Load an image or SVG surface from a stream, closing the stream.
+ *
+ * @param rw A read-only stream.
+ */
+inline auto LoadSurface(SDL_RWops *rw) -> SDL_Surface *
+{
+    if (rw == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (IMG_isSVG(rw) == SDL_TRUE)
+    {
+        auto *surface = IMG_LoadSVG_RW(rw);
+
+        SDL_RWclose(rw);
+
+        return surface;
+    }
+
+    return IMG_Load_RW(rw, 1);
+}
+
+/**
+ * Load an image or SVG surface from a read-only buffer.
+ *
+ * @param mem A pointer to a read-only buffer.
+ * @param size The buffer size, in bytes.
+ */
+inline auto LoadSurface(const void *mem, int size) -> SDL_Surface *
+{
+    return LoadSurface(SDL_RWFromConstMem(mem, size));
 }
 
 /**
@@ -83,21 +238,48 @@ inline auto LoadCachedTexture(SDL_Renderer *renderer, const char *path)
  *
  * @param renderer A structure representing rendering state.
  * @param path File path to texture file.
- * @param color The color to use as the transparent color key.
  */
+inline auto LoadCachedTexture(SDL_Renderer *renderer, const char *path)
+    -> std::shared_ptr<SDL_Texture>
+{
+    if (renderer == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto cacheKey = TextureRendererKey(renderer) + ResourcePathKey(path);
+
+    if (auto match = textureCache.Find(cacheKey))
+    {
+        return match;
+    }
+
+    return CacheTextureFromSurface(renderer, cacheKey, IMG_Load(path));
+}
 
+/**
+ * Load texture from a path.
+ *
+ * @param renderer A structure representing rendering state.
+ * @param path File path to texture file.
+ * @param color The color to use as the transparent color key.
+ */
 inline auto LoadCachedTransparentTexture(SDL_Renderer *renderer,
                                          const char *path,
                                          const SDL_Color colorKey)
-    -> SDL_Texture *
+    -> std::shared_ptr<SDL_Texture>
 {
-    auto cacheKey = std::hash<std::string_view>{}(std::string_view(path));
+    if (renderer == nullptr)
+    {
+        return nullptr;
+    }
 
-    auto match = textureCache.find(cacheKey);
+    const auto cacheKey = TextureRendererKey(renderer) + ResourcePathKey(path) +
+                          TextureColorKeyParams(colorKey);
 
-    if (match != textureCache.end())
+    if (auto match = textureCache.Find(cacheKey))
     {
-        return match->second.get();
+        return match;
     }
 
     auto *surface = IMG_Load(path);
@@ -111,19 +293,7 @@ inline auto LoadCachedTransparentTexture(SDL_Renderer *renderer,
         surface, SDL_TRUE,
         SDL_MapRGB(surface->format, colorKey.r, colorKey.g, colorKey.b));
 
-    auto texture = std::shared_ptr<SDL_Texture>(
-        SDL_CreateTextureFromSurface(renderer, surface), TextureDeleter{});
-
-    SDL_FreeSurface(surface);
-
-    if (texture == nullptr)
-    {
-        return nullptr;
-    }
-
-    textureCache.insert_or_assign(cacheKey, texture);
-
-    return texture.get();
+    return CacheTextureFromSurface(renderer, cacheKey, surface);
 }
 
 /**
@@ -134,40 +304,22 @@ inline auto LoadCachedTransparentTexture(SDL_Renderer *renderer,
  * @param size The buffer size, in bytes.
  */
 inline auto LoadCachedTexture(SDL_Renderer *renderer, const void *mem, int size)
-    -> SDL_Texture *
+    -> std::shared_ptr<SDL_Texture>
 {
-    auto cacheKey = MemHash(mem, size);
-
-    auto match = textureCache.find(cacheKey);
-
-    if (match != textureCache.end())
-    {
-        return match->second.get();
-    }
-
-    auto *rw = SDL_RWFromConstMem(mem, size);
-
-    auto *surface =
-        IMG_isSVG(rw) == SDL_TRUE ? IMG_LoadSVG_RW(rw) : IMG_Load_RW(rw, 1);
-
-    if (surface == nullptr)
+    if (renderer == nullptr)
     {
         return nullptr;
     }
 
-    auto texture = std::shared_ptr<SDL_Texture>(
-        SDL_CreateTextureFromSurface(renderer, surface), TextureDeleter{});
-
-    SDL_FreeSurface(surface);
+    const auto cacheKey =
+        TextureRendererKey(renderer) + ResourceMemKey(mem, size);
 
-    if (texture == nullptr)
+    if (auto match = textureCache.Find(cacheKey))
     {
-        return nullptr;
+        return match;
     }
 
-    textureCache.insert_or_assign(cacheKey, texture);
-
-    return texture.get();
+    return CacheTextureFromSurface(renderer, cacheKey, LoadSurface(mem, size));
 }
 
 /**
@@ -181,44 +333,71 @@ inline auto LoadCachedTexture(SDL_Renderer *renderer, const void *mem, int size)
 inline auto LoadCachedTransparentTexture(SDL_Renderer *renderer,
                                          const void *mem, int size,
                                          const SDL_Color colorKey)
-    -> SDL_Texture *
+    -> std::shared_ptr<SDL_Texture>
 {
-    auto cacheKey = MemHash(mem, size);
+    if (renderer == nullptr)
+    {
+        return nullptr;
+    }
 
-    auto match = textureCache.find(cacheKey);
+    const auto cacheKey = TextureRendererKey(renderer) +
+                          ResourceMemKey(mem, size) +
+                          TextureColorKeyParams(colorKey);
 
-    if (match != textureCache.end())
+    if (auto match = textureCache.Find(cacheKey))
     {
-        return match->second.get();
+        return match;
     }
 
-    auto *rw = SDL_RWFromConstMem(mem, size);
+    auto *surface = LoadSurface(mem, size);
 
-    auto *surface =
-        IMG_isSVG(rw) == SDL_TRUE ? IMG_LoadSVG_RW(rw) : IMG_Load_RW(rw, 1);
+    if (surface == nullptr)
+    {
+        return nullptr;
+    }
 
     SDL_SetColorKey(
         surface, SDL_TRUE,
         SDL_MapRGB(surface->format, colorKey.r, colorKey.g, colorKey.b));
 
-    if (surface == nullptr)
+    return CacheTextureFromSurface(renderer, cacheKey, surface);
+}
+
+/**
+ * Load texture from a stream, closing the stream. The cache key stands in for
+ * a path, so the stream is only read on a cache miss.
+ *
+ * @param renderer A structure representing rendering state.
+ * @param key Cache key of the texture, unique to the stream contents.
+ * @param rw A read-only stream, which can be nullptr when the texture is
+ * already cached.
+ */
+inline auto LoadCachedTexture(SDL_Renderer *renderer, const std::string &key,
+                              SDL_RWops *rw) -> std::shared_ptr<SDL_Texture>
+{
+    if (renderer == nullptr)
     {
+        if (rw != nullptr)
+        {
+            SDL_RWclose(rw);
+        }
+
         return nullptr;
     }
 
-    auto texture = std::shared_ptr<SDL_Texture>(
-        SDL_CreateTextureFromSurface(renderer, surface), TextureDeleter{});
+    const auto cacheKey = TextureRendererKey(renderer) + key;
 
-    SDL_FreeSurface(surface);
-
-    if (texture == nullptr)
+    if (auto match = textureCache.Find(cacheKey))
     {
-        return nullptr;
-    }
+        if (rw != nullptr)
+        {
+            SDL_RWclose(rw);
+        }
 
-    textureCache.insert_or_assign(cacheKey, texture);
+        return match;
+    }
 
-    return texture.get();
+    return CacheTextureFromSurface(renderer, cacheKey, LoadSurface(rw));
 }
 
 } // namespace HandcrankEngine
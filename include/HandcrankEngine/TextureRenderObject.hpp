@@ -23,12 +23,25 @@ class TextureRenderObject : public RenderObject
   protected:
     SDL_Texture *texture = nullptr;
 
+    std::shared_ptr<SDL_Texture> textureReference;
+
     int textureWidth = 0;
     int textureHeight = 0;
 
   public:
     using RenderObject::RenderObject;
 
+    void OnRecycle() override
+    {
+        RenderObject::OnRecycle();
+
+        texture = nullptr;
+        textureReference = nullptr;
+
+        textureWidth = 0;
+        textureHeight = 0;
+    }
+
     /**
      * Set texture from an existing texture reference.
      *
@@ -38,6 +51,27 @@ class TextureRenderObject : public RenderObject
     {
         this->texture = texture;
 
+        textureReference = nullptr;
+
+        SetRenderCacheAsDirty();
+
+        UpdateRectSizeFromTexture();
+    }
+
+    /**
+     * Set texture from a shared texture, such as one from the texture cache.
+     * The reference keeps the texture from being evicted while in use.
+     *
+     * @param texture A texture.
+     */
+    void SetTexture(const std::shared_ptr<SDL_Texture> &texture)
+    {
+        this->texture = texture.get();
+
+        textureReference = texture;
+
+        SetRenderCacheAsDirty();
+
         UpdateRectSizeFromTexture();
     }
 
@@ -49,9 +83,7 @@ class TextureRenderObject : public RenderObject
      */
     void LoadTexture(SDL_Renderer *renderer, const char *path)
     {
-        texture = LoadCachedTexture(renderer, path);
-
-        UpdateRectSizeFromTexture();
+        SetTexture(LoadCachedTexture(renderer, path));
     }
 
     /**
@@ -64,9 +96,7 @@ class TextureRenderObject : public RenderObject
     void LoadTransparentTexture(SDL_Renderer *renderer, const char *path,
                                 const SDL_Color colorKey)
     {
-        texture = LoadCachedTransparentTexture(renderer, path, colorKey);
-
-        UpdateRectSizeFromTexture();
+        SetTexture(LoadCachedTransparentTexture(renderer, path, colorKey));
     }
 
     /**
@@ -78,9 +108,7 @@ class TextureRenderObject : public RenderObject
      */
     void LoadTexture(SDL_Renderer *renderer, const void *mem, int size)
     {
-        texture = LoadCachedTexture(renderer, mem, size);
-
-        UpdateRectSizeFromTexture();
+        SetTexture(LoadCachedTexture(renderer, mem, size));
     }
 
     /**
@@ -94,9 +122,7 @@ class TextureRenderObject : public RenderObject
     void LoadTransparentTexture(SDL_Renderer *renderer, const void *mem,
                                 int size, const SDL_Color colorKey)
     {
-        texture = LoadCachedTransparentTexture(renderer, mem, size, colorKey);
-
-        UpdateRectSizeFromTexture();
+        SetTexture(LoadCachedTransparentTexture(renderer, mem, size, colorKey));
     }
 
     /**
@@ -107,9 +133,8 @@ class TextureRenderObject : public RenderObject
      */
     void LoadSVGString(SDL_Renderer *renderer, const std::string &content)
     {
-        texture = LoadCachedTexture(renderer, content.c_str(), content.size());
-
-        UpdateRectSizeFromTexture();
+        SetTexture(
+            LoadCachedTexture(renderer, content.c_str(), content.size()));
     }
 
     void UpdateRectSizeFromTexture()
@@ -0,0 +1,310 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <SDL.h>
+
+namespace HandcrankEngine
+{
+
+inline const int32_t NO_TRANSFORM_INDEX = -1;
+
+/**
+ * Local rects, world rects and bounding boxes of every object in a game, kept
+ * in contiguous arrays in parent-before-child order. Each object's subtree is
+ * the range from its own index to its subtree end, so moving an object only
+ * widens a dirty range and the world rects are brought up to date with one
+ * forward pass over it, reading each parent's world rect from an index that
+ * was already visited. Bounding boxes are merged with one backward pass over
+ * the top-level trees the dirty range touches.
+ *
+ * The store is rebuilt from the scene graph once a frame when objects were
+ * added or removed. Removed objects keep their slot until then, and objects
+ * added since fall back to resolving their transforms from their parents.
+ */
+class TransformStore
+{
+  private:
+    std::vector<SDL_FRect> localRects;
+    std::vector<float> scales;
+    std::vector<SDL_FRect> worldRects;
+    std::vector<SDL_FRect> boundingBoxes;
+
+    std::vector<int32_t> parents;
+    std::vector<int32_t> roots;
+    std::vector<int32_t> subtreeEnds;
+
+    std::vector<uint8_t> isEnabled;
+    std::vector<uint8_t> isAlive;
+
+    int32_t worldDirtyBegin = 0;
+    int32_t worldDirtyEnd = 0;
+
+    int32_t boundingBoxDirtyBegin = 0;
+    int32_t boundingBoxDirtyEnd = 0;
+
+    bool structureIsDirty = true;
+
+    [[nodiscard]] auto Size() const -> int32_t
+    {
+        return static_cast<int32_t>(localRects.size());
+    }
+
+    static void Merge(SDL_FRect &boundingBox, const SDL_FRect &other)
+    {
+        const auto right = fmaxf(boundingBox.x + boundingBox.w,
+                                 other.x + other.w);
+        const auto bottom = fmaxf(boundingBox.y + boundingBox.h,
+                                  other.y + other.h);
+
+        boundingBox.x = fminf(boundingBox.x, other.x);
+        boundingBox.y = fminf(boundingBox.y, other.y);
+
+        boundingBox.w = right - boundingBox.x;
+        boundingBox.h = bottom - boundingBox.y;
+    }
+
+  public:
+    [[nodiscard]] auto IsStructureDirty() const -> bool
+    {
+        return structureIsDirty;
+    }
+
+    void SetStructureAsDirty() { structureIsDirty = true; }
+
+    /**
+     * Empty the store ahead of a rebuild. Capacity is kept, so rebuilding a
+     * scene graph of the same size doesn't allocate.
+     */
+    void Clear()
+    {
+        localRects.clear();
+        scales.clear();
+        worldRects.clear();
+        boundingBoxes.clear();
+
+        parents.clear();
+        roots.clear();
+        subtreeEnds.clear();
+
+        isEnabled.clear();
+        isAlive.clear();
+    }
+
+    /**
+     * Append an object during a rebuild. Objects have to be added in
+     * parent-before-child order, followed by EndSubtree once all of their
+     * children have been added.
+     *
+     * @param parent Index of the parent, or NO_TRANSFORM_INDEX.
+     * @param localRect Rect with scale and anchor applied, before the parent.
+     * @param scale Scale of the object, applied to its children.
+     * @param enabled Whether the object counts towards its parent's bounds.
+     */
+    auto Add(int32_t parent, const SDL_FRect &localRect, float scale,
+             bool enabled) -> int32_t
+    {
+        const auto index = Size();
+
+        localRects.emplace_back(localRect);
+        scales.emplace_back(scale);
+        worldRects.emplace_back(localRect);
+        boundingBoxes.emplace_back(localRect);
+
+        parents.emplace_back(parent);
+        roots.emplace_back(parent == NO_TRANSFORM_INDEX ? index
+                                                        : roots[parent]);
+        subtreeEnds.emplace_back(index + 1);
+
+        isEnabled.emplace_back(enabled ? 1 : 0);
+        isAlive.emplace_back(1);
+
+        return index;
+    }
+
+    void EndSubtree(int32_t index) { subtreeEnds[index] = Size(); }
+
+    /**
+     * Finish a rebuild, marking everything dirty for the next Update.
+     */
+    void EndRebuild()
+    {
+        worldDirtyBegin = 0;
+        worldDirtyEnd = Size();
+
+        boundingBoxDirtyBegin = 0;
+        boundingBoxDirtyEnd = Size();
+
+        structureIsDirty = false;
+    }
+
+    void SetLocalRect(int32_t index, const SDL_FRect &localRect, float scale)
+    {
+        localRects[index] = localRect;
+        scales[index] = scale;
+
+        MarkDirty(index);
+    }
+
+    void SetEnabled(int32_t index, bool enabled)
+    {
+        isEnabled[index] = enabled ? 1 : 0;
+
+        MarkBoundingBoxDirty(index);
+    }
+
+    /**
+     * Flag the world rects of an object and its subtree for the next pass.
+     *
+     * @param index Index of the object.
+     */
+    void MarkDirty(int32_t index)
+    {
+        if (worldDirtyBegin == worldDirtyEnd)
+        {
+            worldDirtyBegin = index;
+            worldDirtyEnd = subtreeEnds[index];
+
+            return;
+        }
+
+        worldDirtyBegin = std::min(worldDirtyBegin, index);
+        worldDirtyEnd = std::max(worldDirtyEnd, subtreeEnds[index]);
+    }
+
+    void MarkBoundingBoxDirty(int32_t index)
+    {
+        if (boundingBoxDirtyBegin == boundingBoxDirtyEnd)
+        {
+            boundingBoxDirtyBegin = index;
+            boundingBoxDirtyEnd = index + 1;
+
+            return;
+        }
+
+        boundingBoxDirtyBegin = std::min(boundingBoxDirtyBegin, index);
+        boundingBoxDirtyEnd = std::max(boundingBoxDirtyEnd, index + 1);
+    }
+
+    /**
+     * Drop an object that left the scene graph. Its slot stays until the
+     * next rebuild so the indices of other objects don't move.
+     *
+     * @param index Index of the object.
+     */
+    void Remove(int32_t index)
+    {
+        isAlive[index] = 0;
+
+        if (parents[index] != NO_TRANSFORM_INDEX)
+        {
+            MarkBoundingBoxDirty(parents[index]);
+        }
+
+        structureIsDirty = true;
+    }
+
+    [[nodiscard]] auto GetWorldRect(int32_t index) -> const SDL_FRect &
+    {
+        if (index >= worldDirtyBegin && index < worldDirtyEnd)
+        {
+            UpdateWorldRects();
+        }
+
+        return worldRects[index];
+    }
+
+    [[nodiscard]] auto GetBoundingBox(int32_t index) -> const SDL_FRect &
+    {
+        UpdateWorldRects();
+        UpdateBoundingBoxes();
+
+        return boundingBoxes[index];
+    }
+
+    void UpdateWorldRects()
+    {
+        if (worldDirtyBegin == worldDirtyEnd)
+        {
+            return;
+        }
+
+        for (auto i = worldDirtyBegin; i < worldDirtyEnd; i += 1)
+        {
+            auto worldRect = localRects[i];
+
+            const auto parent = parents[i];
+
+            if (parent != NO_TRANSFORM_INDEX)
+            {
+                worldRect.x += worldRects[parent].x;
+                worldRect.y += worldRects[parent].y;
+
+                worldRect.w *= scales[parent];
+                worldRect.h *= scales[parent];
+            }
+
+            worldRects[i] = worldRect;
+        }
+
+        MarkBoundingBoxDirty(worldDirtyBegin);
+        MarkBoundingBoxDirty(worldDirtyEnd - 1);
+
+        worldDirtyBegin = worldDirtyEnd = 0;
+    }
+
+    void UpdateBoundingBoxes()
+    {
+        if (boundingBoxDirtyBegin == boundingBoxDirtyEnd)
+        {
+            return;
+        }
+
+        const auto begin = roots[boundingBoxDirtyBegin];
+        const auto end = subtreeEnds[roots[boundingBoxDirtyEnd - 1]];
+
+        std::copy(worldRects.begin() + begin, worldRects.begin() + end,
+                  boundingBoxes.begin() + begin);
+
+        // Children come after their parents, so walking backwards merges
+        // every subtree into its root before the root is merged upwards.
+
+        for (auto i = end; i > begin; i -= 1)
+        {
+            const auto index = i - 1;
+
+            const auto parent = parents[index];
+
+            if (parent != NO_TRANSFORM_INDEX && isAlive[index] != 0 &&
+                isEnabled[index] != 0)
+            {
+                Merge(boundingBoxes[parent], boundingBoxes[index]);
+            }
+        }
+
+        boundingBoxDirtyBegin = boundingBoxDirtyEnd = 0;
+    }
+
+    /**
+     * Bring every world rect and bounding box up to date.
+     */
+    void Update()
+    {
+        UpdateWorldRects();
+        UpdateBoundingBoxes();
+    }
+};
+
+} // namespace HandcrankEngine
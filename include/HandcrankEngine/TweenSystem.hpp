@@ -0,0 +1,858 @@
+// Handcrank Engine - https://handcrankengine.com/
+//
+// ░█░█░█▀█░█▀█░█▀▄░█▀▀░█▀▄░█▀█░█▀█░█░█░░░█▀▀░█▀█░█▀▀░▀█▀░█▀█░█▀▀
+// ░█▀█░█▀█░█░█░█░█░█░░░█▀▄░█▀█░█░█░█▀▄░░░█▀▀░█░█░█░█░░█░░█░█░█▀▀
+// ░▀░▀░▀░▀░▀░▀░▀▀░░▀▀▀░▀░▀░▀░▀░▀░▀░▀░▀░░░▀▀▀░▀░▀░▀▀▀░▀▀▀░▀░▀░▀▀▀
+//
+// Copyright (c) Scott Doxey. All Rights Reserved. Licensed under the MIT
+// License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "HandcrankEngine.hpp"
+#include "ImageRenderObject.hpp"
+#include "RectRenderObject.hpp"
+#include "TextRenderObject.hpp"
+#include "Vector2.hpp"
+
+namespace HandcrankEngine
+{
+
+inline const size_t DEFAULT_TWEEN_CAPACITY = 256;
+
+inline const size_t EASE_TABLE_STEPS = 256;
+
+enum class Ease : uint8_t
+{
+    LINEAR,
+    IN_QUAD,
+    OUT_QUAD,
+    IN_OUT_QUAD,
+    IN_CUBIC,
+    OUT_CUBIC,
+    IN_OUT_CUBIC,
+    IN_BACK,
+    OUT_BACK,
+    OUT_BOUNCE
+};
+
+enum class TweenMode : uint8_t
+{
+    PARALLEL,
+    SEQUENCE
+};
+
+using TweenHandle = uint32_t;
+
+inline const TweenHandle NO_TWEEN = 0;
+
+/**
+ * Evaluate an easing curve at t, from 0 to 1.
+ */
+template <Ease ease>
+[[nodiscard]] constexpr auto EaseValue(float t) -> float
+{
+    const auto back = 1.70158F;
+
+    if constexpr (ease == Ease::IN_QUAD)
+    {
+        return t * t;
+    }
+    else if constexpr (ease == Ease::OUT_QUAD)
+    {
+        return 1 - ((1 - t) * (1 - t));
+    }
+    else if constexpr (ease == Ease::IN_OUT_QUAD)
+    {
+        return t < 0.5F ? 2 * t * t : 1 - (2 * (1 - t) * (1 - t));
+    }
+    else if constexpr (ease == Ease::IN_CUBIC)
+    {
+        return t * t * t;
+    }
+    else if constexpr (ease == Ease::OUT_CUBIC)
+    {
+        return 1 - ((1 - t) * (1 - t) * (1 - t));
+    }
+    else if constexpr (ease == Ease::IN_OUT_CUBIC)
+    {
+        return t < 0.5F ? 4 * t * t * t
+                        : 1 - (4 * (1 - t) * (1 - t) * (1 - t));
+    }
+    else if constexpr (ease == Ease::IN_BACK)
+    {
+        return ((back + 1) * t * t * t) - (back * t * t);
+    }
+    else if constexpr (ease == Ease::OUT_BACK)
+    {
+        const auto u = t - 1;
+
+        return 1 + ((back + 1) * u * u * u) + (back * u * u);
+    }
+    else if constexpr (ease == Ease::OUT_BOUNCE)
+    {
+        const auto n = 7.5625F;
+        const auto d = 2.75F;
+
+        if (t < 1 / d)
+        {
+            return n * t * t;
+        }
+
+        if (t < 2 / d)
+        {
+            t -= 1.5F / d;
+
+            return (n * t * t) + 0.75F;
+        }
+
+        if (t < 2.5F / d)
+        {
+            t -= 2.25F / d;
+
+            return (n * t * t) + 0.9375F;
+        }
+
+        t -= 2.625F / d;
+
+        return (n * t * t) + 0.984375F;
+    }
+    else
+    {
+        return t;
+    }
+}
+
+template <Ease ease>
+[[nodiscard]] constexpr auto BuildEaseTable()
+    -> std::array<float, EASE_TABLE_STEPS + 1>
+{
+    std::array<float, EASE_TABLE_STEPS + 1> table{};
+
+    for (size_t i = 0; i <= EASE_TABLE_STEPS; i += 1)
+    {
+        table[i] = EaseValue<ease>(static_cast<float>(i) / EASE_TABLE_STEPS);
+    }
+
+    return table;
+}
+
+/**
+ * An easing curve sampled at compile time, so every tween is eased the same
+ * way in the update loop no matter which curve it uses.
+ */
+template <Ease ease>
+inline constexpr std::array<float, EASE_TABLE_STEPS + 1> EASE_TABLE =
+    BuildEaseTable<ease>();
+
+/**
+ * Look up an eased value, interpolating between table samples.
+ *
+ * @param table Table from EASE_TABLE.
+ * @param t Progress from 0 to 1.
+ */
+[[nodiscard]] inline auto SampleEase(const float *table, float t) -> float
+{
+    const auto position = t * EASE_TABLE_STEPS;
+
+    const auto index = std::min(static_cast<size_t>(position),
+                                EASE_TABLE_STEPS - 1);
+
+    return Lerp(table[index], table[index + 1],
+                position - static_cast<float>(index));
+}
+
+enum class TweenColorTarget : uint8_t
+{
+    IMAGE,
+    RECT,
+    TEXT
+};
+
+template <typename T>
+[[nodiscard]] constexpr auto GetTweenColorTarget() -> TweenColorTarget
+{
+    static_assert(std::is_base_of_v<ImageRenderObject, T> ||
+                      std::is_base_of_v<RectRenderObject, T> ||
+                      std::is_base_of_v<TextRenderObject, T>,
+                  "Color tweens need an image, rect or text object");
+
+    if constexpr (std::is_base_of_v<ImageRenderObject, T>)
+    {
+        return TweenColorTarget::IMAGE;
+    }
+    else if constexpr (std::is_base_of_v<RectRenderObject, T>)
+    {
+        return TweenColorTarget::RECT;
+    }
+    else
+    {
+        return TweenColorTarget::TEXT;
+    }
+}
+
+/**
+ * Active tweens of one property, kept structure-of-arrays. Finished tweens
+ * are swapped with the last one, so once the arrays have grown to the most
+ * tweens alive at once, adding and finishing tweens doesn't allocate.
+ */
+template <typename Value>
+struct TweenTrack
+{
+    std::vector<std::shared_ptr<RenderObject>> targets;
+
+    /** Which setters color and alpha tweens go through. */
+    std::vector<TweenColorTarget> kinds;
+
+    std::vector<Value> from;
+    std::vector<Value> to;
+
+    std::vector<float> elapsed;
+    std::vector<float> delays;
+    std::vector<float> durations;
+
+    std::vector<const float *> eases;
+
+    std::vector<TweenHandle> handles;
+
+    std::vector<uint8_t> isStarted;
+
+    /** Eased progress this frame, or a negative value before the delay. */
+    std::vector<float> progress;
+
+    [[nodiscard]] auto Size() const -> size_t { return handles.size(); }
+
+    void Reserve(size_t capacity)
+    {
+        targets.reserve(capacity);
+        kinds.reserve(capacity);
+        from.reserve(capacity);
+        to.reserve(capacity);
+        elapsed.reserve(capacity);
+        delays.reserve(capacity);
+        durations.reserve(capacity);
+        eases.reserve(capacity);
+        handles.reserve(capacity);
+        isStarted.reserve(capacity);
+        progress.reserve(capacity);
+    }
+
+    void Add(TweenHandle handle, const std::shared_ptr<RenderObject> &target,
+             const Value &value, float duration, float delay,
+             const float *ease, TweenColorTarget kind = TweenColorTarget())
+    {
+        targets.emplace_back(target);
+        kinds.emplace_back(kind);
+        from.emplace_back(value);
+        to.emplace_back(value);
+        elapsed.emplace_back(0.0F);
+        delays.emplace_back(delay);
+        durations.emplace_back(duration);
+        eases.emplace_back(ease);
+        handles.emplace_back(handle);
+        isStarted.emplace_back(0);
+        progress.emplace_back(-1.0F);
+    }
+
+    void Remove(size_t index)
+    {
+        const auto last = Size() - 1;
+
+        if (index != last)
+        {
+            targets[index] = std::move(targets[last]);
+            kinds[index] = kinds[last];
+            from[index] = from[last];
+            to[index] = to[last];
+            elapsed[index] = elapsed[last];
+            delays[index] = delays[last];
+            durations[index] = durations[last];
+            eases[index] = eases[last];
+            handles[index] = handles[last];
+            isStarted[index] = isStarted[last];
+            progress[index] = progress[last];
+        }
+
+        targets.pop_back();
+        kinds.pop_back();
+        from.pop_back();
+        to.pop_back();
+        elapsed.pop_back();
+        delays.pop_back();
+        durations.pop_back();
+        eases.pop_back();
+        handles.pop_back();
+        isStarted.pop_back();
+        progress.pop_back();
+    }
+
+    /**
+     * Advance every tween and work out its eased progress. Kept free of
+     * calls into the targets so it stays a straight loop over floats.
+     *
+     * @param deltaTime Seconds since the last update.
+     */
+    void Advance(float deltaTime)
+    {
+        const auto count = Size();
+
+        for (size_t i = 0; i < count; i += 1)
+        {
+            elapsed[i] += deltaTime;
+
+            const auto active = elapsed[i] - delays[i];
+
+            const auto t =
+                durations[i] > 0 ? std::clamp(active / durations[i], 0.0F, 1.0F)
+                                 : 1.0F;
+
+            progress[i] = active < 0 ? -1.0F : SampleEase(eases[i], t);
+        }
+    }
+
+    [[nodiscard]] auto IsFinished(size_t index) const -> bool
+    {
+        return elapsed[index] >= delays[index] + durations[index];
+    }
+
+    void Clear()
+    {
+        targets.clear();
+        kinds.clear();
+        from.clear();
+        to.clear();
+        elapsed.clear();
+        delays.clear();
+        durations.clear();
+        eases.clear();
+        handles.clear();
+        isStarted.clear();
+        progress.clear();
+    }
+};
+
+class TweenSystem;
+
+/**
+ * Builds a group of tweens that run one after another or all at once, the
+ * same way Animator::Mode does, by working out the delay of each tween as it
+ * is added.
+ */
+class TweenChain
+{
+  private:
+    TweenSystem *system;
+
+    TweenMode mode;
+
+    double start = 0;
+    double end = 0;
+
+    auto Next(double duration) -> double
+    {
+        const auto delay = mode == TweenMode::SEQUENCE ? end : start;
+
+        end = std::max(end, delay + duration);
+
+        return delay;
+    }
+
+  public:
+    TweenChain(TweenSystem *system, TweenMode mode, double delay)
+        : system(system), mode(mode), start(delay), end(delay)
+    {
+    }
+
+    /**
+     * Wait before the next tween in a sequence, or make a parallel group
+     * last at least this long.
+     *
+     * @param seconds Length of the delay.
+     */
+    auto Delay(double seconds) -> TweenChain &
+    {
+        Next(seconds);
+
+        return *this;
+    }
+
+    /**
+     * Start a new group once everything added so far has finished.
+     *
+     * @param mode How the tweens of the new group run.
+     */
+    auto Then(TweenMode mode) -> TweenChain &
+    {
+        this->mode = mode;
+
+        start = end;
+
+        return *this;
+    }
+
+    [[nodiscard]] auto GetDuration() const -> double { return end; }
+
+    template <Ease ease = Ease::LINEAR, typename T>
+    inline auto Move(const std::shared_ptr<T> &target, const Vector2 &to,
+                     double duration) -> TweenChain &;
+
+    template <Ease ease = Ease::LINEAR, typename T>
+    inline auto Scale(const std::shared_ptr<T> &target, float to,
+                      double duration) -> TweenChain &;
+
+    template <Ease ease = Ease::LINEAR, typename T>
+    inline auto Color(const std::shared_ptr<T> &target, const SDL_Color &to,
+                      double duration) -> TweenChain &;
+
+    template <Ease ease = Ease::LINEAR, typename T>
+    inline auto Fade(const std::shared_ptr<T> &target, Uint8 to,
+                     double duration) -> TweenChain &;
+};
+
+/**
+ * Runs every position, scale, color and alpha tween of a game in one pass
+ * per frame. Tweens are plain data in one track per property instead of an
+ * object and closure each, and the easing curve of each is picked at compile
+ * time from a precomputed table. Get it with game->GetSystem<TweenSystem>().
+ *
+ * A tween starts from whatever value the property has once its delay is
+ * over, so tweens of the same property can be chained. Each tween keeps its
+ * target alive until it finishes or is cancelled.
+ */
+class TweenSystem : public GameSystem
+{
+  private:
+    TweenTrack<Vector2> positions;
+    TweenTrack<float> scales;
+    TweenTrack<SDL_Color> colors;
+    TweenTrack<float> alphas;
+
+    TweenHandle nextHandle = NO_TWEEN;
+
+    auto NextHandle() -> TweenHandle
+    {
+        nextHandle += 1;
+
+        if (nextHandle == NO_TWEEN)
+        {
+            nextHandle += 1;
+        }
+
+        return nextHandle;
+    }
+
+    [[nodiscard]] static auto ReadColor(RenderObject *target,
+                                        TweenColorTarget kind) -> SDL_Color
+    {
+        switch (kind)
+        {
+        case TweenColorTarget::IMAGE:
+        {
+            auto *image = static_cast<ImageRenderObject *>(target);
+
+            auto color = image->GetTintColor();
+
+            color.a = static_cast<Uint8>(image->GetAlpha());
+
+            return color;
+        }
+        case TweenColorTarget::RECT:
+            return static_cast<RectRenderObject *>(target)->GetFillColor();
+        case TweenColorTarget::TEXT:
+            return static_cast<TextRenderObject *>(target)->GetColor();
+        }
+
+        return SDL_Color();
+    }
+
+    static void WriteColor(RenderObject *target, TweenColorTarget kind,
+                           const SDL_Color &color)
+    {
+        switch (kind)
+        {
+        case TweenColorTarget::IMAGE:
+        {
+            auto *image = static_cast<ImageRenderObject *>(target);
+
+            image->SetTintColor(color);
+            image->SetAlpha(color.a);
+
+            break;
+        }
+        case TweenColorTarget::RECT:
+            static_cast<RectRenderObject *>(target)->SetFillColor(color);
+            break;
+        case TweenColorTarget::TEXT:
+            static_cast<TextRenderObject *>(target)->SetColor(color);
+            break;
+        }
+    }
+
+    /**
+     * Easings that overshoot take t past 0 and 1, so each channel is clamped
+     * instead of wrapping around.
+     */
+    [[nodiscard]] static auto LerpChannel(Uint8 a, Uint8 b, float t) -> Uint8
+    {
+        return static_cast<Uint8>(
+            std::clamp(std::lround(Lerp(a, b, t)), 0L, 255L));
+    }
+
+    [[nodiscard]] static auto LerpColor(const SDL_Color &a, const SDL_Color &b,
+                                        float t) -> SDL_Color
+    {
+        return SDL_Color{LerpChannel(a.r, b.r, t), LerpChannel(a.g, b.g, t),
+                         LerpChannel(a.b, b.b, t), LerpChannel(a.a, b.a, t)};
+    }
+
+    /**
+     * Write the progress of a track to its targets and drop the tweens that
+     * finished.
+     */
+    template <typename Value, typename Read, typename Write>
+    static void Apply(TweenTrack<Value> &track, Read read, Write write)
+    {
+        size_t i = 0;
+
+        while (i < track.Size())
+        {
+            const auto t = track.progress[i];
+
+            if (t >= 0)
+            {
+                auto *target = track.targets[i].get();
+
+                if (track.isStarted[i] == 0)
+                {
+                    track.from[i] = read(target, track.kinds[i]);
+
+                    track.isStarted[i] = 1;
+                }
+
+                write(target, track.kinds[i], track.from[i], track.to[i], t);
+            }
+
+            if (track.IsFinished(i))
+            {
+                track.Remove(i);
+
+                continue;
+            }
+
+            i += 1;
+        }
+    }
+
+    template <typename Value>
+    static auto CancelHandle(TweenTrack<Value> &track, TweenHandle handle)
+        -> bool
+    {
+        for (size_t i = 0; i < track.Size(); i += 1)
+        {
+            if (track.handles[i] == handle)
+            {
+                track.Remove(i);
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template <typename Value>
+    static void CancelTarget(TweenTrack<Value> &track,
+                             const RenderObject *target)
+    {
+        size_t i = 0;
+
+        while (i < track.Size())
+        {
+            if (track.targets[i].get() == target)
+            {
+                track.Remove(i);
+
+                continue;
+            }
+
+            i += 1;
+        }
+    }
+
+    template <typename Value>
+    [[nodiscard]] static auto Contains(const TweenTrack<Value> &track,
+                                       TweenHandle handle) -> bool
+    {
+        return std::find(track.handles.begin(), track.handles.end(), handle) !=
+               track.handles.end();
+    }
+
+  public:
+    TweenSystem() { Reserve(DEFAULT_TWEEN_CAPACITY); }
+
+    /**
+     * Grow the tracks ahead of time so the first tweens don't allocate.
+     *
+     * @param capacity Most tweens of each property alive at once.
+     */
+    void Reserve(size_t capacity)
+    {
+        positions.Reserve(capacity);
+        scales.Reserve(capacity);
+        colors.Reserve(capacity);
+        alphas.Reserve(capacity);
+    }
+
+    /**
+     * Tween the position of an object.
+     *
+     * @param target Object to move.
+     * @param to Position to move to.
+     * @param duration Length of the tween in seconds.
+     * @param delay Seconds to wait before starting.
+     */
+    template <Ease ease = Ease::LINEAR, typename T>
+    auto Move(const std::shared_ptr<T> &target, const Vector2 &to,
+              double duration, double delay = 0) -> TweenHandle
+    {
+        const auto handle = NextHandle();
+
+        positions.Add(handle, target, to, static_cast<float>(duration),
+                      static_cast<float>(delay), EASE_TABLE<ease>.data());
+
+        return handle;
+    }
+
+    /**
+     * Tween the scale of an object.
+     *
+     * @param target Object to scale.
+     * @param to Scale to end at.
+     * @param duration Length of the tween in seconds.
+     * @param delay Seconds to wait before starting.
+     */
+    template <Ease ease = Ease::LINEAR, typename T>
+    auto Scale(const std::shared_ptr<T> &target, float to, double duration,
+               double delay = 0) -> TweenHandle
+    {
+        const auto handle = NextHandle();
+
+        scales.Add(handle, target, to, static_cast<float>(duration),
+                   static_cast<float>(delay), EASE_TABLE<ease>.data());
+
+        return handle;
+    }
+
+    /**
+     * Tween the tint of an image, or the color of a rect or text, including
+     * its alpha.
+     *
+     * @param target Image, rect or text object.
+     * @param to Color to end at.
+     * @param duration Length of the tween in seconds.
+     * @param delay Seconds to wait before starting.
+     */
+    template <Ease ease = Ease::LINEAR, typename T>
+    auto Color(const std::shared_ptr<T> &target, const SDL_Color &to,
+               double duration, double delay = 0) -> TweenHandle
+    {
+        const auto handle = NextHandle();
+
+        colors.Add(handle, target, to, static_cast<float>(duration),
+                   static_cast<float>(delay), EASE_TABLE<ease>.data(),
+                   GetTweenColorTarget<T>());
+
+        return handle;
+    }
+
+    /**
+     * Tween only the alpha of an image, rect or text object.
+     *
+     * @param target Image, rect or text object.
+     * @param to Alpha to end at.
+     * @param duration Length of the tween in seconds.
+     * @param delay Seconds to wait before starting.
+     */
+    template <Ease ease = Ease::LINEAR, typename T>
+    auto Fade(const std::shared_ptr<T> &target, Uint8 to, double duration,
+              double delay = 0) -> TweenHandle
+    {
+        const auto handle = NextHandle();
+
+        alphas.Add(handle, target, static_cast<float>(to),
+                   static_cast<float>(duration), static_cast<float>(delay),
+                   EASE_TABLE<ease>.data(), GetTweenColorTarget<T>());
+
+        return handle;
+    }
+
+    /**
+     * Build a group of tweens that run in sequence or in parallel.
+     *
+     * @param mode How the tweens of the group run.
+     * @param delay Seconds to wait before the group starts.
+     */
+    auto Chain(TweenMode mode, double delay = 0) -> TweenChain
+    {
+        return TweenChain(this, mode, delay);
+    }
+
+    [[nodiscard]] auto IsActive(TweenHandle handle) const -> bool
+    {
+        return Contains(positions, handle) || Contains(scales, handle) ||
+               Contains(colors, handle) || Contains(alphas, handle);
+    }
+
+    /**
+     * Stop a tween where it is.
+     *
+     * @param handle Handle returned when the tween was added.
+     */
+    auto Cancel(TweenHandle handle) -> bool
+    {
+        return CancelHandle(positions, handle) ||
+               CancelHandle(scales, handle) || CancelHandle(colors, handle) ||
+               CancelHandle(alphas, handle);
+    }
+
+    /**
+     * Stop every tween of an object where it is.
+     *
+     * @param target Object being tweened.
+     */
+    void CancelAll(const RenderObject *target)
+    {
+        CancelTarget(positions, target);
+        CancelTarget(scales, target);
+        CancelTarget(colors, target);
+        CancelTarget(alphas, target);
+    }
+
+    [[nodiscard]] auto GetActiveCount() const -> size_t
+    {
+        return positions.Size() + scales.Size() + colors.Size() +
+               alphas.Size();
+    }
+
+    void Update(double deltaTime) override
+    {
+        if (GetActiveCount() == 0)
+        {
+            return;
+        }
+
+        // Tweens move things on their own, so they keep the game awake.
+
+        if (game != nullptr)
+        {
+            game->RequestFrame();
+        }
+
+        const auto dt = static_cast<float>(deltaTime);
+
+        positions.Advance(dt);
+        scales.Advance(dt);
+        colors.Advance(dt);
+        alphas.Advance(dt);
+
+        Apply(
+            positions,
+            [](RenderObject *target, TweenColorTarget)
+            {
+                const auto &rect = target->GetRect();
+
+                return Vector2(rect.x, rect.y);
+            },
+            [](RenderObject *target, TweenColorTarget, const Vector2 &from,
+               const Vector2 &to, float t)
+            {
+                target->SetPosition(Lerp(from.x, to.x, t),
+                                    Lerp(from.y, to.y, t));
+            });
+
+        Apply(
+            scales, [](RenderObject *target, TweenColorTarget)
+            { return target->GetScale(); },
+            [](RenderObject *target, TweenColorTarget, float from, float to,
+               float t) { target->SetScale(Lerp(from, to, t)); });
+
+        Apply(colors, ReadColor,
+              [](RenderObject *target, TweenColorTarget kind,
+                 const SDL_Color &from, const SDL_Color &to, float t)
+              { WriteColor(target, kind, LerpColor(from, to, t)); });
+
+        Apply(
+            alphas,
+            [](RenderObject *target, TweenColorTarget kind)
+            { return static_cast<float>(ReadColor(target, kind).a); },
+            [](RenderObject *target, TweenColorTarget kind, float from,
+               float to, float t)
+            {
+                auto color = ReadColor(target, kind);
+
+                color.a = static_cast<Uint8>(
+                    std::clamp(std::lround(Lerp(from, to, t)), 0L, 255L));
+
+                WriteColor(target, kind, color);
+            });
+    }
+
+    void Clear() override
+    {
+        positions.Clear();
+        scales.Clear();
+        colors.Clear();
+        alphas.Clear();
+    }
+};
+
+template <Ease ease, typename T>
+inline auto TweenChain::Move(const std::shared_ptr<T> &target,
+                             const Vector2 &to, double duration)
+    -> TweenChain &
+{
+    system->Move<ease>(target, to, duration, Next(duration));
+
+    return *this;
+}
+
+template <Ease ease, typename T>
+inline auto TweenChain::Scale(const std::shared_ptr<T> &target, float to,
+                              double duration) -> TweenChain &
+{
+    system->Scale<ease>(target, to, duration, Next(duration));
+
+    return *this;
+}
+
+template <Ease ease, typename T>
+inline auto TweenChain::Color(const std::shared_ptr<T> &target,
+                              const SDL_Color &to, double duration)
+    -> TweenChain &
+{
+    system->Color<ease>(target, to, duration, Next(duration));
+
+    return *this;
+}
+
+template <Ease ease, typename T>
+inline auto TweenChain::Fade(const std::shared_ptr<T> &target, Uint8 to,
+                             double duration) -> TweenChain &
+{
+    system->Fade<ease>(target, to, duration, Next(duration));
+
+    return *this;
+}
+
+} // namespace HandcrankEngine
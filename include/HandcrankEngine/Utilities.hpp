@@ -12,6 +12,8 @@
 #include <SDL.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <random>
 #include <regex>
@@ -91,11 +93,33 @@ inline auto InverseLerp(float a, float b, float v) -> float
     return std::clamp(((v - a) / (b - a)), 0.0F, 1.0F);
 }
 
-template <typename T> inline auto RandomNumberRange(T min, T max) -> T
+/**
+ * Generator behind the random functions not given one, separate for each
+ * thread. Game code should use Game::GetRandomGenerator instead, which is
+ * saved in snapshots.
+ */
+inline auto GetRandomGenerator() -> std::mt19937 &
+{
+    thread_local std::mt19937 gen(std::random_device{}());
+
+    return gen;
+}
+
+/**
+ * Seed the calling thread's generator and rand().
+ *
+ * @param seed Seed to use.
+ */
+inline void SetRandomSeed(uint32_t seed)
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+    GetRandomGenerator().seed(seed);
 
+    srand(seed);
+}
+
+template <typename T>
+inline auto RandomNumberRange(std::mt19937 &gen, T min, T max) -> T
+{
     if constexpr (std::is_floating_point_v<T>)
     {
         std::uniform_real_distribution<T> distrib(min, max);
@@ -108,16 +132,35 @@ template <typename T> inline auto RandomNumberRange(T min, T max) -> T
     }
 }
 
+template <typename T> inline auto RandomNumberRange(T min, T max) -> T
+{
+    return RandomNumberRange(GetRandomGenerator(), min, max);
+}
+
+inline auto RandomColorRange(std::mt19937 &gen, const SDL_Color min,
+                             const SDL_Color max) -> SDL_Color
+{
+    return SDL_Color{(Uint8)RandomNumberRange(gen, min.r, max.r),
+                     (Uint8)RandomNumberRange(gen, min.g, max.g),
+                     (Uint8)RandomNumberRange(gen, min.b, max.b),
+                     (Uint8)RandomNumberRange(gen, min.a, max.a)};
+}
+
 inline auto RandomColorRange(const SDL_Color min, const SDL_Color max)
     -> SDL_Color
 {
-    return SDL_Color{(Uint8)RandomNumberRange(min.r, max.r),
-                     (Uint8)RandomNumberRange(min.g, max.g),
-                     (Uint8)RandomNumberRange(min.b, max.b),
-                     (Uint8)RandomNumberRange(min.a, max.a)};
+    return RandomColorRange(GetRandomGenerator(), min, max);
 }
 
-inline auto RandomBoolean() -> bool { return rand() > (RAND_MAX / 2); }
+inline auto RandomBoolean(std::mt19937 &gen) -> bool
+{
+    return std::bernoulli_distribution()(gen);
+}
+
+inline auto RandomBoolean() -> bool
+{
+    return RandomBoolean(GetRandomGenerator());
+}
 
 template <typename T> auto GetClassNameSimple(const T &obj) -> std::string
 {
@@ -37,10 +37,22 @@ class VertexRenderObject : public TextureRenderObject
   public:
     using TextureRenderObject::TextureRenderObject;
 
+    void OnRecycle() override
+    {
+        TextureRenderObject::OnRecycle();
+
+        vertices.clear();
+        indices.clear();
+
+        vertexRenderItems.clear();
+    }
+
     void Render(SDL_Renderer *renderer) override
     {
-        SDL_RenderGeometry(game->GetRenderer(), texture, vertices.data(),
-                           vertices.size(), indices.data(), indices.size());
+        game->GetRenderBatch().Geometry(texture, vertices.data(),
+                                        static_cast<int>(vertices.size()),
+                                        indices.data(),
+                                        static_cast<int>(indices.size()));
 
         RenderObject::Render(renderer);
     }
@@ -52,11 +64,15 @@ class VertexRenderObject : public TextureRenderObject
         GenerateTextureQuad(vertices, indices, vertexRenderItem.rect,
                             vertexRenderItem.srcRect, vertexRenderItem.color,
                             textureWidth, textureHeight);
+
+        SetRenderCacheAsDirty();
     }
 
     void UpdateVertexRenderItemPosition(int index, const SDL_FRect &position)
     {
         UpdateTextureQuad(vertices.data() + (index * 4), position);
+
+        SetRenderCacheAsDirty();
     }
 };
 
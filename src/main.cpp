@@ -1,4 +1,5 @@
 #include "HandcrankEngine/HandcrankEngine.hpp"
+#include "HandcrankEngine/ParticleEmitter.hpp"
 #include "HandcrankEngine/RectRenderObject.hpp"
 #include "HandcrankEngine/TextRenderObject.hpp"
 
@@ -8,6 +9,10 @@ using namespace HandcrankEngine;
 
 const auto size = 35;
 
+const Uint32 BALL_COLLISION_LAYER = 0x01;
+const Uint32 PADDLE_COLLISION_LAYER = 0x02;
+const Uint32 BORDER_COLLISION_LAYER = 0x04;
+
 class Scoreboard : public RenderObject
 {
   private:
@@ -66,6 +71,28 @@ class Scoreboard : public RenderObject
             rightScoreText->SetText(std::to_string(rightScore));
         }
     }
+
+    void Serialize(BinaryWriter &writer) const override
+    {
+        RenderObject::Serialize(writer);
+
+        writer.Write(leftScore);
+        writer.Write(rightScore);
+    }
+
+    void Deserialize(BinaryReader &reader) override
+    {
+        RenderObject::Deserialize(reader);
+
+        reader.Read(leftScore);
+        reader.Read(rightScore);
+
+        if (leftScoreText != nullptr && rightScoreText != nullptr)
+        {
+            leftScoreText->SetText(std::to_string(leftScore));
+            rightScoreText->SetText(std::to_string(rightScore));
+        }
+    }
 };
 
 class Ball : public RectRenderObject
@@ -85,11 +112,19 @@ class Ball : public RectRenderObject
 
     int movementSpeed = startingMovementSpeed;
 
-    double previousDeltaTime;
+    std::shared_ptr<ParticleEmitter> trail;
+    std::shared_ptr<ParticleEmitter> burst;
 
   public:
     using RectRenderObject::RectRenderObject;
 
+    void SetParticleEmitters(const std::shared_ptr<ParticleEmitter> &trail,
+                             const std::shared_ptr<ParticleEmitter> &burst)
+    {
+        this->trail = trail;
+        this->burst = burst;
+    }
+
     void Start() override
     {
         SetFillColor(MAX_R, MAX_G, MAX_B, MAX_ALPHA);
@@ -101,7 +136,9 @@ class Ball : public RectRenderObject
         maxX = game->GetWidth() - transformedRect.w;
         maxY = game->GetHeight() - transformedRect.h;
 
-        EnableCollider();
+        EnableCollider(BALL_COLLISION_LAYER,
+                       PADDLE_COLLISION_LAYER | BORDER_COLLISION_LAYER);
+        EnableContinuousCollision();
 
         Reset();
     }
@@ -133,20 +170,28 @@ class Ball : public RectRenderObject
 
         SetPosition(x, y);
 
-        previousDeltaTime = deltaTime;
+        if (trail != nullptr)
+        {
+            trail->SetRect(x, y, size, size);
+        }
     }
 
-    auto CalculateNextPosition() -> SDL_FRect
+    void OnContinuousCollision(const std::shared_ptr<RenderObject> &other,
+                               const SweptCollisionHit &hit) override
     {
-        SDL_FRect tempRect = GetRect();
+        if (other->GetCollisionLayer() != PADDLE_COLLISION_LAYER)
+        {
+            return;
+        }
 
-        tempRect.x += movementSpeed * xDirection * previousDeltaTime;
-        tempRect.y += movementSpeed * yDirection * previousDeltaTime;
+        // Move back to the point of impact so the paddle can bounce the ball
+        // instead of it ending the frame on the far side.
 
-        tempRect.x = std::clamp<float>(tempRect.x, minX, maxX);
-        tempRect.y = std::clamp<float>(tempRect.y, minY, maxY);
+        const auto &previousRect = GetPreviousTransformedRect();
+        const auto &currentRect = GetTransformedRect();
 
-        return tempRect;
+        SetPosition(Vector2::LerpUnclamped(Vector2(previousRect),
+                                           Vector2(currentRect), hit.time));
     }
 
     void ChangeDirection()
@@ -154,6 +199,33 @@ class Ball : public RectRenderObject
         xDirection = -xDirection;
 
         movementSpeed += movementSpeedStep;
+
+        if (burst != nullptr)
+        {
+            const auto &rect = GetTransformedRect();
+
+            burst->SetRect(rect.x, rect.y, rect.w, rect.h);
+            burst->SetDirection(xDirection > 0 ? 0 : 180, 120);
+            burst->Emit(300);
+        }
+    }
+
+    void Serialize(BinaryWriter &writer) const override
+    {
+        RectRenderObject::Serialize(writer);
+
+        writer.Write(xDirection);
+        writer.Write(yDirection);
+        writer.Write(movementSpeed);
+    }
+
+    void Deserialize(BinaryReader &reader) override
+    {
+        RectRenderObject::Deserialize(reader);
+
+        reader.Read(xDirection);
+        reader.Read(yDirection);
+        reader.Read(movementSpeed);
     }
 
     void Reset()
@@ -162,6 +234,8 @@ class Ball : public RectRenderObject
 
         SetPosition(maxX / 2, maxY / 2);
 
+        ClearPreviousTransformedRect();
+
         movementSpeed = startingMovementSpeed;
     }
 };
@@ -171,33 +245,30 @@ class BorderCollider : public RectRenderObject
   public:
     using RectRenderObject::RectRenderObject;
 
-    std::string tag;
-
     void Start() override
     {
         SetFillColor(0, MAX_G, 0, 0);
 
-        EnableCollider();
+        EnableCollider(BORDER_COLLISION_LAYER, BALL_COLLISION_LAYER);
     }
 
-    void OnCollision(const std::shared_ptr<RenderObject> &other) override
+    void OnCollisionEnter(const std::shared_ptr<RenderObject> &other) override
     {
-        if (auto ball = std::dynamic_pointer_cast<Ball>(other))
-        {
-            ball->Reset();
+        auto ball = std::static_pointer_cast<Ball>(other);
+
+        ball->Reset();
 
-            auto scoreboard = game->GetChildByType<Scoreboard>(true);
+        auto *scoreboard = game->FindAllByType<Scoreboard>().front();
 
-            if (scoreboard != nullptr)
+        if (scoreboard != nullptr)
+        {
+            if (GetTag() == "left")
             {
-                if (tag == "left")
-                {
-                    scoreboard->IncrementRightScore();
-                }
-                else if (tag == "right")
-                {
-                    scoreboard->IncrementLeftScore();
-                }
+                scoreboard->IncrementRightScore();
+            }
+            else if (GetTag() == "right")
+            {
+                scoreboard->IncrementLeftScore();
             }
         }
     }
@@ -208,6 +279,9 @@ class Paddle : public RectRenderObject
   protected:
     int movementSpeed = 1000;
 
+    KeyMask upKeys;
+    KeyMask downKeys;
+
   public:
     using RectRenderObject::RectRenderObject;
 
@@ -219,28 +293,7 @@ class Paddle : public RectRenderObject
 
         SetPosition(0, (game->GetHeight() / 2) - (GetRect().h / 2));
 
-        EnableCollider();
-    }
-
-    void OnCollision(const std::shared_ptr<RenderObject> &other) override
-    {
-        if (auto ball = std::dynamic_pointer_cast<Ball>(other))
-        {
-            ball->ChangeDirection();
-        }
-    }
-};
-
-class LeftPaddle : public Paddle
-{
-  public:
-    using Paddle::Paddle;
-
-    void Start() override
-    {
-        Paddle::Start();
-
-        SetPosition(size, GetRect().y);
+        EnableCollider(PADDLE_COLLISION_LAYER, BALL_COLLISION_LAYER);
     }
 
     void Update(double deltaTime) override
@@ -254,11 +307,11 @@ class LeftPaddle : public Paddle
 
         auto y = rect.y;
 
-        if (game->IsKeyDown(SDLK_w))
+        if (game->IsKeyDown(upKeys))
         {
             y -= movementSpeed * deltaTime;
         }
-        else if (game->IsKeyDown(SDLK_s))
+        else if (game->IsKeyDown(downKeys))
         {
             y += movementSpeed * deltaTime;
         }
@@ -267,6 +320,27 @@ class LeftPaddle : public Paddle
 
         SetPosition(rect.x, y);
     }
+
+    void OnCollisionEnter(const std::shared_ptr<RenderObject> &other) override
+    {
+        std::static_pointer_cast<Ball>(other)->ChangeDirection();
+    }
+};
+
+class LeftPaddle : public Paddle
+{
+  public:
+    using Paddle::Paddle;
+
+    void Start() override
+    {
+        Paddle::Start();
+
+        upKeys = MakeKeyMask({SDL_SCANCODE_W});
+        downKeys = MakeKeyMask({SDL_SCANCODE_S});
+
+        SetPosition(size, GetRect().y);
+    }
 };
 
 class RightPaddle : public Paddle
@@ -278,40 +352,59 @@ class RightPaddle : public Paddle
     {
         Paddle::Start();
 
+        upKeys = MakeKeyMask({SDL_SCANCODE_UP});
+        downKeys = MakeKeyMask({SDL_SCANCODE_DOWN});
+
         SetPosition(game->GetWidth() - GetRect().w - size, GetRect().y);
     }
+};
 
-    void Update(double deltaTime) override
+class Divider : public RenderObject
+{
+  private:
+    const float width = 5;
+    const float height = 50;
+
+  public:
+    void Start() override
     {
-        if (!game->HasFocus())
-        {
-            return;
-        }
+        SetRect(((float)game->GetWidth() / 2) - (width / 2), 0, width,
+                (float)game->GetHeight());
 
-        auto rect = GetRect();
+        EnableRenderCache();
+    }
 
-        auto y = rect.y;
+    void Render(SDL_Renderer *renderer) override
+    {
+        auto &renderBatch = game->GetRenderBatch();
 
-        if (game->IsKeyDown(SDLK_UP))
-        {
-            y -= movementSpeed * deltaTime;
-        }
-        else if (game->IsKeyDown(SDLK_DOWN))
+        renderBatch.SetBlendMode(SDL_BLENDMODE_BLEND);
+
+        const auto &transformedRect = GetTransformedRect();
+
+        for (float y = 0; y < 23; y += 1.5F)
         {
-            y += movementSpeed * deltaTime;
-        }
+            SDL_FRect tempRect = {transformedRect.x,
+                                  transformedRect.y + (y * height), width,
+                                  height};
 
-        y = std::clamp<float>(y, 0, game->GetHeight() - rect.h);
+            renderBatch.FillRect(tempRect, DEFAULT_COLOR);
+        }
 
-        SetPosition(rect.x, y);
+        RenderObject::Render(renderer);
     }
 };
 
 class GameManager : public RenderObject
 {
   private:
+    std::shared_ptr<Divider> divider;
+
     std::shared_ptr<Ball> ball;
 
+    std::shared_ptr<ParticleEmitter> trail;
+    std::shared_ptr<ParticleEmitter> burst;
+
     std::shared_ptr<LeftPaddle> leftPaddle;
     std::shared_ptr<RightPaddle> rightPaddle;
 
@@ -327,6 +420,30 @@ class GameManager : public RenderObject
 
         AddChildObject(ball);
 
+        trail = std::make_shared<ParticleEmitter>();
+        trail->SetMaxParticles(4096);
+        trail->SetEmissionRate(2000);
+        trail->SetLifetime(0.25F, 0.5F);
+        trail->SetSpeed(5, 30);
+        trail->SetParticleSize(6, 1);
+        trail->SetColor({MAX_R, MAX_G, MAX_B, 160}, {MAX_R, MAX_G, MAX_B, 220},
+                        {MAX_R, MAX_G, MAX_B, 0});
+
+        AddChildObject(trail);
+
+        burst = std::make_shared<ParticleEmitter>();
+        burst->SetMaxParticles(2048);
+        burst->SetLifetime(0.3F, 0.8F);
+        burst->SetSpeed(100, 500);
+        burst->SetDrag(3);
+        burst->SetParticleSize(5, 2);
+        burst->SetColor({MAX_R, 150, 0, MAX_ALPHA},
+                        {MAX_R, MAX_G, 100, MAX_ALPHA}, {MAX_R, 0, 0, 0});
+
+        AddChildObject(burst);
+
+        ball->SetParticleEmitters(trail, burst);
+
         leftPaddle = std::make_shared<LeftPaddle>();
         rightPaddle = std::make_shared<RightPaddle>();
 
@@ -334,10 +451,10 @@ class GameManager : public RenderObject
         AddChildObject(rightPaddle);
 
         leftBorderCollider = std::make_shared<BorderCollider>();
-        leftBorderCollider->tag = "left";
+        leftBorderCollider->SetTag("left");
 
         rightBorderCollider = std::make_shared<BorderCollider>();
-        rightBorderCollider->tag = "right";
+        rightBorderCollider->SetTag("right");
 
         leftBorderCollider->SetRect(0, 0, 10, (float)game->GetHeight());
         rightBorderCollider->SetRect((float)game->GetWidth() - 10, 0, 10,
@@ -347,8 +464,15 @@ class GameManager : public RenderObject
         AddChildObject(rightBorderCollider);
 
         scoreboard = std::make_shared<Scoreboard>();
+        scoreboard->EnableRenderCache();
 
         AddChildObject(scoreboard);
+
+        // Added last so it draws over the ball and paddles.
+
+        divider = std::make_shared<Divider>();
+
+        AddChildObject(divider);
     }
 
     void Update(double deltaTime) override
@@ -358,29 +482,11 @@ class GameManager : public RenderObject
             return;
         }
 
-        if (game->IsKeyDown(SDLK_ESCAPE))
+        if (game->IsKeyDown(SDL_SCANCODE_ESCAPE))
         {
             game->Quit();
         }
     }
-
-    void Render(SDL_Renderer *renderer) override
-    {
-        RenderObject::Render(renderer);
-
-        SDL_SetRenderDrawColor(renderer, MAX_R, MAX_G, MAX_B, MAX_ALPHA);
-
-        const float width = 5;
-        const float height = 50;
-
-        for (float y = 0; y < 23; y += 1.5F)
-        {
-            SDL_FRect tempRect = {((float)game->GetWidth() / 2) - (width / 2),
-                                  y * height, width, height};
-
-            SDL_RenderFillRectF(renderer, &tempRect);
-        }
-    }
 };
 
 auto main(int argc, char *argv[]) -> int
@@ -389,7 +495,30 @@ auto main(int argc, char *argv[]) -> int
 
     game->SetTitle("Pong Demo");
 
+    game->SetIdlePolicy(IdlePolicy::UNCHANGED);
+
     game->AddChildObject(std::move(std::make_unique<GameManager>()));
 
+    // --record PATH writes every frame of input to PATH as it's played,
+    // --replay PATH plays it back.
+
+    InputLog inputLog;
+
+    for (auto i = 1; i + 1 < argc; i += 1)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--record")
+        {
+            inputLog.SetStream(SDL_RWFromFile(argv[i + 1], "wb"));
+
+            game->RecordInput(inputLog);
+        }
+        else if (arg == "--replay" && inputLog.Load(argv[i + 1]))
+        {
+            game->ReplayInput(inputLog);
+        }
+    }
+
     return game->Run();
 }
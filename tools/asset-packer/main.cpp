@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+const uint32_t ASSET_PACK_VERSION = 1;
+
+const size_t ASSET_PACK_HEADER_SIZE = 16;
+
+const uint8_t COMPRESSION_NONE = 0;
+const uint8_t COMPRESSION_LZ4 = 1;
+
+const size_t LZ4_MIN_MATCH = 4;
+const size_t LZ4_MAX_OFFSET = 65535;
+const size_t LZ4_HASH_BITS = 16;
+
+/** Bytes at the end of a block that have to be literals. */
+const size_t LZ4_LAST_LITERALS = 5;
+
+/** A match can't start in the last bytes of a block. */
+const size_t LZ4_MATCH_LIMIT = 12;
+
+/** Compression has to save at least this much to be kept. */
+const double MIN_COMPRESSION_SAVING = 0.05;
+
+struct PackFile
+{
+    std::string name;
+    std::vector<uint8_t> bytes;
+    uint8_t compression;
+    uint64_t originalSize;
+    uint64_t offset;
+};
+
+auto Read32(const uint8_t *bytes) -> uint32_t
+{
+    uint32_t value = 0;
+
+    std::memcpy(&value, bytes, sizeof(value));
+
+    return value;
+}
+
+void WriteLength(std::vector<uint8_t> &output, size_t length)
+{
+    while (length >= 255)
+    {
+        output.push_back(255);
+
+        length -= 255;
+    }
+
+    output.push_back(static_cast<uint8_t>(length));
+}
+
+void WriteSequence(std::vector<uint8_t> &output, const uint8_t *literals,
+                   size_t literalLength, size_t offset, size_t matchLength)
+{
+    const auto matchCode = matchLength > 0 ? matchLength - LZ4_MIN_MATCH : 0;
+
+    output.push_back(
+        static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) |
+                             std::min<size_t>(matchCode, 15)));
+
+    if (literalLength >= 15)
+    {
+        WriteLength(output, literalLength - 15);
+    }
+
+    output.insert(output.end(), literals, literals + literalLength);
+
+    if (matchLength == 0)
+    {
+        return;
+    }
+
+    output.push_back(static_cast<uint8_t>(offset & 0xFF));
+    output.push_back(static_cast<uint8_t>(offset >> 8));
+
+    if (matchCode >= 15)
+    {
+        WriteLength(output, matchCode - 15);
+    }
+}
+
+/**
+ * Compress into a single LZ4 block, matching each position against the last
+ * position with the same four bytes. Decompresses with any LZ4 block decoder.
+ */
+auto CompressLZ4Block(const std::vector<uint8_t> &input) -> std::vector<uint8_t>
+{
+    std::vector<uint8_t> output;
+
+    const auto *src = input.data();
+    const auto size = input.size();
+
+    size_t anchor = 0;
+
+    if (size > LZ4_MATCH_LIMIT)
+    {
+        std::vector<int64_t> table(size_t{1} << LZ4_HASH_BITS, -1);
+
+        const auto matchLimit = size - LZ4_MATCH_LIMIT;
+        const auto matchEnd = size - LZ4_LAST_LITERALS;
+
+        size_t position = 0;
+
+        while (position < matchLimit)
+        {
+            const auto sequence = Read32(src + position);
+
+            const auto hash =
+                (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+
+            const auto candidate = table[hash];
+
+            table[hash] = static_cast<int64_t>(position);
+
+            if (candidate < 0 ||
+                position - static_cast<size_t>(candidate) > LZ4_MAX_OFFSET ||
+                Read32(src + candidate) != sequence)
+            {
+                position += 1;
+
+                continue;
+            }
+
+            const auto match = static_cast<size_t>(candidate);
+
+            auto length = LZ4_MIN_MATCH;
+
+            while (position + length < matchEnd &&
+                   src[match + length] == src[position + length])
+            {
+                length += 1;
+            }
+
+            WriteSequence(output, src + anchor, position - anchor,
+                          position - match, length);
+
+            position += length;
+
+            anchor = position;
+        }
+    }
+
+    WriteSequence(output, src + anchor, size - anchor, 0, 0);
+
+    return output;
+}
+
+void WriteLE(std::vector<uint8_t> &output, uint64_t value, size_t count)
+{
+    for (size_t i = 0; i < count; i += 1)
+    {
+        output.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+                 "Usage: asset-packer [--store] OUTPUT INPUT_DIR...\n\n"
+                 "Packs every file under each INPUT_DIR into OUTPUT, named by "
+                 "its path relative to the\ninput, e.g. "
+                 "fonts/JustMyType/JustMyType.ttf is JustMyType/JustMyType.ttf "
+                 "in the pack.\nFiles are LZ4 compressed unless it saves less "
+                 "than 5%% or --store is given.\n");
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    auto store = false;
+
+    std::vector<std::string> positional;
+
+    for (auto i = 1; i < argc; i += 1)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--store")
+        {
+            store = true;
+        }
+        else if (arg == "--help")
+        {
+            PrintUsage();
+
+            return 0;
+        }
+        else
+        {
+            positional.emplace_back(arg);
+        }
+    }
+
+    if (positional.size() < 2)
+    {
+        PrintUsage();
+
+        return 1;
+    }
+
+    std::vector<PackFile> files;
+
+    for (size_t i = 1; i < positional.size(); i += 1)
+    {
+        const fs::path inputDirectory = positional[i];
+
+        if (!fs::is_directory(inputDirectory))
+        {
+            std::fprintf(stderr, "%s is not a directory\n",
+                         inputDirectory.string().c_str());
+
+            return 1;
+        }
+
+        for (const auto &entry :
+             fs::recursive_directory_iterator(inputDirectory))
+        {
+            const auto extension = entry.path().extension().string();
+
+            // Skip the headers compile-static-assets.sh generates.
+
+            if (!entry.is_regular_file() || extension == ".h")
+            {
+                continue;
+            }
+
+            std::ifstream stream(entry.path(), std::ios::binary);
+
+            auto file = PackFile{
+                fs::relative(entry.path(), inputDirectory).generic_string(),
+                std::vector<uint8_t>(std::istreambuf_iterator<char>(stream),
+                                     std::istreambuf_iterator<char>()),
+                COMPRESSION_NONE, 0, 0};
+
+            file.originalSize = file.bytes.size();
+
+            if (!store)
+            {
+                auto compressed = CompressLZ4Block(file.bytes);
+
+                if (static_cast<double>(compressed.size()) <
+                    static_cast<double>(file.bytes.size()) *
+                        (1 - MIN_COMPRESSION_SAVING))
+                {
+                    file.bytes = std::move(compressed);
+                    file.compression = COMPRESSION_LZ4;
+                }
+            }
+
+            files.emplace_back(std::move(file));
+        }
+    }
+
+    // Sorted so the same inputs always produce the same pack.
+
+    std::sort(files.begin(), files.end(),
+              [](const PackFile &a, const PackFile &b)
+              { return a.name < b.name; });
+
+    std::vector<uint8_t> index;
+
+    for (const auto &file : files)
+    {
+        WriteLE(index, file.name.size(), 2);
+
+        index.insert(index.end(), file.name.begin(), file.name.end());
+
+        // Offsets are filled in once the size of the index is known.
+
+        index.push_back(file.compression);
+
+        WriteLE(index, 0, 8);
+        WriteLE(index, file.bytes.size(), 8);
+        WriteLE(index, file.originalSize, 8);
+    }
+
+    std::vector<uint8_t> header;
+
+    header.insert(header.end(), {'H', 'C', 'P', 'K'});
+
+    WriteLE(header, ASSET_PACK_VERSION, 4);
+    WriteLE(header, files.size(), 4);
+    WriteLE(header, index.size(), 4);
+
+    auto offset = static_cast<uint64_t>(ASSET_PACK_HEADER_SIZE + index.size());
+
+    size_t position = 0;
+
+    for (auto &file : files)
+    {
+        file.offset = offset;
+
+        offset += file.bytes.size();
+
+        position += 2 + file.name.size() + 1;
+
+        for (size_t i = 0; i < 8; i += 1)
+        {
+            index[position + i] = static_cast<uint8_t>(file.offset >> (i * 8));
+        }
+
+        position += 24;
+    }
+
+    std::ofstream output(positional[0], std::ios::binary);
+
+    output.write(reinterpret_cast<const char *>(header.data()),
+                 static_cast<std::streamsize>(header.size()));
+    output.write(reinterpret_cast<const char *>(index.data()),
+                 static_cast<std::streamsize>(index.size()));
+
+    for (const auto &file : files)
+    {
+        output.write(reinterpret_cast<const char *>(file.bytes.data()),
+                     static_cast<std::streamsize>(file.bytes.size()));
+
+        std::fprintf(stderr, "%s %s %llu -> %zu bytes\n", file.name.c_str(),
+                     file.compression == COMPRESSION_LZ4 ? "lz4" : "stored",
+                     static_cast<unsigned long long>(file.originalSize),
+                     file.bytes.size());
+    }
+
+    if (!output)
+    {
+        std::fprintf(stderr, "Failed to write %s\n", positional[0].c_str());
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,449 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+namespace fs = std::filesystem;
+
+const int DEFAULT_ATLAS_PAGE_SIZE = 2048;
+const int DEFAULT_ATLAS_PADDING = 2;
+
+struct AtlasImage
+{
+    std::string path;
+    std::string name;
+    SDL_Surface *surface;
+    int page;
+    SDL_Rect rect;
+};
+
+struct AtlasShelf
+{
+    int y;
+    int height;
+    int x;
+};
+
+struct AtlasPage
+{
+    std::vector<AtlasShelf> shelves;
+    int usedHeight;
+};
+
+/**
+ * Turn a path relative to the input directory into a C++ identifier, the
+ * same way xxd names the headers it generates.
+ */
+auto ToIdentifier(const fs::path &path) -> std::string
+{
+    auto name = path.parent_path().empty()
+                    ? path.stem().string()
+                    : (path.parent_path() / path.stem()).generic_string();
+
+    for (auto &character : name)
+    {
+        if (std::isalnum(static_cast<unsigned char>(character)) == 0)
+        {
+            character = '_';
+        }
+    }
+
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])) != 0)
+    {
+        name.insert(0, "_");
+    }
+
+    return name;
+}
+
+/**
+ * Split a trailing frame number off a name, so walk_0 and walk_1 end up in
+ * one walk_frames list.
+ */
+auto SplitFrameNumber(const std::string &name, std::string &base, int &frame)
+    -> bool
+{
+    const auto separator = name.find_last_of('_');
+
+    if (separator == std::string::npos || separator == 0 ||
+        separator == name.size() - 1)
+    {
+        return false;
+    }
+
+    const auto digits = name.substr(separator + 1);
+
+    if (!std::all_of(digits.begin(), digits.end(),
+                     [](char character)
+                     { return std::isdigit(static_cast<unsigned char>(
+                                  character)) != 0; }))
+    {
+        return false;
+    }
+
+    base = name.substr(0, separator);
+    frame = std::atoi(digits.c_str());
+
+    return true;
+}
+
+auto NextPowerOfTwo(int value) -> int
+{
+    auto result = 1;
+
+    while (result < value)
+    {
+        result *= 2;
+    }
+
+    return result;
+}
+
+/**
+ * Place an image on the first shelf with room for it, opening a new shelf
+ * below the last one when none has. Images are placed tallest first, so each
+ * shelf is only as tall as the first image on it.
+ */
+auto PlaceOnPage(AtlasPage &page, int pageSize, int width, int height,
+                 SDL_Rect &rect) -> bool
+{
+    for (auto &shelf : page.shelves)
+    {
+        if (height <= shelf.height && shelf.x + width <= pageSize)
+        {
+            rect = SDL_Rect{shelf.x, shelf.y, width, height};
+
+            shelf.x += width;
+
+            return true;
+        }
+    }
+
+    if (page.usedHeight + height > pageSize || width > pageSize)
+    {
+        return false;
+    }
+
+    page.shelves.push_back(AtlasShelf{page.usedHeight, height, width});
+
+    rect = SDL_Rect{0, page.usedHeight, width, height};
+
+    page.usedHeight += height;
+
+    return true;
+}
+
+void CollectImages(const fs::path &inputDirectory,
+                   const fs::path &outputDirectory,
+                   std::vector<AtlasImage> &images)
+{
+    for (const auto &entry : fs::recursive_directory_iterator(inputDirectory))
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+
+        const auto &path = entry.path();
+
+        const auto extension = path.extension().string();
+
+        if (extension != ".png" && extension != ".svg")
+        {
+            continue;
+        }
+
+        // Skip the pages of a previous run.
+
+        if (fs::equivalent(path.parent_path(), outputDirectory))
+        {
+            continue;
+        }
+
+        images.push_back(AtlasImage{
+            path.generic_string(),
+            ToIdentifier(fs::relative(path, inputDirectory)), nullptr, 0,
+            SDL_Rect()});
+    }
+}
+
+void WriteHeader(const fs::path &headerPath, const std::string &atlasName,
+                 const std::vector<AtlasImage> &images, int pageCount)
+{
+    std::ofstream header(headerPath);
+
+    header << "#pragma once\n\n"
+           << "// Generated by tools/atlas-packer, do not edit.\n\n"
+           << "#include <vector>\n\n"
+           << "#include <SDL.h>\n\n"
+           << "namespace " << atlasName << "\n{\n\n"
+           << "inline const int page_count = " << pageCount << ";\n";
+
+    std::map<std::string, std::map<int, const AtlasImage *>> frames;
+
+    for (const auto &image : images)
+    {
+        const auto &rect = image.rect;
+
+        header << "\n// " << image.path << "\n"
+               << "inline const int " << image.name << "_page = " << image.page
+               << ";\n"
+               << "inline const SDL_Rect " << image.name << " = {" << rect.x
+               << ", " << rect.y << ", " << rect.w << ", " << rect.h << "};\n";
+
+        std::string base;
+        int frame = 0;
+
+        if (SplitFrameNumber(image.name, base, frame))
+        {
+            frames[base][frame] = &image;
+        }
+    }
+
+    // Numbered images become frame lists for SpriteRenderObject::SetFrames,
+    // as long as every frame landed on the same page.
+
+    for (const auto &[base, sequence] : frames)
+    {
+        const auto page = sequence.begin()->second->page;
+
+        if (!std::all_of(sequence.begin(), sequence.end(),
+                         [page](const auto &frame)
+                         { return frame.second->page == page; }))
+        {
+            std::fprintf(stderr,
+                         "Warning: frames of %s are split across pages, "
+                         "no %s_frames list was generated\n",
+                         base.c_str(), base.c_str());
+
+            continue;
+        }
+
+        header << "\ninline const int " << base << "_frames_page = " << page
+               << ";\n"
+               << "inline const std::vector<SDL_Rect> " << base
+               << "_frames = {\n";
+
+        for (const auto &[frame, image] : sequence)
+        {
+            header << "    " << image->name << ",\n";
+        }
+
+        header << "};\n";
+    }
+
+    header << "\n} // namespace " << atlasName << "\n";
+}
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+                 "Usage: atlas-packer [--size N] [--padding N] [--name NAME] "
+                 "INPUT_DIR OUTPUT_DIR\n\n"
+                 "Packs every PNG and SVG under INPUT_DIR into NAME-0.png, "
+                 "NAME-1.png, ... in OUTPUT_DIR,\nalong with NAME.h listing "
+                 "the source rect of each image.\n");
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    auto pageSize = DEFAULT_ATLAS_PAGE_SIZE;
+    auto padding = DEFAULT_ATLAS_PADDING;
+
+    std::string atlasName = "atlas";
+
+    std::vector<std::string> positional;
+
+    for (auto i = 1; i < argc; i += 1)
+    {
+        const std::string arg = argv[i];
+
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == "--size" && hasValue)
+        {
+            pageSize = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (arg == "--padding" && hasValue)
+        {
+            padding = std::max(std::atoi(argv[++i]), 0);
+        }
+        else if (arg == "--name" && hasValue)
+        {
+            atlasName = argv[++i];
+        }
+        else if (arg == "--help")
+        {
+            PrintUsage();
+
+            return 0;
+        }
+        else
+        {
+            positional.emplace_back(arg);
+        }
+    }
+
+    if (positional.size() != 2)
+    {
+        PrintUsage();
+
+        return 1;
+    }
+
+    const fs::path inputDirectory = positional[0];
+    const fs::path outputDirectory = positional[1];
+
+    fs::create_directories(outputDirectory);
+
+    if (SDL_Init(0) != 0 ||
+        (IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) != IMG_INIT_PNG)
+    {
+        std::fprintf(stderr, "Failed to initialize SDL: %s\n", SDL_GetError());
+
+        return 1;
+    }
+
+    std::vector<AtlasImage> images;
+
+    CollectImages(inputDirectory, outputDirectory, images);
+
+    for (auto &image : images)
+    {
+        auto *loaded = IMG_Load(image.path.c_str());
+
+        if (loaded == nullptr)
+        {
+            std::fprintf(stderr, "Failed to load %s: %s\n", image.path.c_str(),
+                         IMG_GetError());
+
+            return 1;
+        }
+
+        image.surface =
+            SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+
+        SDL_FreeSurface(loaded);
+
+        SDL_SetSurfaceBlendMode(image.surface, SDL_BLENDMODE_NONE);
+    }
+
+    // Tallest first packs shelves tightly, names break ties so the output
+    // is the same from run to run and frames of one sprite stay together.
+
+    std::sort(images.begin(), images.end(),
+              [](const AtlasImage &a, const AtlasImage &b)
+              {
+                  if (a.surface->h != b.surface->h)
+                  {
+                      return a.surface->h > b.surface->h;
+                  }
+
+                  return a.name < b.name;
+              });
+
+    std::vector<AtlasPage> pages;
+
+    for (auto &image : images)
+    {
+        const auto width = image.surface->w + padding;
+        const auto height = image.surface->h + padding;
+
+        auto placed = false;
+
+        for (size_t i = 0; i < pages.size() && !placed; i += 1)
+        {
+            if (PlaceOnPage(pages[i], pageSize, width, height, image.rect))
+            {
+                image.page = static_cast<int>(i);
+
+                placed = true;
+            }
+        }
+
+        if (!placed)
+        {
+            pages.emplace_back();
+
+            if (!PlaceOnPage(pages.back(), pageSize, width, height,
+                             image.rect))
+            {
+                std::fprintf(stderr, "%s is larger than a %dx%d page\n",
+                             image.path.c_str(), pageSize, pageSize);
+
+                return 1;
+            }
+
+            image.page = static_cast<int>(pages.size() - 1);
+        }
+
+        image.rect.w = image.surface->w;
+        image.rect.h = image.surface->h;
+    }
+
+    for (size_t i = 0; i < pages.size(); i += 1)
+    {
+        auto usedWidth = 1;
+
+        for (const auto &shelf : pages[i].shelves)
+        {
+            usedWidth = std::max(usedWidth, shelf.x);
+        }
+
+        auto *surface = SDL_CreateRGBSurfaceWithFormat(
+            0, NextPowerOfTwo(usedWidth),
+            NextPowerOfTwo(std::max(pages[i].usedHeight, 1)), 32,
+            SDL_PIXELFORMAT_RGBA32);
+
+        SDL_FillRect(surface, nullptr, 0);
+
+        for (auto &image : images)
+        {
+            if (image.page == static_cast<int>(i))
+            {
+                SDL_BlitSurface(image.surface, nullptr, surface, &image.rect);
+            }
+        }
+
+        const auto pagePath =
+            outputDirectory / (atlasName + "-" + std::to_string(i) + ".png");
+
+        if (IMG_SavePNG(surface, pagePath.string().c_str()) != 0)
+        {
+            std::fprintf(stderr, "Failed to write %s: %s\n",
+                         pagePath.string().c_str(), IMG_GetError());
+
+            return 1;
+        }
+
+        std::fprintf(stderr, "Wrote %s (%dx%d)\n", pagePath.string().c_str(),
+                     surface->w, surface->h);
+
+        SDL_FreeSurface(surface);
+    }
+
+    std::sort(images.begin(), images.end(),
+              [](const AtlasImage &a, const AtlasImage &b)
+              { return a.name < b.name; });
+
+    WriteHeader(outputDirectory / (atlasName + ".h"), atlasName, images,
+                static_cast<int>(pages.size()));
+
+    for (auto &image : images)
+    {
+        SDL_FreeSurface(image.surface);
+    }
+
+    IMG_Quit();
+    SDL_Quit();
+
+    return 0;
+}